@@ -19,6 +19,74 @@ read_processed_dat <- function(f) {
                                  (Max_Energy_Thresh_M >= 700 & Max_Energy_Thresh_M <= 900))
 }
 
+# Read a summary tensor (SUMMARY_TENSORS in src/main.cpp, see src/SummaryTensor.hpp)
+# as one array per metric over the parameter grids, dimnames from the grid values,
+# masked cells NA. E.g. read_summary_tensor(f, "Rate_Success")$Rate_Success[, , "500", "800", "162", "47", "7", "69.7"]
+read_summary_tensor <- function(f, metrics=NULL) {
+  con <- file(f, "rb")
+  on.exit(close(con))
+  header <- character()
+  repeat {
+    line <- readLines(con, n=1)
+    if (line == "end") break
+    header <- c(header, line)
+  }
+  fields <- strsplit(header, " ")
+  keys <- sapply(fields, `[`, 1)
+  value <- function(k) fields[[which(keys == k)[1]]][2]
+
+  cells <- as.numeric(value("cells"))
+  endian <- value("byte_order")
+  axes <- lapply(fields[keys == "axis"], function(x) x[-(1:3)])
+  names(axes) <- sapply(fields[keys == "axis"], `[`, 2)
+  all_metrics <- sapply(fields[keys == "metric"], `[`, 2)
+  if (is.null(metrics)) metrics <- all_metrics
+
+  seek(con, as.numeric(value("mask_offset")))
+  valid <- as.integer(readBin(con, "raw", n=cells)) == 1
+
+  ret <- list()
+  for (m in metrics) {
+    seek(con, as.numeric(value("data_offset")) + (match(m, all_metrics) - 1) * cells * 4)
+    x <- readBin(con, "numeric", n=cells, size=4, endian=endian)
+    x[!valid] <- NA
+    ret[[m]] <- array(x, dim=lengths(axes), dimnames=axes)
+  }
+  ret
+}
+
+# Read sampled energy trajectories (RECORD_TRAJECTORIES in src/main.cpp, see
+# src/Trajectory.hpp) as one row per parent per day, keyed by the index columns
+read_trajectories <- function(f) {
+  index <- read_csv(sub("\\.bin$", ".csv", f), show_col_types=FALSE)
+  con <- file(f, "rb")
+  on.exit(close(con))
+  header <- character()
+  repeat {
+    line <- readLines(con, n=1)
+    if (line == "end") break
+    header <- c(header, line)
+  }
+  fields <- strsplit(header, " ")
+  keys <- sapply(fields, `[`, 1)
+  value <- function(k) fields[[which(keys == k)[1]]][2]
+
+  data_offset <- as.numeric(value("data_offset"))
+  seek(con, data_offset)
+  n <- sum(index$Days_F + index$Days_M)
+  energy <- readBin(con, "numeric", n=n, size=4, endian=value("byte_order"))
+
+  # Records are packed in index order, female days then male days
+  index |>
+    mutate(Start = (Offset - data_offset) / 4) |>
+    reframe(Sex = rep(c("F", "M"), c(Days_F, Days_M)),
+            Day = c(seq_len(Days_F), seq_len(Days_M)),
+            Energy = energy[Start + seq_len(Days_F + Days_M)],
+            .by = c(Combo, Iteration, Min_Energy_Thresh_F, Max_Energy_Thresh_F,
+                    Min_Energy_Thresh_M, Max_Energy_Thresh_M, Foraging_Condition_Mean,
+                    Foraging_Condition_SD, Egg_Tolerance, Egg_Cost, Num_Parents, Hatch_Result))
+}
+
 dat_regular <- read_processed_dat("Output/processed_regular.csv")
 
 # Get numerical order for factoring strategies
@@ -210,7 +210,10 @@ processGroup <- function(chunk) {
 process_data_file <- function(type, suffix) {
     cat(paste("Reading", type, "data...\n"))
 
-    dat <- fread(paste0("Output/sims_", type, "_", suffix, ".csv"))
+    # Compressed output (COMPRESS_OUTPUT) is read through R.utils
+    f <- paste0("Output/sims_", type, "_", suffix, ".csv")
+    if (!file.exists(f)) f <- paste0(f, ".gz")
+    dat <- fread(f)
 
     GROUP_KEYS <- c("Min_Energy_Thresh_F", "Max_Energy_Thresh_F",
                     "Min_Energy_Thresh_M", "Max_Energy_Thresh_M",
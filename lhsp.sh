@@ -7,7 +7,7 @@
 cd /mnt/research/l.taylor/l.taylor/LHSP/src
 make clean
 make
-./lhsp
+./lhsp threads=${SLURM_NTASKS:-0}
 
 cd /mnt/research/l.taylor/l.taylor/LHSP
 Rscript --slave R/process_simulation_results.r
@@ -0,0 +1,335 @@
+#include <cmath>
+#include <algorithm>
+
+#include "Colony.hpp"
+
+/*
+Constructor (see Colony.hpp file).
+Every nest starts as a fresh egg with two fresh parents, and the
+female pays the initial cost of the egg (see breedingSeason()).
+*/
+template <class Energy>
+BasicColony<Energy>::BasicColony(const ColonyParams& params_, std::mt19937* randGen_):
+	params(params_),
+	randGen(randGen_),
+	standardNormal(std::normal_distribution<double>(0.0, 1.0)),
+	day(0),
+	activeNests(params_.numNests),
+	foragingQuality(0.0),
+	energy_F(params_.numNests),
+	energy_M(params_.numNests),
+	states(params_.numNests, 0),
+	foragingDays_F(params_.numNests, 0),
+	foragingDays_M(params_.numNests, 0),
+	eggDays(params_.numNests, 0),
+	eggCurrNeg(params_.numNests, 0),
+	eggTotNeg(params_.numNests, 0),
+	eggMaxNeg(params_.numNests, 0),
+	outcomes(params_.numNests, ACTIVE),
+	summary(ColonySummary()),
+	sumHatchDays(0),
+	sumTotalNeglect(0),
+	sumEndEnergy_F(0),
+	sumEndEnergy_M(0),
+	nestResults(nullptr)
+{
+	if (params.species == nullptr) {
+		params.species = speciesParams<LeachsStormPetrel>();
+	}
+	std::fill(this->energy_F.begin(), this->energy_F.end(), Energy::fromKJ(params.species->baseEnergy - params.eggCost));
+	std::fill(this->energy_M.begin(), this->energy_M.end(), Energy::fromKJ(params.species->baseEnergy));
+
+	/*
+	Females begin the season incubating, males begin foraging
+	(or the other way round, if requested)
+	*/
+	State startState_F = State::incubating;
+	State startState_M = State::foraging;
+	if (params.swapSexOrder) {
+		startState_F = State::foraging;
+		startState_M = State::incubating;
+	}
+
+	std::uint8_t packed = 0;
+	setBits(packed, 0, startState_F);
+	setBits(packed, 2, startState_F);
+	setBits(packed, 4, startState_M);
+	setBits(packed, 6, startState_M);
+	std::fill(this->states.begin(), this->states.end(), packed);
+
+	this->incubatingMetabolism = Energy::fromKJ(params.species->incubatingMetabolism);
+	this->foragingMetabolism = Energy::fromKJ(params.species->foragingMetabolism);
+
+	this->summary.nests = params.numNests;
+}
+
+template <class Energy>
+ColonyDay BasicColony<Energy>::colonyDay()
+{
+	ColonyDay today = ColonyDay();
+	today.activeNests = this->activeNests;
+
+	this->day++;
+	today.day = this->day;
+
+	// Shared environment for the day, as a stationary AR(1) offset
+	if (params.sharedForagingSD > 0) {
+		double rho = params.sharedForagingAutocorr;
+		double innovation = params.sharedForagingSD * std::sqrt(1 - rho * rho) * standardNormal(*randGen);
+		if (this->day == 1) {
+			this->foragingQuality = params.sharedForagingSD * standardNormal(*randGen);
+		} else {
+			this->foragingQuality = rho * this->foragingQuality + innovation;
+		}
+	}
+	today.foragingQuality = this->foragingQuality;
+	double foragingMean = params.foragingMean + this->foragingQuality;
+	double foragingSD = params.foragingSD;
+	if (params.foragingSchedule != nullptr) {
+		foragingMean += params.foragingSchedule->getMeanOffset(this->day - 1);
+		foragingSD *= params.foragingSchedule->getSDScale(this->day - 1);
+	}
+
+	// Species constants, hoisted out of the nest loop
+	double startHatchDays = params.species->startHatchDays;
+	double neglectPenalty = params.species->neglectPenalty;
+	double hatchDaysMax = params.species->hatchDaysMax;
+
+	// Thresholds in the pool's energy representation
+	Value minThresh_F = Energy::fromKJ(params.minEnergyThresh_F);
+	Value maxThresh_F = Energy::fromKJ(params.maxEnergyThresh_F);
+	Value minThresh_M = Energy::fromKJ(params.minEnergyThresh_M);
+	Value maxThresh_M = Energy::fromKJ(params.maxEnergyThresh_M);
+
+	double sumEnergy_F = 0;
+	double sumEnergy_M = 0;
+	long living = 0;
+
+	long numNests = params.numNests;
+	for (long i = 0; i < numNests; i++) {
+		if (outcomes[i] != ACTIVE) {
+			continue;
+		}
+
+		std::uint8_t packed = states[i];
+		State femaleStartState = getBits(packed, 0);
+		State maleStartState = getBits(packed, 4);
+
+		// Egg behavior based on incubation (see Egg::eggDay())
+		bool incubated = false;
+		if (femaleStartState == State::incubating) {
+			incubated = true;
+			today.femaleIncubating++;
+		} else if (maleStartState == State::incubating) {
+			incubated = true;
+			today.maleIncubating++;
+		}
+
+		eggDays[i]++;
+		bool eggAlive = true;
+		if (incubated) {
+			today.incubatedNests++;
+			eggCurrNeg[i] = 0;
+		} else {
+			eggCurrNeg[i]++;
+			eggTotNeg[i]++;
+			if (eggCurrNeg[i] > eggMaxNeg[i]) {
+				eggMaxNeg[i] = eggCurrNeg[i];
+				if (eggMaxNeg[i] > params.eggTolerance) {
+					eggAlive = false;
+				}
+			}
+		}
+		double hatchDays = startHatchDays + neglectPenalty * eggTotNeg[i];
+		bool eggHatched = eggAlive && eggDays[i] >= hatchDays;
+
+		// Parent behavior, including state change
+		double startEnergy_F = Energy::toKJ(energy_F[i]);
+		double startEnergy_M = Energy::toKJ(energy_M[i]);
+		State femaleState = parentDay(energy_F[i], packed, 0, foragingDays_F[i],
+		                              minThresh_F, maxThresh_F, foragingMean, foragingSD);
+		State maleState = parentDay(energy_M[i], packed, 4, foragingDays_M[i],
+		                            minThresh_M, maxThresh_M, foragingMean, foragingSD);
+
+		if (femaleState == State::dead || maleState == State::dead) {
+			states[i] = packed;
+			finishNest(i, DEAD_PARENT, today, startEnergy_F, startEnergy_M);
+			continue;
+		}
+
+		// Both incubating: the returning parent relieves its partner (see breedingSeason())
+		if (femaleState == State::incubating && maleState == State::incubating) {
+			State previousFemaleState = getBits(packed, 2);
+			State previousMaleState = getBits(packed, 6);
+
+			bool femaleLeaves;
+			if (previousFemaleState == State::incubating && previousMaleState == State::foraging) {
+				femaleLeaves = true;
+			} else if (previousMaleState == State::incubating && previousFemaleState == State::foraging) {
+				femaleLeaves = false;
+			} else {
+				std::uniform_real_distribution<double> tieBreaker(0.0, 1.0);
+				femaleLeaves = tieBreaker(*randGen) <= 0.5;
+			}
+
+			if (femaleLeaves) {
+				setBits(packed, 0, State::foraging);
+			} else {
+				setBits(packed, 4, State::foraging);
+			}
+		}
+		states[i] = packed;
+
+		if (!eggAlive) {
+			finishNest(i, EGG_COLD_FAIL, today, startEnergy_F, startEnergy_M);
+		} else if (eggHatched) {
+			finishNest(i, HATCHED, today, startEnergy_F, startEnergy_M);
+		} else if (eggDays[i] > hatchDaysMax) {
+			finishNest(i, EGG_TIME_FAIL, today, startEnergy_F, startEnergy_M);
+		} else {
+			sumEnergy_F += Energy::toKJ(energy_F[i]);
+			sumEnergy_M += Energy::toKJ(energy_M[i]);
+			living++;
+		}
+	}
+
+	if (living > 0) {
+		today.meanEnergy_F = sumEnergy_F / living;
+		today.meanEnergy_M = sumEnergy_M / living;
+	}
+
+	return today;
+}
+
+template <class Energy>
+State BasicColony<Energy>::parentDay(Value& energy, std::uint8_t& packed, int shift, std::uint8_t& foragingDays,
+                                     Value minThresh, Value maxThresh, double foragingMean, double foragingSD)
+{
+	State state = getBits(packed, shift);
+
+	// Did the parent die?
+	if (energy <= 0) {
+		state = State::dead;
+	}
+
+	if (state == State::incubating) {
+		energy -= this->incubatingMetabolism;
+		if (energy <= minThresh) {
+			state = State::foraging;
+		}
+		setBits(packed, shift + 2, State::incubating);
+	} else if (state == State::foraging) {
+		foragingDays++;
+		energy -= this->foragingMetabolism;
+
+		double foragingEnergy = foragingMean + foragingSD * standardNormal(*randGen);
+		if (foragingEnergy < 0) {
+			foragingEnergy = 0;
+		}
+		energy += Energy::fromKJ(foragingEnergy);
+
+		if (energy >= maxThresh && foragingDays > 1) {
+			state = State::incubating;
+			foragingDays = 0;
+		}
+		setBits(packed, shift + 2, State::foraging);
+	}
+
+	setBits(packed, shift, state);
+	return state;
+}
+
+template <class Energy>
+void BasicColony<Energy>::finishNest(long i, Outcome outcome, ColonyDay& today, double startEnergy_F, double startEnergy_M)
+{
+	outcomes[i] = outcome;
+	this->activeNests--;
+
+	if (outcome == HATCHED) {
+		today.hatched++;
+		this->summary.hatched++;
+	} else if (outcome == EGG_COLD_FAIL) {
+		today.eggColdFails++;
+		this->summary.eggColdFails++;
+	} else if (outcome == EGG_TIME_FAIL) {
+		today.eggTimeFails++;
+		this->summary.eggTimeFails++;
+	} else if (outcome == DEAD_PARENT) {
+		today.deaths++;
+		this->summary.deadParents++;
+	}
+
+	this->sumHatchDays += eggDays[i];
+	this->sumTotalNeglect += eggTotNeg[i];
+	this->sumEndEnergy_F += Energy::toKJ(energy_F[i]);
+	this->sumEndEnergy_M += Energy::toKJ(energy_M[i]);
+
+	if (this->nestResults != nullptr) {
+		const char* hatchResults[] = { "", "hatched", "egg cold fail", "egg time fail", "dead parent" };
+		SeasonResult result = SeasonResult();
+		result.hatchResult = hatchResults[outcome];
+		result.hatchDays = eggDays[i];
+		result.totNeglect = eggTotNeg[i];
+		result.maxNeglect = eggMaxNeg[i];
+		result.endEnergy_F = startEnergy_F;
+		result.meanEnergy_F = std::nan("");
+		result.varEnergy_F = std::nan("");
+		result.dead_F = getBits(states[i], 0) == State::dead;
+		result.endEnergy_M = startEnergy_M;
+		result.meanEnergy_M = std::nan("");
+		result.varEnergy_M = std::nan("");
+		result.dead_M = getBits(states[i], 4) == State::dead;
+		result.numParents = 2;
+		result.seasonDays = this->day;
+		this->nestResults->push_back(result);
+	}
+}
+
+template <class Energy>
+ColonySummary BasicColony<Energy>::getSummary()
+{
+	ColonySummary ret = this->summary;
+	long finished = params.numNests - this->activeNests;
+	if (finished > 0) {
+		ret.meanHatchDays = this->sumHatchDays / finished;
+		ret.meanTotalNeglect = this->sumTotalNeglect / finished;
+		ret.meanEndEnergy_F = this->sumEndEnergy_F / finished;
+		ret.meanEndEnergy_M = this->sumEndEnergy_M / finished;
+	}
+	return ret;
+}
+
+template <class Energy>
+std::size_t BasicColony<Energy>::memoryUsage()
+{
+	return sizeof(BasicColony<Energy>)
+	     + energy_F.capacity() * sizeof(Value)
+	     + energy_M.capacity() * sizeof(Value)
+	     + states.capacity()
+	     + foragingDays_F.capacity()
+	     + foragingDays_M.capacity()
+	     + eggDays.capacity()
+	     + eggCurrNeg.capacity()
+	     + eggTotNeg.capacity()
+	     + eggMaxNeg.capacity()
+	     + outcomes.capacity();
+}
+
+template <class Energy>
+std::size_t BasicColony<Energy>::bytesPerNest()
+{
+	return 2 * sizeof(Value) + 8 * sizeof(std::uint8_t);
+}
+
+template <class Energy>
+long BasicColony<Energy>::maxNests(std::size_t memoryBudget)
+{
+	if (memoryBudget <= sizeof(BasicColony<Energy>)) {
+		return 0;
+	}
+	return static_cast<long>((memoryBudget - sizeof(BasicColony<Energy>)) / bytesPerNest());
+}
+
+template class BasicColony<Float64Energy>;
+template class BasicColony<Float32Energy>;
+template class BasicColony<Fixed32Energy>;
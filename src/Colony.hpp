@@ -0,0 +1,236 @@
+#pragma once
+
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+#include "Parent.hpp"
+#include "Egg.hpp"
+#include "Season.hpp"
+#include "ForagingSchedule.hpp"
+
+/*
+Parameters shared by every nest in a colony run.
+Threshold and foraging values match the per-nest runModel() parameters.
+*/
+struct ColonyParams {
+    long numNests;                  // number of nests (pairs + egg) in the colony
+    double minEnergyThresh_F;       // female hunger threshold
+    double maxEnergyThresh_F;       // female satiation threshold
+    double minEnergyThresh_M;       // male hunger threshold
+    double maxEnergyThresh_M;       // male satiation threshold
+    double foragingMean;            // mean foraging intake (kJ)
+    double foragingSD;              // individual SD of foraging intake (kJ)
+    int eggTolerance;               // maximum consecutive neglect before egg death
+    double eggCost;                 // female's initial egg cost (kJ)
+    bool swapSexOrder;              // females start foraging, males incubating
+
+    /*
+    Shared environment. Every day a single foraging-quality offset (kJ)
+    is added to every bird's foraging mean, so nests are correlated
+    through the environment. The offset follows an AR(1) process with
+    stationary SD sharedForagingSD and lag-1 autocorrelation
+    sharedForagingAutocorr. An SD of 0 turns the shared signal off.
+    */
+    double sharedForagingSD;
+    double sharedForagingAutocorr;
+
+    // Optional day-indexed foraging conditions (nullptr for constant conditions)
+    const ForagingSchedule* foragingSchedule;
+
+    // Species parameters (nullptr for Leach's Storm-petrel)
+    const SpeciesParams* species;
+};
+
+/*
+Energy representations for the nest pool. Energy is always modeled in kJ;
+a representation only changes how it is stored and accumulated.
+Float32Energy halves the pool's energy storage, and Fixed32Energy stores
+energy as whole hundredths of a kJ in an int32 (foraging draws are rounded
+to that resolution). See the colony accuracy report in main() for how far
+either drifts from the double-precision engine.
+*/
+struct Float64Energy {
+    typedef double Value;
+    static const char* name() { return "float64"; }
+    static Value fromKJ(double kJ) { return kJ; }
+    static double toKJ(Value v) { return v; }
+};
+
+struct Float32Energy {
+    typedef float Value;
+    static const char* name() { return "float32"; }
+    static Value fromKJ(double kJ) { return static_cast<float>(kJ); }
+    static double toKJ(Value v) { return v; }
+};
+
+struct Fixed32Energy {
+    typedef std::int32_t Value;
+    static constexpr double SCALE = 100.0;     // units per kJ
+    static const char* name() { return "fixed32"; }
+    static Value fromKJ(double kJ) { return static_cast<Value>(std::lround(kJ * SCALE)); }
+    static double toKJ(Value v) { return v / SCALE; }
+};
+
+// Colony-wide streaming reduction for a single day
+struct ColonyDay {
+    int day;                        // day of the season (1-indexed)
+    long activeNests;               // nests still running at the start of the day
+    long incubatedNests;            // nests with at least one parent incubating
+    long femaleIncubating;          // nests where the female is incubating
+    long maleIncubating;            // nests where the male is incubating
+    long hatched;                   // eggs hatched on this day
+    long eggColdFails;              // eggs lost to neglect on this day
+    long eggTimeFails;              // eggs that ran past the hatch limit on this day
+    long deaths;                    // nests ending with a dead parent on this day
+    double meanEnergy_F;            // mean energy of living, active females
+    double meanEnergy_M;            // mean energy of living, active males
+    double foragingQuality;         // shared foraging offset for the day (kJ)
+};
+
+// Colony-wide season totals, accumulated as nests finish
+struct ColonySummary {
+    long nests;
+    long hatched;
+    long eggTimeFails;
+    long eggColdFails;
+    long deadParents;
+    double meanHatchDays;           // mean season length across all nests
+    double meanTotalNeglect;        // mean total neglect across all nests
+    double meanEndEnergy_F;         // mean female energy when her nest finished
+    double meanEndEnergy_M;         // mean male energy when his nest finished
+};
+
+/*
+A colony of many storm-petrel nests, simulated in lock-step.
+
+Birds and eggs are not stored as individual Parent and Egg objects.
+Every per-nest field lives in its own contiguous array (a structure of
+arrays), holding only the state that actually changes during the season
+(~24 bytes per nest with double energies). Each nest follows exactly the same daily rules as
+breedingSeason(), and colony metrics are reduced on the fly so nothing
+grows with the length of the season.
+@tparam Energy energy representation (Float64Energy, Float32Energy or Fixed32Energy)
+*/
+template <class Energy>
+class BasicColony {
+
+public:
+
+    /*
+    Constructor
+    @param params_ colony-wide parameters
+    @param randGen_ ptr to a single-seeded random number device
+    */
+    BasicColony(const ColonyParams& params_, std::mt19937* randGen_);
+
+    /*
+    Advance every active nest by a single day.
+    @return colony-wide reduction for that day
+    */
+    ColonyDay colonyDay();
+
+    /*
+    Also keep every nest's season as it finishes, as runModel() would
+    report it (for engine equivalence, see Equivalence.hpp). Energy means
+    and variances aren't tracked per nest, so they are NaN.
+    @param results_ nests appended in the order they finish (nullptr for none)
+    */
+    void recordNests(std::vector<SeasonResult>* results_) { this->nestResults = results_; }
+
+    // Getters
+    bool isActive() { return this->activeNests > 0; }
+    long getActiveNests() { return this->activeNests; }
+    int getDay() { return this->day; }
+    ColonySummary getSummary();
+
+    // Bytes actually held by the nest pool
+    std::size_t memoryUsage();
+
+    // Bytes of pool storage required per nest
+    static std::size_t bytesPerNest();
+
+    // Largest colony whose pool fits in a memory budget (bytes)
+    static long maxNests(std::size_t memoryBudget);
+
+private:
+
+    typedef typename Energy::Value Value;
+
+    // Per-nest outcome codes (mirrors checkSeasonSuccess())
+    enum Outcome : std::uint8_t { ACTIVE, HATCHED, EGG_COLD_FAIL, EGG_TIME_FAIL, DEAD_PARENT };
+
+    /*
+    Both parents' states are packed into one byte per nest:
+    bits 0-1 female state, 2-3 female previous state,
+    bits 4-5 male state, 6-7 male previous state
+    */
+    static State getBits(std::uint8_t packed, int shift) { return static_cast<State>((packed >> shift) & 0x3); }
+    static void setBits(std::uint8_t& packed, int shift, State s) {
+        packed = static_cast<std::uint8_t>((packed & ~(0x3 << shift)) | (static_cast<int>(s) << shift));
+    }
+
+    /*
+    A single parent's day (see Parent::parentDay()), operating on pool storage
+    @return the parent's state at the end of the day
+    */
+    State parentDay(Value& energy, std::uint8_t& packed, int shift, std::uint8_t& foragingDays,
+                    Value minThresh, Value maxThresh, double foragingMean, double foragingSD);
+
+    /*
+    Count a finished nest
+    @param startEnergy_F energy at the start of the nest's last day (kJ), as
+           Parent records it; the same for startEnergy_M
+    */
+    void finishNest(long i, Outcome outcome, ColonyDay& today, double startEnergy_F, double startEnergy_M);
+
+    ColonyParams params;
+    std::mt19937* randGen;          // ptr to random device
+    std::normal_distribution<double> standardNormal;
+
+    int day;                        // days elapsed
+    long activeNests;               // nests not yet finished
+    double foragingQuality;         // current shared foraging offset
+    Value incubatingMetabolism;     // species metabolism in the pool's representation
+    Value foragingMetabolism;
+
+    // Nest pool (structure of arrays, one entry per nest)
+    std::vector<Value> energy_F;
+    std::vector<Value> energy_M;
+    std::vector<std::uint8_t> states;           // packed parent states (see above)
+    std::vector<std::uint8_t> foragingDays_F;
+    std::vector<std::uint8_t> foragingDays_M;
+    std::vector<std::uint8_t> eggDays;          // egg age (days)
+    std::vector<std::uint8_t> eggCurrNeg;       // current consecutive neglect
+    std::vector<std::uint8_t> eggTotNeg;        // total neglect
+    std::vector<std::uint8_t> eggMaxNeg;        // maximum consecutive neglect
+    std::vector<std::uint8_t> outcomes;         // Outcome code
+
+    // Streaming season totals
+    ColonySummary summary;
+    double sumHatchDays;
+    double sumTotalNeglect;
+    double sumEndEnergy_F;
+    double sumEndEnergy_M;
+
+    std::vector<SeasonResult>* nestResults;     // finished nests (nullptr unless recorded)
+};
+
+// The double-precision colony
+typedef BasicColony<Float64Energy> Colony;
+
+// Run-time selection of a colony's energy representation
+enum class EnergyPrecision { float64, float32, fixed32 };
+
+// Run a whole colony season, keeping only the season totals
+template <class Energy>
+ColonySummary simulateColony(const ColonyParams& params, std::mt19937* randGen)
+{
+	BasicColony<Energy> colony(params, randGen);
+	while (colony.isActive()) {
+		colony.colonyDay();
+	}
+	return colony.getSummary();
+}
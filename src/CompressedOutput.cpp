@@ -0,0 +1,366 @@
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#ifdef LHSP_ZLIB
+#include <zlib.h>
+#endif
+
+#include "CompressedOutput.hpp"
+
+static const std::size_t BGZF_HEADER_BYTES = 18;
+static const std::size_t BGZF_FOOTER_BYTES = 8;
+static const std::size_t BGZF_MAX_BLOCK = 65536;
+
+// Empty block marking the end of a BGZF file
+static const unsigned char BGZF_EOF[28] = {
+	0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43,
+	0x02, 0x00, 0x1b, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+static void putLE(unsigned char* out, uint64_t x, int bytes)
+{
+	for (int i = 0; i < bytes; i++) {
+		out[i] = (x >> (8 * i)) & 0xff;
+	}
+}
+
+static uint64_t getLE(const char* in, int bytes)
+{
+	uint64_t x = 0;
+	for (int i = bytes - 1; i >= 0; i--) {
+		x = (x << 8) | static_cast<unsigned char>(in[i]);
+	}
+	return x;
+}
+
+static uint32_t blockCrc(const char* data, std::size_t size)
+{
+#ifdef LHSP_ZLIB
+	return crc32(0, reinterpret_cast<const Bytef*>(data), size);
+#else
+	static uint32_t table[256];
+	static bool tableReady = false;
+	if (!tableReady) {
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++) {
+				c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+			}
+			table[i] = c;
+		}
+		tableReady = true;
+	}
+	uint32_t crc = 0xffffffff;
+	for (std::size_t i = 0; i < size; i++) {
+		crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xff] ^ (crc >> 8);
+	}
+	return crc ^ 0xffffffff;
+#endif
+}
+
+bool compressionAvailable()
+{
+#ifdef LHSP_ZLIB
+	return true;
+#else
+	return false;
+#endif
+}
+
+/*
+One BGZF block holding the data, deflated if possible and stored if zlib
+is missing or deflate doesn't fit the block
+@param out at least BGZF_MAX_BLOCK bytes
+@return size of the block
+*/
+static std::size_t compressBlock(const std::vector<char>& data, int level, unsigned char* out)
+{
+	unsigned char* cdata = out + BGZF_HEADER_BYTES;
+	std::size_t room = BGZF_MAX_BLOCK - BGZF_HEADER_BYTES - BGZF_FOOTER_BYTES;
+	std::size_t csize = 0;
+
+#ifdef LHSP_ZLIB
+	z_stream zs = z_stream();
+	if (deflateInit2(&zs, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) == Z_OK) {
+		zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+		zs.avail_in = data.size();
+		zs.next_out = cdata;
+		zs.avail_out = room;
+		if (deflate(&zs, Z_FINISH) == Z_STREAM_END) {
+			csize = zs.total_out;
+		}
+		deflateEnd(&zs);
+	}
+#else
+	(void)level;
+	(void)room;
+#endif
+
+	// Stored: final block, type 00, length and its complement
+	if (csize == 0) {
+		cdata[0] = 0x01;
+		putLE(cdata + 1, data.size(), 2);
+		putLE(cdata + 3, ~data.size() & 0xffff, 2);
+		std::memcpy(cdata + 5, data.data(), data.size());
+		csize = data.size() + 5;
+	}
+
+	std::size_t size = BGZF_HEADER_BYTES + csize + BGZF_FOOTER_BYTES;
+	std::memcpy(out, BGZF_EOF, BGZF_HEADER_BYTES);
+	putLE(out + 16, size - 1, 2);
+	putLE(out + BGZF_HEADER_BYTES + csize, blockCrc(data.data(), data.size()), 4);
+	putLE(out + BGZF_HEADER_BYTES + csize + 4, data.size(), 4);
+	return size;
+}
+
+CompressedFileBuf::CompressedFileBuf():
+	fname(""),
+	file(nullptr),
+	level(6),
+	maxQueued(64),
+	buffer(std::vector<char>(BGZF_BLOCK_BYTES)),
+	bytesIn(0),
+	closing(false),
+	failed(false),
+	bytesOut(0)
+{
+	setp(this->buffer.data(), this->buffer.data() + this->buffer.size());
+}
+
+CompressedFileBuf::~CompressedFileBuf()
+{
+	close();
+}
+
+bool CompressedFileBuf::open(const std::string& fname_, int level_, int maxQueuedBlocks)
+{
+	close();
+	this->file = std::fopen(fname_.c_str(), "wb");
+	if (this->file == nullptr) {
+		return false;
+	}
+	this->fname = fname_;
+	this->level = level_;
+	this->maxQueued = std::max(1, maxQueuedBlocks);
+	this->bytesIn = 0;
+	this->bytesOut = 0;
+	this->closing = false;
+	this->failed = false;
+	this->index.clear();
+	setp(this->buffer.data(), this->buffer.data() + this->buffer.size());
+	this->worker = std::thread(&CompressedFileBuf::compressionLoop, this);
+	return true;
+}
+
+void CompressedFileBuf::submit()
+{
+	// Without a file there's nowhere for the bytes to go, so they are dropped
+	std::size_t used = pptr() - pbase();
+	if (this->file == nullptr) {
+		setp(this->buffer.data(), this->buffer.data() + this->buffer.size());
+		return;
+	}
+	if (used == 0) {
+		return;
+	}
+	std::vector<char> block(pbase(), pptr());
+	this->bytesIn += used;
+	setp(this->buffer.data(), this->buffer.data() + this->buffer.size());
+
+	{
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->queueChanged.wait(lock, [this] { return this->queue.size() < this->maxQueued; });
+		this->queue.push_back(std::move(block));
+	}
+	this->queueChanged.notify_all();
+}
+
+int CompressedFileBuf::overflow(int c)
+{
+	submit();
+	if (this->file == nullptr) {
+		return traits_type::eof();
+	}
+	if (traits_type::eq_int_type(c, traits_type::eof())) {
+		return traits_type::not_eof(c);
+	}
+	*pptr() = traits_type::to_char_type(c);
+	pbump(1);
+	return c;
+}
+
+int CompressedFileBuf::sync()
+{
+	submit();
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->failed ? -1 : 0;
+}
+
+void CompressedFileBuf::compressionLoop()
+{
+	std::vector<unsigned char> out(BGZF_MAX_BLOCK);
+	uint64_t rawOffset = 0;
+	while (true) {
+		std::vector<char> block;
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->queueChanged.wait(lock, [this] { return !this->queue.empty() || this->closing; });
+			if (this->queue.empty()) {
+				return;
+			}
+			block.swap(this->queue.front());
+		}
+
+		// Compress and write outside the lock, so the stream keeps filling
+		std::size_t size = compressBlock(block, this->level, out.data());
+		bool written = std::fwrite(out.data(), 1, size, this->file) == size;
+
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->queue.pop_front();
+			this->failed = this->failed || !written;
+			if (this->bytesOut > 0) {
+				this->index.push_back(this->bytesOut);
+				this->index.push_back(rawOffset);
+			}
+			this->bytesOut += size;
+		}
+		rawOffset += block.size();
+		this->queueChanged.notify_all();
+	}
+}
+
+uint64_t CompressedFileBuf::getBytesOut()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->bytesOut;
+}
+
+bool CompressedFileBuf::close()
+{
+	if (this->file == nullptr) {
+		return true;
+	}
+
+	submit();
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->closing = true;
+	}
+	this->queueChanged.notify_all();
+	this->worker.join();
+
+	bool ok = !this->failed;
+	ok = std::fwrite(BGZF_EOF, 1, sizeof(BGZF_EOF), this->file) == sizeof(BGZF_EOF) && ok;
+	ok = std::fclose(this->file) == 0 && ok;
+	this->file = nullptr;
+
+	// bgzip .gzi index: number of entries, then compressed and uncompressed offsets
+	std::FILE* indexFile = std::fopen((this->fname + ".gzi").c_str(), "wb");
+	if (indexFile == nullptr) {
+		return false;
+	}
+	unsigned char entry[8];
+	putLE(entry, this->index.size() / 2, 8);
+	ok = std::fwrite(entry, 1, 8, indexFile) == 8 && ok;
+	for (unsigned int i = 0; i < this->index.size(); i++) {
+		putLE(entry, this->index[i], 8);
+		ok = std::fwrite(entry, 1, 8, indexFile) == 8 && ok;
+	}
+	ok = std::fclose(indexFile) == 0 && ok;
+	return ok;
+}
+
+CompressedOfstream::CompressedOfstream():
+	std::ostream(nullptr),
+	buf()
+{
+	std::ios::rdbuf(&this->buf);
+}
+
+bool isBgzf(const char* data, std::size_t size)
+{
+	return size >= BGZF_HEADER_BYTES &&
+	       std::memcmp(data, BGZF_EOF, 4) == 0 &&
+	       getLE(data + 10, 2) == 6 && data[12] == 'B' && data[13] == 'C';
+}
+
+bool bgzfBlocks(const char* data, std::size_t size, std::vector<BgzfBlock>* blocks)
+{
+	blocks->clear();
+	std::size_t offset = 0;
+	while (offset < size) {
+		if (!isBgzf(data + offset, size - offset)) {
+			return false;
+		}
+		BgzfBlock block;
+		block.offset = offset;
+		block.size = getLE(data + offset + 16, 2) + 1;
+		if (block.size < BGZF_HEADER_BYTES + BGZF_FOOTER_BYTES || offset + block.size > size) {
+			return false;
+		}
+		block.rawSize = getLE(data + offset + block.size - 4, 4);
+		blocks->push_back(block);
+		offset += block.size;
+	}
+	return true;
+}
+
+bool inflateBlocks(const char* data, const BgzfBlock* blocks, std::size_t count, std::string* out)
+{
+	for (std::size_t b = 0; b < count; b++) {
+		const BgzfBlock& block = blocks[b];
+		if (block.rawSize == 0) {
+			continue;
+		}
+		const char* cdata = data + block.offset + BGZF_HEADER_BYTES;
+		std::size_t csize = block.size - BGZF_HEADER_BYTES - BGZF_FOOTER_BYTES;
+		std::size_t start = out->size();
+		out->resize(start + block.rawSize);
+		char* raw = &(*out)[start];
+
+#ifdef LHSP_ZLIB
+		z_stream zs = z_stream();
+		if (inflateInit2(&zs, -15) != Z_OK) {
+			return false;
+		}
+		zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(cdata));
+		zs.avail_in = csize;
+		zs.next_out = reinterpret_cast<Bytef*>(raw);
+		zs.avail_out = block.rawSize;
+		int status = inflate(&zs, Z_FINISH);
+		std::size_t produced = zs.total_out;
+		inflateEnd(&zs);
+		if (status != Z_STREAM_END || produced != block.rawSize) {
+			return false;
+		}
+#else
+		// Stored deflate blocks only
+		std::size_t in = 0;
+		std::size_t produced = 0;
+		bool last = false;
+		while (!last) {
+			if (in + 5 > csize || (cdata[in] & 0x06) != 0) {
+				return false;
+			}
+			last = cdata[in] & 0x01;
+			std::size_t length = getLE(cdata + in + 1, 2);
+			if (in + 5 + length > csize || produced + length > block.rawSize) {
+				return false;
+			}
+			std::memcpy(raw + produced, cdata + in + 5, length);
+			in += 5 + length;
+			produced += length;
+		}
+		if (produced != block.rawSize) {
+			return false;
+		}
+#endif
+
+		if (blockCrc(raw, block.rawSize) != getLE(data + block.offset + block.size - 8, 4)) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <ostream>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/*
+Block-compressed output in the BGZF format (as bgzip/htslib write it).
+
+Output is cut into blocks of at most BGZF_BLOCK_BYTES, each compressed as
+its own gzip member with its compressed size in the header, so:
+- the file is an ordinary .gz file (zcat, R's fread, Python's gzip),
+- any block can be decompressed on its own, so readers can seek (a
+  bgzip-style .gzi index of block offsets is written next to the file)
+  and decode blocks in parallel.
+
+Blocks are deflated with zlib when it is available (LHSP_ZLIB, see the
+Makefile); without it they are written as stored (uncompressed) deflate
+blocks, which every gzip reader still accepts.
+*/
+
+static const std::size_t BGZF_BLOCK_BYTES = 0xff00;
+
+// True if blocks are deflated, false if they are stored (no zlib)
+bool compressionAvailable();
+
+/*
+Stream buffer writing a BGZF file. Full blocks are handed to a dedicated
+compression thread, which deflates and writes them in order, so the
+thread filling the stream only waits if the compression thread falls
+maxQueuedBlocks behind.
+*/
+class CompressedFileBuf : public std::streambuf {
+
+public:
+
+    CompressedFileBuf();
+    ~CompressedFileBuf();
+
+    /*
+    Create the file and start the compression thread
+    @param level zlib compression level (1 fastest - 9 smallest)
+    @return false if the file can't be created
+    */
+    bool open(const std::string& fname, int level, int maxQueuedBlocks = 64);
+
+    /*
+    Write out every block, the end-of-file marker and the .gzi index, and
+    stop the compression thread
+    @return false if any write failed
+    */
+    bool close();
+
+    bool is_open() const { return this->file != nullptr; }
+
+    // Bytes written to the stream so far, and compressed bytes written to the file
+    uint64_t getBytesIn() const { return this->bytesIn; }
+    uint64_t getBytesOut();
+
+protected:
+
+    int overflow(int c);
+    int sync();
+
+private:
+
+    // Hand the filled part of the buffer to the compression thread
+    void submit();
+
+    void compressionLoop();
+
+    std::string fname;
+    std::FILE* file;
+    int level;
+    std::size_t maxQueued;
+    std::vector<char> buffer;
+    uint64_t bytesIn;
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable queueChanged;
+    std::deque< std::vector<char> > queue;
+    bool closing;
+    bool failed;
+    uint64_t bytesOut;
+    std::vector<uint64_t> index;    // compressed, uncompressed offset of every block after the first
+};
+
+// std::ostream over a CompressedFileBuf
+class CompressedOfstream : public std::ostream {
+
+public:
+
+    CompressedOfstream();
+
+    bool open(const std::string& fname, int level) { return this->buf.open(fname, level); }
+    bool close() { return this->buf.close(); }
+    bool is_open() const { return this->buf.is_open(); }
+
+    uint64_t getBytesOut() { return this->buf.getBytesOut(); }
+
+private:
+
+    CompressedFileBuf buf;
+};
+
+// A BGZF block within a file
+struct BgzfBlock {
+    std::size_t offset;             // of the block in the file
+    std::size_t size;               // compressed size, header and footer included
+    std::size_t rawSize;            // uncompressed size
+};
+
+// Does the data start with a BGZF block?
+bool isBgzf(const char* data, std::size_t size);
+
+/*
+List a BGZF file's blocks from their headers, without decompressing
+@return false if the data isn't a sequence of whole BGZF blocks
+*/
+bool bgzfBlocks(const char* data, std::size_t size, std::vector<BgzfBlock>* blocks);
+
+/*
+Decompress consecutive blocks, appending to out. Without zlib only
+stored blocks can be read.
+@return false if a block is corrupt or can't be decoded
+*/
+bool inflateBlocks(const char* data, const BgzfBlock* blocks, std::size_t count, std::string* out);
@@ -4,14 +4,14 @@
 Constructor (see Egg.hpp file).
 C++11 initialization of instance variables.
 */
-Egg::Egg():
+Egg::Egg(const SpeciesParams* species_):
+	species(species_),
 	alive(true),
 	hatched(false),
-	eggCost(EGG_COST),
-    neglectMax(NEGLECT_MAX),
+	eggCost(species_->eggCost),
+    neglectMax(species_->neglectMax),
 	currDays(0),
-	hatchDays(START_HATCH_DAYS),
-	maxHatchDays(HATCH_DAYS_MAX),
+	hatchDays(species_->startHatchDays),
 	currNegCounter(0),
 	totNegCounter(0),
 	maxNegCounter(0)
@@ -21,6 +21,7 @@ Egg::Egg():
 Egg behavior for a single day.
 @param incubated is the egg incubated for the day?
 */
+template <class Species>
 void Egg::eggDay(bool incubated)
 {
 	// Keeping track of all days (incubated or not)
@@ -44,11 +45,17 @@ void Egg::eggDay(bool incubated)
 			}
 		}
 
-		this->hatchDays += NEGLECT_PENALTY;
+		this->hatchDays += SpeciesTraits<Species>::neglectPenalty(this->species);
 	}
 
 	// Egg hatches when it catches up with the required hatching time
 	if (this->alive && this->currDays >= this->hatchDays) {
 		this->hatched = true;
 	}
-}
\ No newline at end of file
+}
+
+// Every species pack is compiled here for the season kernels
+template void Egg::eggDay<RuntimeSpecies>(bool);
+template void Egg::eggDay<LeachsStormPetrel>(bool);
+template void Egg::eggDay<ForkTailedStormPetrel>(bool);
+template void Egg::eggDay<EuropeanStormPetrel>(bool);
@@ -1,22 +1,28 @@
 #pragma once
 
+#include "Species.hpp"
+
 /*
-A Leach's Storm-petrel egg, sitting in a comfy burrow
+A storm-petrel egg (Leach's by default), sitting in a comfy burrow
 */ 
 class Egg {
 	
 public:
 
-	// Constructor
-	Egg();					
+	/*
+	Constructor
+	@param species_ shared species parameters (Leach's Storm-petrel by default)
+	*/
+	Egg(const SpeciesParams* species_ = speciesParams<LeachsStormPetrel>());
 
 	/*
 	Egg Behavior, where the egg is incubated (moving towards hatch date) 
 	or suffers neglect (moving further from hatch date and dying if 
 	neglected too long)
 	@param incubated is at least one parent incubating the egg?
+	@tparam Species compile-time species pack, or RuntimeSpecies
 	*/
-	void eggDay(bool incubated);							
+	template <class Species = RuntimeSpecies> void eggDay(bool incubated);
 
     // Setters
     void setNeglectMax(int neglectMax_) { this->neglectMax = neglectMax_; }
@@ -27,40 +33,16 @@ public:
 	bool isHatched() { return this->hatched; }
 
 	int getIncubationDays() { return this->currDays; }
-	double getMaxHatchDays() { return this-> maxHatchDays; }
+	double getMaxHatchDays() { return this->species->hatchDaysMax; }
 	int getTotNeg() { return this->totNegCounter; }
 	int getMaxNeg() { return this->maxNegCounter; }
+	int getCurrNeg() { return this->currNegCounter; }
+	double getHatchDays() { return this->hatchDays; }
 	double getEggCost() { return this->eggCost; }
 
 private:
 
-	// Minimum observed incubation period (Huntington et al. 1996)
-	constexpr static double START_HATCH_DAYS = 37.0;
-
-	// High number as an upper limit on egg hatching
-	constexpr static double HATCH_DAYS_MAX = 60;
-
-    // Mean energetic contents of a single egg (kJ) from Montevecchi et al. 1983
-	constexpr static double EGG_COST = 69.7;
-
-	/*
-	Neglect comes with a developmental cost, increases the necessary
-	length of incubation.
-
-	Wheelwright and Boersma (1979) fit a line for Fork-Tailed Storm-Petrels,
-	with a slope of 0.7 for (days fully incubated) ~ (days neglect).
-	Each day of neglect is thus expected to add (1/0.7)=1.43 days
-	to required incubation time.
-	*/
-	constexpr static double NEGLECT_PENALTY = 1.43;
-
-	/*
-	Maximum conseq. neglect before hatch failure 
-	(based on maximum values from Wheelwright and Boersma (1979)
-	in Fork-tailed Storm-petrels, 
-	matching anecdotal value from LT for Leach's Storm-Petrels
-	*/
-	constexpr static int NEGLECT_MAX = 7;
+	const SpeciesParams* species;	// shared species parameters (hatch timing, neglect penalty)
 
 	bool alive;	         // is egg alive? 
 	bool hatched;		 // is egg hatched?
@@ -70,7 +52,6 @@ private:
 
 	double currDays;	     // egg age (days) 
 	double hatchDays; 	     // current total incubation days required until
-	double maxHatchDays; 	 // cutoff before hatching fails due to time limit (e.g., breeding window ends)
 
 	int currNegCounter;	      // current consecutive days of neglect
 	int totNegCounter;	      // totals days of neglect
@@ -0,0 +1,832 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <limits>
+#include <cstdlib>
+
+#include "Emulator.hpp"
+#include "ResultsStore.hpp"
+
+const char* const EMULATED_OUTCOMES[NUM_EMULATED_OUTCOMES] = {
+	"Rate_Success", "Rate_Fail_Egg_Time", "Rate_Fail_Egg_Cold", "Rate_Fail_Parent_Dead"
+};
+
+// Count columns of the EMULATED_OUTCOMES
+static const char* const OUTCOME_COUNTS[NUM_EMULATED_OUTCOMES] = {
+	"N_Success", "N_Fail_Egg_Time", "N_Fail_Egg_Cold", "N_Fail_Parent_Dead"
+};
+
+// Length scales tried in training, in scaled axis units
+static const double LENGTH_SCALES[] = { 0.03, 0.06, 0.125, 0.25, 0.5, 1.0, 2.0, 4.0 };
+static const int NUM_LENGTH_SCALES = sizeof(LENGTH_SCALES) / sizeof(LENGTH_SCALES[0]);
+
+// Signal variances tried in training, as shares of the logits' variance
+static const double SIGNAL_SHARES[] = { 0.02, 0.05, 0.1, 0.2, 0.5, 1.0, 2.0, 5.0 };
+static const int NUM_SIGNAL_SHARES = sizeof(SIGNAL_SHARES) / sizeof(SIGNAL_SHARES[0]);
+
+static const int LEAF_POINTS = 8;           // k-d tree ranges searched point by point
+static const int VALIDATION_POINTS = 500;   // leave-one-out sample used in training
+static const int FIT_PASSES = 3;            // fits, the first on empirical logits, then on working responses
+
+static double inverseLogit(double y)
+{
+	return 1 / (1 + std::exp(-y));
+}
+
+int findEmulatedOutcome(const std::string& name)
+{
+	for (int o = 0; o < NUM_EMULATED_OUTCOMES; o++) {
+		if (name == EMULATED_OUTCOMES[o]) {
+			return o;
+		}
+	}
+	return -1;
+}
+
+EmulatorPoint EmulatorPoint::fromGroup(const ComboParams& combo, const SimsGroup& group)
+{
+	EmulatorPoint point = EmulatorPoint();
+	for (int a = 0; a < NUM_SCENARIO_AXES; a++) {
+		point.x[a] = comboValue(combo, a);
+	}
+	point.n = group.n;
+	point.counts[0] = group.nSuccess;
+	point.counts[1] = group.nFailEggTime;
+	point.counts[2] = group.nFailEggCold;
+	point.counts[3] = group.nFailParentDead;
+	return point;
+}
+
+OutcomeEmulator::OutcomeEmulator():
+	points(std::vector<EmulatorPoint>()),
+	trained(false)
+{}
+
+void OutcomeEmulator::addPoint(const EmulatorPoint& point)
+{
+	this->points.push_back(point);
+	this->trained = false;
+}
+
+bool OutcomeEmulator::loadStore(const std::string& fname)
+{
+	ResultsStore store;
+	if (!store.open(fname)) {
+		return false;
+	}
+
+	std::vector<double> columns[NUM_SCENARIO_AXES + 1 + NUM_EMULATED_OUTCOMES];
+	for (int c = 0; c < NUM_SCENARIO_AXES + 1 + NUM_EMULATED_OUTCOMES; c++) {
+		const char* name = c < NUM_SCENARIO_AXES ? SCENARIO_AXES[c]
+		                 : c == NUM_SCENARIO_AXES ? "N_Total" : OUTCOME_COUNTS[c - NUM_SCENARIO_AXES - 1];
+		int column = store.findColumn(name);
+		if (column < 0) {
+			return false;
+		}
+		store.readColumn(column, &columns[c]);
+	}
+
+	// Combinations yet to run have NaN counts
+	const std::vector<double>& n = columns[NUM_SCENARIO_AXES];
+	for (unsigned int r = 0; r < n.size(); r++) {
+		if (!(n[r] > 0)) {
+			continue;
+		}
+		EmulatorPoint point = EmulatorPoint();
+		for (int a = 0; a < NUM_SCENARIO_AXES; a++) {
+			point.x[a] = columns[a][r];
+		}
+		point.n = n[r];
+		for (int o = 0; o < NUM_EMULATED_OUTCOMES; o++) {
+			point.counts[o] = columns[NUM_SCENARIO_AXES + 1 + o][r];
+		}
+		addPoint(point);
+	}
+	return true;
+}
+
+// Split a CSV line, dropping quotes and a trailing carriage return
+static void splitCsvLine(const std::string& line, std::vector<std::string>* fields)
+{
+	fields->clear();
+	std::stringstream ss(line);
+	std::string field;
+	while (std::getline(ss, field, ',')) {
+		field.erase(std::remove(field.begin(), field.end(), '"'), field.end());
+		field.erase(std::remove(field.begin(), field.end(), '\r'), field.end());
+		fields->push_back(field);
+	}
+}
+
+bool OutcomeEmulator::loadPoints(const std::string& fname)
+{
+	std::ifstream infile(fname);
+	std::string line;
+	if (!infile.is_open() || !std::getline(infile, line)) {
+		return false;
+	}
+
+	std::vector<std::string> fields;
+	splitCsvLine(line, &fields);
+	int index[NUM_SCENARIO_AXES + 1 + NUM_EMULATED_OUTCOMES];
+	for (int c = 0; c < NUM_SCENARIO_AXES + 1 + NUM_EMULATED_OUTCOMES; c++) {
+		const char* name = c < NUM_SCENARIO_AXES ? SCENARIO_AXES[c]
+		                 : c == NUM_SCENARIO_AXES ? "N_Total" : OUTCOME_COUNTS[c - NUM_SCENARIO_AXES - 1];
+		std::vector<std::string>::iterator it = std::find(fields.begin(), fields.end(), name);
+		if (it == fields.end()) {
+			return false;
+		}
+		index[c] = it - fields.begin();
+	}
+
+	while (std::getline(infile, line)) {
+		splitCsvLine(line, &fields);
+		double values[NUM_SCENARIO_AXES + 1 + NUM_EMULATED_OUTCOMES];
+		bool complete = true;
+		for (int c = 0; c < NUM_SCENARIO_AXES + 1 + NUM_EMULATED_OUTCOMES && complete; c++) {
+			char* end = nullptr;
+			complete = index[c] < (int)fields.size() && !fields[index[c]].empty();
+			values[c] = complete ? std::strtod(fields[index[c]].c_str(), &end) : 0;
+			complete = complete && *end == '\0';
+		}
+		if (!complete || !(values[NUM_SCENARIO_AXES] > 0)) {
+			continue;
+		}
+		EmulatorPoint point = EmulatorPoint();
+		std::copy(values, values + NUM_SCENARIO_AXES, point.x);
+		point.n = values[NUM_SCENARIO_AXES];
+		std::copy(values + NUM_SCENARIO_AXES + 1, values + NUM_SCENARIO_AXES + 1 + NUM_EMULATED_OUTCOMES, point.counts);
+		addPoint(point);
+	}
+	return true;
+}
+
+bool OutcomeEmulator::writePoints(const std::string& fname, const std::vector<EmulatorPoint>& points, SpeciesId species)
+{
+	std::ofstream outfile(fname, std::ofstream::trunc);
+	if (!outfile.is_open()) {
+		return false;
+	}
+	outfile << std::setprecision(15);
+	for (int a = 0; a < NUM_SCENARIO_AXES; a++) {
+		outfile << SCENARIO_AXES[a] << ",";
+	}
+	outfile << "N_Total";
+	for (int o = 0; o < NUM_EMULATED_OUTCOMES; o++) {
+		outfile << "," << OUTCOME_COUNTS[o];
+	}
+	outfile << ",Species\n";
+
+	for (unsigned int i = 0; i < points.size(); i++) {
+		for (int a = 0; a < NUM_SCENARIO_AXES; a++) {
+			outfile << points[i].x[a] << ",";
+		}
+		outfile << points[i].n;
+		for (int o = 0; o < NUM_EMULATED_OUTCOMES; o++) {
+			outfile << "," << points[i].counts[o];
+		}
+		outfile << "," << speciesName(species) << "\n";
+	}
+	outfile.close();
+	return !outfile.fail();
+}
+
+bool OutcomeEmulator::train()
+{
+	this->trained = false;
+	int n = this->points.size();
+	if (n < 2) {
+		return false;
+	}
+
+	// Same fit whatever order the points were added in
+	std::sort(this->points.begin(), this->points.end(), [](const EmulatorPoint& p, const EmulatorPoint& q) {
+		if (!std::equal(p.x, p.x + NUM_SCENARIO_AXES, q.x)) {
+			return std::lexicographical_compare(p.x, p.x + NUM_SCENARIO_AXES, q.x, q.x + NUM_SCENARIO_AXES);
+		}
+		if (p.n != q.n) {
+			return p.n < q.n;
+		}
+		return std::lexicographical_compare(p.counts, p.counts + NUM_EMULATED_OUTCOMES,
+		                                    q.counts, q.counts + NUM_EMULATED_OUTCOMES);
+	});
+
+	for (int a = 0; a < NUM_SCENARIO_AXES; a++) {
+		this->low[a] = this->high[a] = this->points[0].x[a];
+		for (int i = 1; i < n; i++) {
+			this->low[a] = std::min(this->low[a], this->points[i].x[a]);
+			this->high[a] = std::max(this->high[a], this->points[i].x[a]);
+		}
+		this->axisScale[a] = this->high[a] > this->low[a] ? 1 / (this->high[a] - this->low[a]) : 0;
+	}
+	this->scaled.resize((std::size_t)n * NUM_SCENARIO_AXES);
+	for (int i = 0; i < n; i++) {
+		scale(this->points[i].x, &this->scaled[i * NUM_SCENARIO_AXES]);
+	}
+
+	this->tree.resize(n);
+	for (int i = 0; i < n; i++) {
+		this->tree[i] = i;
+	}
+	this->splitAxis.assign(n, -1);
+	buildTree(0, n);
+
+	// Empirical logits to start
+	for (int o = 0; o < NUM_EMULATED_OUTCOMES; o++) {
+		this->y[o].resize(n);
+		this->noise[o].resize(n);
+		for (int i = 0; i < n; i++) {
+			double h = this->points[i].counts[o];
+			double m = this->points[i].n;
+			this->y[o][i] = std::log((h + 0.5) / (m - h + 0.5));
+			this->noise[o][i] = 1 / (h + 0.5) + 1 / (m - h + 0.5);
+		}
+	}
+
+	// Validation sample, the same for every outcome and pass
+	std::vector<int> sample(this->tree);
+	std::mt19937 randGen(1);
+	std::shuffle(sample.begin(), sample.end(), randGen);
+	sample.resize(std::min(n, VALIDATION_POINTS));
+
+	fitHyperparameters(sample);
+	for (int pass = 1; pass < FIT_PASSES; pass++) {
+		workingResponses();
+		fitHyperparameters(sample);
+	}
+
+	this->trained = true;
+	return true;
+}
+
+/*
+Length scale and signal variance with the best leave-one-out predictive
+density on the sample, from a grid (signal variances as shares of the
+responses' variance, which also sets the prior mean)
+*/
+void OutcomeEmulator::fitHyperparameters(const std::vector<int>& sample)
+{
+	int n = this->points.size();
+	double logitVariance[NUM_EMULATED_OUTCOMES];
+	for (int o = 0; o < NUM_EMULATED_OUTCOMES; o++) {
+		double sumY = 0;
+		for (int i = 0; i < n; i++) {
+			sumY += this->y[o][i];
+		}
+		this->priorMean[o] = sumY / n;
+		double varY = 0;
+		for (int i = 0; i < n; i++) {
+			varY += (this->y[o][i] - this->priorMean[o]) * (this->y[o][i] - this->priorMean[o]);
+		}
+		logitVariance[o] = std::max(varY / n, 1e-4);
+	}
+
+	const int NUM_FITS = NUM_LENGTH_SCALES * NUM_SIGNAL_SHARES;
+	std::vector<double> score[NUM_EMULATED_OUTCOMES];
+	std::vector<double> squaredError[NUM_EMULATED_OUTCOMES];
+	for (int o = 0; o < NUM_EMULATED_OUTCOMES; o++) {
+		score[o].assign(NUM_FITS, 0);
+		squaredError[o].assign(NUM_FITS, 0);
+	}
+	Neighbourhood near;
+	for (unsigned int s = 0; s < sample.size(); s++) {
+		int i = sample[s];
+		neighbourhood(&this->scaled[i * NUM_SCENARIO_AXES], i, &near);
+		for (int l = 0; l < NUM_LENGTH_SCALES; l++) {
+			for (int o = 0; o < NUM_EMULATED_OUTCOMES; o++) {
+				for (int v = 0; v < NUM_SIGNAL_SHARES; v++) {
+					double mean, variance;
+					predictLogit(near, o, LENGTH_SCALES[l], SIGNAL_SHARES[v] * logitVariance[o], &mean, &variance);
+					double total = variance + this->noise[o][i];
+					double error = this->y[o][i] - mean;
+					score[o][l * NUM_SIGNAL_SHARES + v] += 0.5 * std::log(total) + error * error / (2 * total);
+					double rateError = ratePrediction(near, o, mean, variance, false).rate
+					                   - this->points[i].counts[o] / this->points[i].n;
+					squaredError[o][l * NUM_SIGNAL_SHARES + v] += rateError * rateError;
+				}
+			}
+		}
+	}
+	for (int o = 0; o < NUM_EMULATED_OUTCOMES; o++) {
+		int best = std::min_element(score[o].begin(), score[o].end()) - score[o].begin();
+		this->lengthScale[o] = LENGTH_SCALES[best / NUM_SIGNAL_SHARES];
+		this->signalVariance[o] = SIGNAL_SHARES[best % NUM_SIGNAL_SHARES] * logitVariance[o];
+		this->validationError[o] = std::sqrt(squaredError[o][best] / sample.size());
+	}
+}
+
+/*
+Replace the responses by the working responses of the binomial likelihood
+at the current fit (one IRLS step): with fitted rate p at a point where h
+of m seasons had the outcome, y = logit(p) + (h - m p) / (m p (1 - p)) with
+noise variance 1 / (m p (1 - p)). Unlike the empirical logit's, that noise
+is right however thin the counts, so sparse points aren't discounted. The
+fitted rate is kept half a season from 0 and 1, where the weight vanishes.
+*/
+void OutcomeEmulator::workingResponses()
+{
+	int n = this->points.size();
+	std::vector<double> fitted[NUM_EMULATED_OUTCOMES];
+	Neighbourhood near;
+	for (int i = 0; i < n; i++) {
+		neighbourhood(&this->scaled[i * NUM_SCENARIO_AXES], -1, &near);
+		for (int o = 0; o < NUM_EMULATED_OUTCOMES; o++) {
+			double mean, variance;
+			predictLogit(near, o, this->lengthScale[o], this->signalVariance[o], &mean, &variance);
+			fitted[o].push_back(mean);
+		}
+	}
+
+	for (int o = 0; o < NUM_EMULATED_OUTCOMES; o++) {
+		for (int i = 0; i < n; i++) {
+			double h = this->points[i].counts[o];
+			double m = this->points[i].n;
+			double edge = 0.5 / (m + 1);
+			double p = std::min(std::max(inverseLogit(fitted[o][i]), edge), 1 - edge);
+			double weight = m * p * (1 - p);
+			this->y[o][i] = std::log(p / (1 - p)) + (h - m * p) / weight;
+			this->noise[o][i] = 1 / weight;
+		}
+	}
+}
+
+void OutcomeEmulator::buildTree(int first, int end)
+{
+	if (end - first <= LEAF_POINTS) {
+		return;
+	}
+
+	// Split the widest axis at its median
+	int axis = 0;
+	double widest = -1;
+	for (int a = 0; a < NUM_SCENARIO_AXES; a++) {
+		double lo = std::numeric_limits<double>::infinity();
+		double hi = -lo;
+		for (int i = first; i < end; i++) {
+			double z = this->scaled[this->tree[i] * NUM_SCENARIO_AXES + a];
+			lo = std::min(lo, z);
+			hi = std::max(hi, z);
+		}
+		if (hi - lo > widest) {
+			widest = hi - lo;
+			axis = a;
+		}
+	}
+
+	int mid = (first + end) / 2;
+	const std::vector<double>& scaled_ = this->scaled;
+	std::nth_element(this->tree.begin() + first, this->tree.begin() + mid, this->tree.begin() + end,
+	                 [&scaled_, axis](int p, int q) {
+	                     return scaled_[p * NUM_SCENARIO_AXES + axis] < scaled_[q * NUM_SCENARIO_AXES + axis];
+	                 });
+	this->splitAxis[mid] = axis;
+	buildTree(first, mid);
+	buildTree(mid + 1, end);
+}
+
+/*
+offsets hold the query's distance from the range on every split axis so
+far, and bound their squared sum: no point in the range is nearer, so the
+far side of a split is searched only if its bound beats the kth nearest
+*/
+void OutcomeEmulator::searchTree(int first, int end, const double* z, int exclude, double* offsets, double bound,
+                                 std::vector< std::pair<double, int> >& heap) const
+{
+	// Keep the nearest in a max-heap on squared distance
+	auto consider = [&](int p) {
+		if (p == exclude) {
+			return;
+		}
+		const double* zp = &this->scaled[p * NUM_SCENARIO_AXES];
+		double d = 0;
+		for (int a = 0; a < NUM_SCENARIO_AXES; a++) {
+			d += (z[a] - zp[a]) * (z[a] - zp[a]);
+		}
+		if ((int)heap.size() < EMULATOR_NEIGHBOURS) {
+			heap.push_back(std::make_pair(d, p));
+			std::push_heap(heap.begin(), heap.end());
+		} else if (d < heap.front().first) {
+			std::pop_heap(heap.begin(), heap.end());
+			heap.back() = std::make_pair(d, p);
+			std::push_heap(heap.begin(), heap.end());
+		}
+	};
+
+	if (end - first <= LEAF_POINTS) {
+		for (int i = first; i < end; i++) {
+			consider(this->tree[i]);
+		}
+		return;
+	}
+
+	int mid = (first + end) / 2;
+	int axis = this->splitAxis[mid];
+	consider(this->tree[mid]);
+	double diff = z[axis] - this->scaled[this->tree[mid] * NUM_SCENARIO_AXES + axis];
+
+	// Near side first; the far side only if it could hold a nearer point
+	if (diff < 0) {
+		searchTree(first, mid, z, exclude, offsets, bound, heap);
+	} else {
+		searchTree(mid + 1, end, z, exclude, offsets, bound, heap);
+	}
+	double offset = offsets[axis];
+	double farBound = bound - offset * offset + diff * diff;
+	if ((int)heap.size() < EMULATOR_NEIGHBOURS || farBound < heap.front().first) {
+		offsets[axis] = diff;
+		if (diff < 0) {
+			searchTree(mid + 1, end, z, exclude, offsets, farBound, heap);
+		} else {
+			searchTree(first, mid, z, exclude, offsets, farBound, heap);
+		}
+		offsets[axis] = offset;
+	}
+}
+
+void OutcomeEmulator::neighbourhood(const double* z, int exclude, Neighbourhood* near) const
+{
+	std::vector< std::pair<double, int> > heap;
+	heap.reserve(EMULATOR_NEIGHBOURS);
+	double offsets[NUM_SCENARIO_AXES] = {};
+	searchTree(0, this->tree.size(), z, exclude, offsets, 0, heap);
+
+	int m = heap.size();
+	near->found.resize(m);
+	near->query.resize(m);
+	near->pairs.resize((std::size_t)m * m);
+	for (int i = 0; i < m; i++) {
+		near->found[i] = heap[i].second;
+		near->query[i] = heap[i].first;
+		const double* zi = &this->scaled[heap[i].second * NUM_SCENARIO_AXES];
+		for (int j = 0; j < i; j++) {
+			const double* zj = &this->scaled[heap[j].second * NUM_SCENARIO_AXES];
+			double d = 0;
+			for (int a = 0; a < NUM_SCENARIO_AXES; a++) {
+				d += (zi[a] - zj[a]) * (zi[a] - zj[a]);
+			}
+			near->pairs[i * m + j] = d;
+		}
+		near->pairs[i * m + i] = 0;
+	}
+	near->correlated = 0;
+}
+
+void OutcomeEmulator::predictLogit(Neighbourhood& near, int outcome, double scale, double sf,
+                                   double* mean, double* variance) const
+{
+	int m = near.found.size();
+	if (near.correlated != scale) {
+		double inverse = 1 / (2 * scale * scale);
+		near.pairCorrelations.resize((std::size_t)m * m);
+		near.queryCorrelations.resize(m);
+		for (int i = 0; i < m; i++) {
+			for (int j = 0; j <= i; j++) {
+				near.pairCorrelations[i * m + j] = std::exp(-near.pairs[i * m + j] * inverse);
+			}
+			near.queryCorrelations[i] = std::exp(-near.query[i] * inverse);
+		}
+		near.correlated = scale;
+	}
+
+	// Covariance of the neighbours (with their noise) and with the query
+	std::vector<double> K((std::size_t)m * m);
+	std::vector<double> u(m);
+	std::vector<double> w(m);
+	std::vector<double> v(m, 1.0);
+	for (int i = 0; i < m; i++) {
+		for (int j = 0; j <= i; j++) {
+			K[i * m + j] = sf * near.pairCorrelations[i * m + j];
+		}
+		K[i * m + i] += this->noise[outcome][near.found[i]] + 1e-9 * sf;
+		u[i] = sf * near.queryCorrelations[i];
+		w[i] = this->y[outcome][near.found[i]] - this->priorMean[outcome];
+	}
+
+	// Cholesky factor in the lower triangle, then forward solves for L^-1 k, L^-1 (y - mean) and L^-1 1
+	for (int j = 0; j < m; j++) {
+		double pivot = K[j * m + j];
+		for (int p = 0; p < j; p++) {
+			pivot -= K[j * m + p] * K[j * m + p];
+		}
+		pivot = std::sqrt(std::max(pivot, 1e-12 * sf));
+		K[j * m + j] = pivot;
+		for (int i = j + 1; i < m; i++) {
+			double x = K[i * m + j];
+			for (int p = 0; p < j; p++) {
+				x -= K[i * m + p] * K[j * m + p];
+			}
+			K[i * m + j] = x / pivot;
+		}
+	}
+	for (int i = 0; i < m; i++) {
+		for (int p = 0; p < i; p++) {
+			u[i] -= K[i * m + p] * u[p];
+			w[i] -= K[i * m + p] * w[p];
+			v[i] -= K[i * m + p] * v[p];
+		}
+		u[i] /= K[i * m + i];
+		w[i] /= K[i * m + i];
+		v[i] /= K[i * m + i];
+	}
+
+	// The neighbourhood's mean by generalized least squares: 1'K^-1 (y - mean) / 1'K^-1 1
+	double fit = 0;
+	double explained = 0;
+	double precision = 0;
+	double shared = 0;
+	double offset = 0;
+	for (int i = 0; i < m; i++) {
+		fit += u[i] * w[i];
+		explained += u[i] * u[i];
+		precision += v[i] * v[i];
+		shared += v[i] * u[i];
+		offset += v[i] * w[i];
+	}
+	offset /= precision;
+	*mean = this->priorMean[outcome] + offset + fit - offset * shared;
+	*variance = std::max(sf - explained, 0.0) + (1 - shared) * (1 - shared) / precision;
+}
+
+bool OutcomeEmulator::scale(const double x[NUM_SCENARIO_AXES], double z[NUM_SCENARIO_AXES]) const
+{
+	bool extrapolated = false;
+	for (int a = 0; a < NUM_SCENARIO_AXES; a++) {
+		z[a] = (x[a] - this->low[a]) * this->axisScale[a];
+		double tolerance = 1e-9 * (this->high[a] - this->low[a] + std::fabs(this->low[a]));
+		extrapolated = extrapolated || x[a] < this->low[a] - tolerance || x[a] > this->high[a] + tolerance;
+	}
+	return extrapolated;
+}
+
+// Rate, sd and interval from the logit's posterior alone (NaN untrained)
+static EmulatorPrediction logitPrediction(double mean, double variance, bool extrapolated)
+{
+	EmulatorPrediction prediction = EmulatorPrediction();
+	double sd = std::sqrt(variance);
+	prediction.rate = inverseLogit(mean);
+	prediction.low = inverseLogit(mean - 1.96 * sd);
+	prediction.high = inverseLogit(mean + 1.96 * sd);
+	prediction.sd = (prediction.high - prediction.low) / 3.92;
+	prediction.extrapolated = extrapolated;
+	return prediction;
+}
+
+EmulatorPrediction OutcomeEmulator::ratePrediction(const Neighbourhood& near, int outcome, double mean, double variance,
+                                                   bool extrapolated) const
+{
+	// Mean of the logit-normal rate (probit approximation), not the inverse logit of the mean
+	EmulatorPrediction prediction = logitPrediction(mean, variance, extrapolated);
+	prediction.rate = inverseLogit(mean / std::sqrt(1 + M_PI * variance / 8));
+
+	// The neighbours' counts pooled by their correlation with the query, and the half season each keeps from the edge
+	double outcomes = 0;
+	double seasons = 0;
+	double pseudo = 0;
+	for (unsigned int i = 0; i < near.found.size(); i++) {
+		const EmulatorPoint& point = this->points[near.found[i]];
+		outcomes += near.queryCorrelations[i] * point.counts[outcome];
+		seasons += near.queryCorrelations[i] * point.n;
+		pseudo += near.queryCorrelations[i] * 0.5;
+	}
+
+	// Wilson score interval of the pooled counts
+	double low = 0;
+	double high = 1;
+	if (seasons > 0) {
+		double z2 = 1.96 * 1.96;
+		double p = outcomes / seasons;
+		double centre = (p + z2 / (2 * seasons)) / (1 + z2 / seasons);
+		double half = std::sqrt(p * (1 - p) / seasons + z2 / (4 * seasons * seasons)) * 1.96 / (1 + z2 / seasons);
+		low = std::max(0.0, centre - half);
+		high = std::min(1.0, centre + half);
+	}
+
+	// Where those half seasons outweigh the rarer side of the counts, they set the fit, so the counts give the rate
+	if (std::min(outcomes, seasons - outcomes) < pseudo && (prediction.rate < low || prediction.rate > high)) {
+		prediction.rate = (outcomes + 0.5) / (seasons + 1);
+	}
+	prediction.low = std::min(prediction.low, low);
+	prediction.high = std::max(prediction.high, high);
+	prediction.sd = (prediction.high - prediction.low) / 3.92;
+	return prediction;
+}
+
+EmulatorPrediction OutcomeEmulator::predict(const double x[NUM_SCENARIO_AXES], int outcome) const
+{
+	if (!this->trained) {
+		double nan = std::numeric_limits<double>::quiet_NaN();
+		return logitPrediction(nan, nan, false);
+	}
+	double z[NUM_SCENARIO_AXES];
+	bool extrapolated = scale(x, z);
+	Neighbourhood near;
+	neighbourhood(z, -1, &near);
+	double mean, variance;
+	predictLogit(near, outcome, this->lengthScale[outcome], this->signalVariance[outcome], &mean, &variance);
+	return ratePrediction(near, outcome, mean, variance, extrapolated);
+}
+
+EmulatorPrediction OutcomeEmulator::predict(const ComboParams& combo, int outcome) const
+{
+	double x[NUM_SCENARIO_AXES];
+	for (int a = 0; a < NUM_SCENARIO_AXES; a++) {
+		x[a] = comboValue(combo, a);
+	}
+	return predict(x, outcome);
+}
+
+void OutcomeEmulator::predictAll(const double x[NUM_SCENARIO_AXES],
+                                 EmulatorPrediction predictions[NUM_EMULATED_OUTCOMES]) const
+{
+	if (!this->trained) {
+		for (int o = 0; o < NUM_EMULATED_OUTCOMES; o++) {
+			predictions[o] = predict(x, o);
+		}
+		return;
+	}
+	double z[NUM_SCENARIO_AXES];
+	bool extrapolated = scale(x, z);
+	Neighbourhood near;
+	neighbourhood(z, -1, &near);
+	for (int o = 0; o < NUM_EMULATED_OUTCOMES; o++) {
+		double mean, variance;
+		predictLogit(near, o, this->lengthScale[o], this->signalVariance[o], &mean, &variance);
+		predictions[o] = ratePrediction(near, o, mean, variance, extrapolated);
+	}
+}
+
+double OutcomeEmulator::distance(const double a[NUM_SCENARIO_AXES], const double b[NUM_SCENARIO_AXES]) const
+{
+	double d = 0;
+	for (int i = 0; i < NUM_SCENARIO_AXES; i++) {
+		d += (a[i] - b[i]) * this->axisScale[i] * (a[i] - b[i]) * this->axisScale[i];
+	}
+	return std::sqrt(d);
+}
+
+// A scenario's values on one axis
+static std::vector<double> axisValues(const Scenario& scenario, int axis)
+{
+	switch (axis) {
+	case 0: return scenario.minEnergyThresh_F;
+	case 1: return scenario.maxEnergyThresh_F;
+	case 2: return scenario.minEnergyThresh_M;
+	case 3: return scenario.maxEnergyThresh_M;
+	case 4: return scenario.foragingMean;
+	case 5: return scenario.foragingSD;
+	case 6: return std::vector<double>(scenario.eggTolerance.begin(), scenario.eggTolerance.end());
+	default: return scenario.eggCost;
+	}
+}
+
+// Combination with the given axis values
+static ComboParams comboOf(const double x[NUM_SCENARIO_AXES])
+{
+	ComboParams combo = ComboParams();
+	combo.minEnergyThresh_F = x[0];
+	combo.maxEnergyThresh_F = x[1];
+	combo.minEnergyThresh_M = x[2];
+	combo.maxEnergyThresh_M = x[3];
+	combo.foragingMean = x[4];
+	combo.foragingSD = x[5];
+	combo.eggTolerance = static_cast<int>(x[6]);
+	combo.eggCost = x[7];
+	return combo;
+}
+
+// The rules scenarioCombos() applies
+static bool comboAllowed(const Scenario& scenario, const ComboParams& combo)
+{
+	if (combo.minEnergyThresh_F >= combo.maxEnergyThresh_F ||
+	    combo.minEnergyThresh_M >= combo.maxEnergyThresh_M) {
+		return false;
+	}
+	for (unsigned int k = 0; k < scenario.constraints.size(); k++) {
+		if (!scenario.constraints[k].allows(combo)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+std::vector<ComboParams> learningCandidates(const Scenario& scenario, long maxCandidates, std::mt19937* randGen)
+{
+	// Every axis's values with the midpoints between them (whole days of egg tolerance)
+	std::vector<double> refined[NUM_SCENARIO_AXES];
+	double total = 1;
+	for (int a = 0; a < NUM_SCENARIO_AXES; a++) {
+		std::vector<double> values = axisValues(scenario, a);
+		std::sort(values.begin(), values.end());
+		values.erase(std::unique(values.begin(), values.end()), values.end());
+		for (unsigned int i = 0; i < values.size(); i++) {
+			refined[a].push_back(values[i]);
+			if (i + 1 < values.size()) {
+				double mid = (values[i] + values[i+1]) / 2;
+				if (a == 6) {
+					mid = std::floor(mid);
+				}
+				if (mid > values[i]) {
+					refined[a].push_back(mid);
+				}
+			}
+		}
+		total *= refined[a].size();
+	}
+
+	std::vector<ComboParams> candidates;
+	double x[NUM_SCENARIO_AXES];
+	if (total <= maxCandidates) {
+		std::vector<unsigned int> index(NUM_SCENARIO_AXES, 0);
+		for (long c = 0; c < (long)total; c++) {
+			for (int a = 0; a < NUM_SCENARIO_AXES; a++) {
+				x[a] = refined[a][index[a]];
+			}
+			ComboParams combo = comboOf(x);
+			if (comboAllowed(scenario, combo)) {
+				candidates.push_back(combo);
+			}
+			for (int a = NUM_SCENARIO_AXES - 1; a >= 0 && ++index[a] == refined[a].size(); a--) {
+				index[a] = 0;
+			}
+		}
+		return candidates;
+	}
+
+	// Sample the refined grid, giving up on rules that reject nearly everything
+	for (long attempt = 0; attempt < 20 * maxCandidates && (long)candidates.size() < maxCandidates; attempt++) {
+		for (int a = 0; a < NUM_SCENARIO_AXES; a++) {
+			std::uniform_int_distribution<int> pick(0, refined[a].size() - 1);
+			x[a] = refined[a][pick(*randGen)];
+		}
+		ComboParams combo = comboOf(x);
+		if (comboAllowed(scenario, combo)) {
+			candidates.push_back(combo);
+		}
+	}
+	return candidates;
+}
+
+std::vector<long> chooseLearningBatch(const OutcomeEmulator& emulator, const std::vector<ComboParams>& candidates,
+                                      int outcome, int batchSize, double exploreFraction, std::mt19937* randGen,
+                                      std::vector<double>* sds)
+{
+	sds->resize(candidates.size());
+	std::vector<long> order(candidates.size());
+	for (unsigned int i = 0; i < candidates.size(); i++) {
+		(*sds)[i] = emulator.predict(candidates[i], outcome).sd;
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [sds](long p, long q) { return (*sds)[p] > (*sds)[q]; });
+
+	// Spread out first; fill up with the next most uncertain if the candidates run out
+	int uncertain = batchSize - static_cast<int>(std::floor(exploreFraction * batchSize));
+	double radius = emulator.getLengthScale(outcome);
+	std::vector<long> batch;
+	std::vector<bool> picked(candidates.size(), false);
+	for (int pass = 0; pass < 2; pass++) {
+		for (unsigned int i = 0; i < order.size() && (int)batch.size() < uncertain; i++) {
+			if (picked[order[i]]) {
+				continue;
+			}
+			double x[NUM_SCENARIO_AXES];
+			for (int a = 0; a < NUM_SCENARIO_AXES; a++) {
+				x[a] = comboValue(candidates[order[i]], a);
+			}
+			bool near = false;
+			for (unsigned int b = 0; b < batch.size() && pass == 0 && !near; b++) {
+				double y[NUM_SCENARIO_AXES];
+				for (int a = 0; a < NUM_SCENARIO_AXES; a++) {
+					y[a] = comboValue(candidates[batch[b]], a);
+				}
+				near = emulator.distance(x, y) < radius;
+			}
+			if (!near) {
+				batch.push_back(order[i]);
+				picked[order[i]] = true;
+			}
+		}
+	}
+
+	std::shuffle(order.begin(), order.end(), *randGen);
+	for (unsigned int i = 0; i < order.size() && (int)batch.size() < batchSize; i++) {
+		if (!picked[order[i]]) {
+			batch.push_back(order[i]);
+			picked[order[i]] = true;
+		}
+	}
+	return batch;
+}
+
+EmulatorPoint simulateLearningPoint(const ComboParams& combo, const Scenario& scenario, int iterations,
+                                    uint64_t baseSeed, int round, long position, SpeciesId species)
+{
+	SimsGroup group = SimsGroup();
+	for (int i = 0; i < iterations; i++) {
+		std::mt19937 randGen;
+		seedReplicate(&randGen, replicateSeed(baseSeed, round, position, i));
+		group.addSeason(simulateSeason(combo, scenario.oneParent, scenario.swapSexOrder, nullptr, &randGen, species));
+	}
+	return EmulatorPoint::fromGroup(combo, group);
+}
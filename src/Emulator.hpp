@@ -0,0 +1,199 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdint>
+
+#include "Scenario.hpp"
+#include "SimsProcessor.hpp"
+
+/*
+Surrogate emulator of a scenario's outcome rates over the swept axes,
+trained on aggregated results (per-combination outcome counts), so rates
+between and beyond the simulated grid can be asked for in microseconds,
+with their uncertainty.
+
+Each outcome is modelled on the logit scale. Training starts from
+empirical logits (a point where h of n seasons had the outcome has
+y = log((h + 0.5) / (n - h + 0.5)), noise variance 1/(h + 0.5) + 1/(n - h + 0.5))
+and then refits on the binomial likelihood's working responses around the
+fit, whose noise stays right however thin the counts, so well-replicated
+points are trusted more than thin ones without thin ones being written
+off as noise. A prediction conditions a Gaussian
+process (squared exponential kernel, axes scaled to the training range)
+on the EMULATOR_NEIGHBOURS training points nearest the query, found with a
+k-d tree, so it costs a tree search and a small Cholesky factorization
+however many points there are. The neighbourhood's mean logit is
+estimated along with the fit (generalized least squares), and its
+uncertainty is part of the prediction's. Every fit picks each outcome's
+length scale and signal variance by leave-one-out predictive density on a
+sample of the points.
+
+Near rates of 0 and 1 the half season the fit keeps from the edge, not the
+counts, sets it, so the interval always also covers the Wilson interval of
+the neighbours' counts pooled by their correlation with the query, and
+the rate comes from those counts where those half seasons outweigh them.
+
+Train on one scenario's results (one parent and two parent seasons don't
+mix); axes constant in the training data are ignored.
+*/
+
+static const int NUM_EMULATED_OUTCOMES = 4;
+static const int EMULATOR_NEIGHBOURS = 24;
+
+// The emulated rates, named as in processed_*.csv (with their N_* counts)
+extern const char* const EMULATED_OUTCOMES[NUM_EMULATED_OUTCOMES];
+
+// Index of an EMULATED_OUTCOMES name, or -1
+int findEmulatedOutcome(const std::string& name);
+
+// Aggregated results of one combination
+struct EmulatorPoint {
+    double x[NUM_SCENARIO_AXES];    // SCENARIO_AXES values
+    double n;                       // seasons
+    double counts[NUM_EMULATED_OUTCOMES];
+
+    // From a combination's summary (see SimsGroup)
+    static EmulatorPoint fromGroup(const ComboParams& combo, const SimsGroup& group);
+};
+
+struct EmulatorPrediction {
+    double rate;                    // posterior mean of the rate
+    double sd;                      // of the rate: the 95% interval's width / 3.92 (robust near 0 and 1)
+    double low;                     // 95% interval
+    double high;
+    bool extrapolated;              // outside the training range on some axis
+};
+
+class OutcomeEmulator {
+
+public:
+
+    OutcomeEmulator();
+
+    void addPoint(const EmulatorPoint& point);
+
+    /*
+    Add every combination of a results store that has run (see ResultsStore.hpp)
+    @return false if the store can't be read
+    */
+    bool loadStore(const std::string& fname);
+
+    /*
+    Add the rows of a CSV with the SCENARIO_AXES and N_* count columns
+    (processed_*.csv, or points written by writePoints())
+    @return false if the file can't be read or lacks a column
+    */
+    bool loadPoints(const std::string& fname);
+
+    // Write points as CSV (axes, N_Total, the N_* counts and the species simulated)
+    static bool writePoints(const std::string& fname, const std::vector<EmulatorPoint>& points, SpeciesId species);
+
+    /*
+    Scale the axes, build the tree and fit every outcome's length scale
+    and signal variance (needed after adding points, before predicting)
+    @return false with fewer than 2 points
+    */
+    bool train();
+
+    // Predict an outcome's rate (thread-safe once trained)
+    EmulatorPrediction predict(const double x[NUM_SCENARIO_AXES], int outcome) const;
+    EmulatorPrediction predict(const ComboParams& combo, int outcome) const;
+
+    // Predict every outcome's rate, sharing the neighbour search
+    void predictAll(const double x[NUM_SCENARIO_AXES], EmulatorPrediction predictions[NUM_EMULATED_OUTCOMES]) const;
+
+    // Distance between two points in scaled axes (as the kernel sees it)
+    double distance(const double a[NUM_SCENARIO_AXES], const double b[NUM_SCENARIO_AXES]) const;
+
+    const std::vector<EmulatorPoint>& getPoints() const { return this->points; }
+    bool isTrained() const { return this->trained; }
+    double getLengthScale(int outcome) const { return this->lengthScale[outcome]; }
+    double getSignalVariance(int outcome) const { return this->signalVariance[outcome]; }
+
+    // Leave-one-out RMSE of the rate at the fitted length scale
+    double getValidationError(int outcome) const { return this->validationError[outcome]; }
+
+private:
+
+    // The nearest training points to a query, their squared distances and kernel correlations
+    struct Neighbourhood {
+        std::vector<int> found;
+        std::vector<double> pairs;      // between the found points
+        std::vector<double> query;      // to the query
+        double correlated;              // length scale of the correlations (0 for none yet)
+        std::vector<double> pairCorrelations;
+        std::vector<double> queryCorrelations;
+    };
+
+    // Fitting passes of train() (see Emulator.cpp)
+    void fitHyperparameters(const std::vector<int>& sample);
+    void workingResponses();
+
+    void buildTree(int first, int end);
+    void searchTree(int first, int end, const double* z, int exclude, double* offsets, double bound,
+                    std::vector< std::pair<double, int> >& heap) const;
+
+    // Neighbourhood of scaled z, without point exclude
+    void neighbourhood(const double* z, int exclude, Neighbourhood* near) const;
+
+    /*
+    Posterior mean and variance of y at a neighbourhood's query
+    (correlations are kept for the next outcome with the same length scale)
+    */
+    void predictLogit(Neighbourhood& near, int outcome, double scale, double sf, double* mean, double* variance) const;
+
+    // Rate, sd and interval from the logit's posterior and the neighbours' counts (see above)
+    EmulatorPrediction ratePrediction(const Neighbourhood& near, int outcome, double mean, double variance,
+                                      bool extrapolated) const;
+
+    // Scale x, noting whether it is outside the training range
+    bool scale(const double x[NUM_SCENARIO_AXES], double z[NUM_SCENARIO_AXES]) const;
+
+    std::vector<EmulatorPoint> points;
+    bool trained;
+    double low[NUM_SCENARIO_AXES];
+    double high[NUM_SCENARIO_AXES];
+    double axisScale[NUM_SCENARIO_AXES];    // 1 / range (0 on constant axes)
+    std::vector<double> scaled;             // scaled coordinates, point by point
+    std::vector<int> tree;                  // points in k-d tree order (median of each range splits it)
+    std::vector<int> splitAxis;             // axis split at each median position
+    std::vector<double> y[NUM_EMULATED_OUTCOMES];
+    std::vector<double> noise[NUM_EMULATED_OUTCOMES];
+    double priorMean[NUM_EMULATED_OUTCOMES];
+    double signalVariance[NUM_EMULATED_OUTCOMES];
+    double lengthScale[NUM_EMULATED_OUTCOMES];
+    double validationError[NUM_EMULATED_OUTCOMES];
+};
+
+/*
+Candidate points for active learning: the scenario's grid refined with
+the midpoints between neighbouring values on every axis, keeping the
+scenario's rules (hunger below satiation, constraints), sampled at random
+down to maxCandidates if there are more
+*/
+std::vector<ComboParams> learningCandidates(const Scenario& scenario, long maxCandidates, std::mt19937* randGen);
+
+/*
+Pick the next points to simulate: the candidates where the outcome's rate
+is most uncertain, skipping any within one length scale of a point
+already picked, so a batch spreads over the uncertain regions. Uncertainty
+alone piles points onto the outcome boundaries, which leaves the rest of
+the space to the prior and skews the length scales, so a fraction of the
+batch is drawn from the candidates at random.
+@param exploreFraction share of the batch drawn at random
+@param sds filled with every candidate's predicted sd
+@return indices into candidates, most uncertain first, then the random ones
+*/
+std::vector<long> chooseLearningBatch(const OutcomeEmulator& emulator, const std::vector<ComboParams>& candidates,
+                                      int outcome, int batchSize, double exploreFraction, std::mt19937* randGen,
+                                      std::vector<double>* sds);
+
+/*
+Simulate a point for training: iterations seasons, seeded as replicates
+of a scenario with the round as its index and the batch position as its
+combination (see replicateSeed())
+*/
+EmulatorPoint simulateLearningPoint(const ComboParams& combo, const Scenario& scenario, int iterations,
+                                    uint64_t baseSeed, int round, long position, SpeciesId species);
@@ -0,0 +1,532 @@
+#include <algorithm>
+#include <cmath>
+
+#include "Equivalence.hpp"
+#include "Colony.hpp"
+
+/*
+Frozen copy of the original two-parent daily loop (breedingSeason() before
+the season kernels), so the reference doesn't move with the engine it checks.
+Only touches Parent and Egg through their run-time species defaults.
+*/
+static std::string referenceSeason(Parent& pf, Parent& pm, Egg& egg, bool swapSexOrder, std::mt19937* randGen)
+{
+	// Season history that records state at the start of each day
+	std::string seasonHistory = "";
+
+	// The female pays the initial cost of the egg
+	pf.setEnergy(pf.getEnergy() - egg.getEggCost());
+
+	if (swapSexOrder) {
+		// If requested, swap females to begin foraging, and males to begin incubating
+		pf.setState(State::foraging);
+		pf.setPrevDayState(State::foraging);
+
+		pm.setState(State::incubating);
+		pm.setPrevDayState(State::incubating);
+	}
+
+	while (egg.isAlive() && !egg.isHatched() && (egg.getIncubationDays() <= egg.getMaxHatchDays())) {
+
+		// Check if either is incubating
+		bool incubated = false;
+
+		State femaleStartState = pf.getState();
+		State maleStartState = pm.getState();
+
+		// Add the daily start state to the season history
+		if (femaleStartState == State::incubating) { seasonHistory += 'F'; }
+		else if (maleStartState == State::incubating) { seasonHistory += 'M'; }
+		else { seasonHistory += 'N'; }
+
+		// Egg behavior based on incubation
+		if (femaleStartState == State::incubating || maleStartState == State::incubating) {
+			incubated = true;
+		}
+		egg.eggDay(incubated);
+
+		// Parent behavior, including state change
+		pf.parentDay();
+		pm.parentDay();
+
+		State femaleState = pf.getState();
+		State maleState = pm.getState();
+
+		if (femaleState == State::dead || maleState == State::dead) {
+			break;
+		}
+
+		if (femaleState == State::incubating && maleState == State::incubating) {
+
+			State previousFemaleState = pf.getPreviousDayState();
+			State previousMaleState = pm.getPreviousDayState();
+
+			/*
+			 If the male has just returned, the female leaves
+			 If the female has just returned, the male leaves
+			 On the rare occasion where both individuals switch from
+			 foraging to incubating simultaenously in a timestep,
+			 a random parent is sent to switch
+			*/
+			if (previousFemaleState == State::incubating && previousMaleState == State::foraging) {
+				pf.changeState();
+			} else if (previousMaleState == State::incubating && previousFemaleState == State::foraging) {
+				pm.changeState();
+			} else {
+				std::uniform_real_distribution<double> tieBreaker(0.0, 1.0);
+				if (tieBreaker(*randGen) <= 0.5) {
+					pf.changeState();
+				} else {
+					pm.changeState();
+				}
+			}
+		}
+	}
+
+	return seasonHistory;
+}
+
+// Frozen copy of the original one-parent daily loop (breedingSeason_oneParent())
+static std::string referenceSeason_oneParent(Parent& pf, Egg& egg)
+{
+	// Season history that records state at the start of each day
+	std::string seasonHistory = "";
+
+	// The female pays the initial cost of the egg
+	pf.setEnergy(pf.getEnergy() - egg.getEggCost());
+
+	while (egg.isAlive() && !egg.isHatched() && (egg.getIncubationDays() <= egg.getMaxHatchDays())) {
+
+		State femaleStartState = pf.getState();
+
+		// Add the daily start state to the season history
+		if (femaleStartState == State::incubating) { seasonHistory += 'F'; }
+		else { seasonHistory += 'N'; }
+
+		// Check if female is incubating
+		bool incubated = false;
+		if (femaleStartState == State::incubating) {
+			incubated = true;
+		}
+
+		// Egg behavior based on incubation
+		egg.eggDay(incubated);
+
+		// Parent behavior, including state change
+		pf.parentDay();
+
+		// Check for death
+		State femaleState = pf.getState();
+		if (femaleState == State::dead) {
+			break;
+		}
+	}
+
+	return seasonHistory;
+}
+
+/*
+The original model: fresh Parent and Egg objects through the frozen daily
+loops above with run-time species parameters and full daily energy
+records, summarized as runModel() used to
+*/
+static void referenceEngine(const EngineJob& job, std::vector<SeasonResult>& results)
+{
+	const SpeciesParams* species = speciesParams(job.species);
+	const ComboParams& combo = job.combo;
+
+	std::mt19937 randGen;
+	for (int i = 0; i < job.replicates; i++) {
+		seedReplicate(&randGen, replicateSeed(job.baseSeed, job.scenarioIndex, job.comboIndex, i));
+
+		Egg egg = Egg(species);
+		egg.setNeglectMax(combo.eggTolerance);
+		egg.setEggCost(combo.eggCost);
+
+		Parent pf = Parent(Sex::female, &randGen, species);
+		Parent pm = Parent(Sex::male, &randGen, species);
+
+		pf.setMinEnergyThresh(combo.minEnergyThresh_F);
+		pf.setMaxEnergyThresh(combo.maxEnergyThresh_F);
+		pf.setForagingDistribution(combo.foragingMean, combo.foragingSD);
+		pf.setForagingSchedule(job.foragingSchedule);
+
+		pm.setMinEnergyThresh(combo.minEnergyThresh_M);
+		pm.setMaxEnergyThresh(combo.maxEnergyThresh_M);
+		pm.setForagingDistribution(combo.foragingMean, combo.foragingSD);
+		pm.setForagingSchedule(job.foragingSchedule);
+
+		SeasonResult result = SeasonResult();
+		if (job.scenario->oneParent) {
+			result.numParents = 1;
+			result.seasonHistory = referenceSeason_oneParent(pf, egg);
+			result.hatchResult = checkSeasonSuccess(pf, egg);
+		} else {
+			result.numParents = 2;
+			result.seasonHistory = referenceSeason(pf, pm, egg, job.scenario->swapSexOrder, &randGen);
+			result.hatchResult = checkSeasonSuccess(pf, pm, egg);
+		}
+
+		result.hatchDays = egg.getIncubationDays();
+		result.totNeglect = egg.getTotNeg();
+		result.maxNeglect = egg.getMaxNeg();
+
+		summarizeEnergy<true>(pf, result.endEnergy_F, result.meanEnergy_F, result.varEnergy_F);
+		result.dead_F = !pf.isAlive();
+		summarizeEnergy<true>(pm, result.endEnergy_M, result.meanEnergy_M, result.varEnergy_M);
+		result.dead_M = !pm.isAlive();
+
+		result.seasonDays = pf.getDay();
+		result.foragingDraws = pf.getForagingDraws() + pm.getForagingDraws();
+		results.push_back(result);
+	}
+}
+
+// The sweep engine: specialized kernels with running energy sums
+static void specializedEngine(const EngineJob& job, std::vector<SeasonResult>& results)
+{
+	std::mt19937 randGen;
+	for (int i = 0; i < job.replicates; i++) {
+		seedReplicate(&randGen, replicateSeed(job.baseSeed, job.scenarioIndex, job.comboIndex, i));
+		results.push_back(simulateSeason(job.combo, job.scenario->oneParent, job.scenario->swapSexOrder,
+		                                 job.foragingSchedule, &randGen, job.species));
+	}
+}
+
+/*
+A colony of one nest per replicate in a given energy representation (see
+Colony.hpp), with the shared environment off so nests are independent
+seasons like the other engines'. The colony draws for all its nests from
+one stream, seeded by the combination. Colonies have two parents, so
+one-parent scenarios get no results.
+*/
+template <class Energy>
+static void colonyEngine(const EngineJob& job, std::vector<SeasonResult>& results)
+{
+	if (job.scenario->oneParent) {
+		return;
+	}
+	const ComboParams& combo = job.combo;
+
+	ColonyParams params = ColonyParams();
+	params.numNests = job.replicates;
+	params.minEnergyThresh_F = combo.minEnergyThresh_F;
+	params.maxEnergyThresh_F = combo.maxEnergyThresh_F;
+	params.minEnergyThresh_M = combo.minEnergyThresh_M;
+	params.maxEnergyThresh_M = combo.maxEnergyThresh_M;
+	params.foragingMean = combo.foragingMean;
+	params.foragingSD = combo.foragingSD;
+	params.eggTolerance = combo.eggTolerance;
+	params.eggCost = combo.eggCost;
+	params.swapSexOrder = job.scenario->swapSexOrder;
+	params.sharedForagingSD = 0;
+	params.sharedForagingAutocorr = 0;
+	params.foragingSchedule = job.foragingSchedule;
+	params.species = speciesParams(job.species);
+
+	std::mt19937 randGen;
+	seedReplicate(&randGen, replicateSeed(job.baseSeed, job.scenarioIndex, job.comboIndex, 0));
+	BasicColony<Energy> colony(params, &randGen);
+	colony.recordNests(&results);
+	while (colony.isActive()) {
+		colony.colonyDay();
+	}
+}
+
+const std::vector<EquivalenceEngine>& equivalenceEngines()
+{
+	static const std::vector<EquivalenceEngine> engines = {
+		{ "reference", referenceEngine },
+		{ "specialized", specializedEngine },
+		{ "colony_float64", colonyEngine<Float64Energy> },
+		{ "colony_float32", colonyEngine<Float32Energy> },
+		{ "colony_fixed32", colonyEngine<Fixed32Energy> }
+	};
+	return engines;
+}
+
+SeasonEngine findEngine(const std::string& name)
+{
+	const std::vector<EquivalenceEngine>& engines = equivalenceEngines();
+	for (unsigned int i = 0; i < engines.size(); i++) {
+		if (engines[i].name == name) {
+			return engines[i].run;
+		}
+	}
+	return nullptr;
+}
+
+/*
+Regularized upper incomplete gamma function Q(a, x), by its series for
+x < a + 1 and its continued fraction otherwise (Press et al. 2007, 6.2)
+*/
+static double upperGammaQ(double a, double x)
+{
+	if (x <= 0) {
+		return 1.0;
+	}
+	double logPrefix = -x + a * std::log(x) - std::lgamma(a);
+
+	if (x < a + 1) {
+		double term = 1.0 / a;
+		double sum = term;
+		for (int n = 1; n < 1000; n++) {
+			term *= x / (a + n);
+			sum += term;
+			if (std::abs(term) < std::abs(sum) * 1e-15) {
+				break;
+			}
+		}
+		return 1.0 - sum * std::exp(logPrefix);
+	}
+
+	// Modified Lentz's method
+	const double tiny = 1e-300;
+	double b = x + 1 - a;
+	double c = 1.0 / tiny;
+	double d = 1.0 / b;
+	double h = d;
+	for (int i = 1; i < 1000; i++) {
+		double an = -i * (i - a);
+		b += 2;
+		d = an * d + b;
+		if (std::abs(d) < tiny) { d = tiny; }
+		c = b + an / c;
+		if (std::abs(c) < tiny) { c = tiny; }
+		d = 1.0 / d;
+		double delta = d * c;
+		h *= delta;
+		if (std::abs(delta - 1.0) < 1e-15) {
+			break;
+		}
+	}
+	return std::exp(logPrefix) * h;
+}
+
+double chiSquareHomogeneity(const std::vector<long>& a, const std::vector<long>& b, double* pValue)
+{
+	double totalA = 0;
+	double totalB = 0;
+	for (unsigned int k = 0; k < a.size(); k++) {
+		totalA += a[k];
+		totalB += b[k];
+	}
+
+	double chiSq = 0;
+	int categories = 0;
+	for (unsigned int k = 0; k < a.size(); k++) {
+		double column = a[k] + b[k];
+		if (column == 0) {
+			continue;
+		}
+		categories++;
+		double expectedA = column * totalA / (totalA + totalB);
+		double expectedB = column * totalB / (totalA + totalB);
+		chiSq += (a[k] - expectedA) * (a[k] - expectedA) / expectedA;
+		chiSq += (b[k] - expectedB) * (b[k] - expectedB) / expectedB;
+	}
+
+	*pValue = 1.0;
+	if (categories > 1 && totalA > 0 && totalB > 0) {
+		*pValue = upperGammaQ((categories - 1) / 2.0, chiSq / 2.0);
+	}
+	return chiSq;
+}
+
+// Kolmogorov distribution tail Q_KS(lambda) (Press et al. 2007, 14.3)
+static double kolmogorovQ(double lambda)
+{
+	if (lambda < 0.2) {
+		return 1.0;
+	}
+	double sum = 0;
+	double sign = 1;
+	for (int j = 1; j <= 100; j++) {
+		double term = sign * std::exp(-2.0 * j * j * lambda * lambda);
+		sum += term;
+		if (std::abs(term) < 1e-12) {
+			break;
+		}
+		sign = -sign;
+	}
+	return std::min(1.0, std::max(0.0, 2.0 * sum));
+}
+
+double ksTwoSample(std::vector<double> a, std::vector<double> b, double* pValue)
+{
+	std::sort(a.begin(), a.end());
+	std::sort(b.begin(), b.end());
+
+	double na = a.size();
+	double nb = b.size();
+	double maxDiff = 0;
+	unsigned int i = 0;
+	unsigned int j = 0;
+	while (i < a.size() && j < b.size()) {
+		double x = std::min(a[i], b[j]);
+		while (i < a.size() && a[i] == x) { i++; }
+		while (j < b.size() && b[j] == x) { j++; }
+		maxDiff = std::max(maxDiff, std::abs(i / na - j / nb));
+	}
+
+	*pValue = 1.0;
+	if (na > 0 && nb > 0) {
+		double ne = std::sqrt(na * nb / (na + nb));
+		*pValue = kolmogorovQ((ne + 0.12 + 0.11 / ne) * maxDiff);
+	}
+	return maxDiff;
+}
+
+// Standard normal quantile, by bisection on the CDF
+static double normalQuantile(double p)
+{
+	double low = -40;
+	double high = 40;
+	for (int i = 0; i < 200; i++) {
+		double mid = (low + high) / 2;
+		if (0.5 * std::erfc(-mid / std::sqrt(2.0)) < p) {
+			low = mid;
+		} else {
+			high = mid;
+		}
+	}
+	return (low + high) / 2;
+}
+
+/*
+The observed difference plus or minus a normal quantile times its bootstrap
+standard error, so narrow tails (small Bonferroni levels) don't need
+impractically many resamples (with no values on a side there's nothing
+to resample, and like ksTwoSample() the interval shows no difference)
+*/
+void bootstrapMeanDifference(const std::vector<double>& a, const std::vector<double>& b,
+                             int resamples, double level, std::mt19937* randGen,
+                             double* low, double* high)
+{
+	if (a.empty() || b.empty()) {
+		*low = 0;
+		*high = 0;
+		return;
+	}
+
+	std::vector<double> sampleA = a;
+	std::vector<double> sampleB = b;
+	double observed = vectorMean(sampleB) - vectorMean(sampleA);
+
+	std::uniform_int_distribution<std::size_t> pickA(0, a.size() - 1);
+	std::uniform_int_distribution<std::size_t> pickB(0, b.size() - 1);
+	double sum = 0;
+	double sumSq = 0;
+	for (int r = 0; r < resamples; r++) {
+		double sumA = 0;
+		double sumB = 0;
+		for (unsigned int i = 0; i < a.size(); i++) { sumA += a[pickA(*randGen)]; }
+		for (unsigned int i = 0; i < b.size(); i++) { sumB += b[pickB(*randGen)]; }
+		double diff = sumB / b.size() - sumA / a.size();
+		sum += diff;
+		sumSq += diff * diff;
+	}
+	double meanDiff = sum / resamples;
+	double se = std::sqrt(std::max(0.0, sumSq / resamples - meanDiff * meanDiff));
+	double z = normalQuantile(1 - (1 - level) / 2);
+
+	*low = observed - z * se;
+	*high = observed + z * se;
+}
+
+// Hatch result counts, in the order of checkSeasonSuccess()'s results
+static std::vector<long> hatchResultCounts(const std::vector<SeasonResult>& results)
+{
+	std::vector<long> counts(4, 0);
+	for (unsigned int i = 0; i < results.size(); i++) {
+		const std::string& r = results[i].hatchResult;
+		if (r == "hatched") { counts[0]++; }
+		else if (r == "egg cold fail") { counts[1]++; }
+		else if (r == "egg time fail") { counts[2]++; }
+		else { counts[3]++; }
+	}
+	return counts;
+}
+
+// A continuous metric of every season, by its sims_*.csv column name
+static std::vector<double> seasonMetric(const std::vector<SeasonResult>& results, const std::string& metric)
+{
+	std::vector<double> ret;
+	ret.reserve(results.size());
+	for (unsigned int i = 0; i < results.size(); i++) {
+		const SeasonResult& r = results[i];
+		if (metric == "Hatch_Days") { ret.push_back(r.hatchDays); }
+		else if (metric == "Total_Neglect") { ret.push_back(r.totNeglect); }
+		else if (metric == "Max_Neglect") { ret.push_back(r.maxNeglect); }
+		else if (metric == "End_Energy_F") { ret.push_back(r.endEnergy_F); }
+		else if (metric == "Mean_Energy_F") { ret.push_back(r.meanEnergy_F); }
+		else if (metric == "Var_Energy_F") { ret.push_back(r.varEnergy_F); }
+		else if (metric == "End_Energy_M") { ret.push_back(r.endEnergy_M); }
+		else if (metric == "Mean_Energy_M") { ret.push_back(r.meanEnergy_M); }
+		else if (metric == "Var_Energy_M") { ret.push_back(r.varEnergy_M); }
+	}
+	return ret;
+}
+
+// Metrics an engine doesn't keep are NaN in its results
+static bool metricRecorded(const std::vector<SeasonResult>& results, const std::string& metric)
+{
+	return results.empty() || !std::isnan(seasonMetric(results, metric)[0]);
+}
+
+std::vector<EquivalenceTest> compareSeasons(const std::vector<SeasonResult>& reference,
+                                            const std::vector<SeasonResult>& candidate,
+                                            double alpha, int bootstrapResamples,
+                                            std::mt19937* randGen)
+{
+	std::vector<std::string> allMetrics = { "Hatch_Days", "Total_Neglect", "Max_Neglect",
+	                                        "End_Energy_F", "Mean_Energy_F", "Var_Energy_F" };
+	if (reference.size() > 0 && reference[0].numParents == 2) {
+		allMetrics.push_back("End_Energy_M");
+		allMetrics.push_back("Mean_Energy_M");
+		allMetrics.push_back("Var_Energy_M");
+	}
+
+	// Only metrics both engines keep
+	std::vector<std::string> metrics;
+	for (unsigned int m = 0; m < allMetrics.size(); m++) {
+		if (metricRecorded(reference, allMetrics[m]) && metricRecorded(candidate, allMetrics[m])) {
+			metrics.push_back(allMetrics[m]);
+		}
+	}
+
+	// One chi-square test, then a KS test and a bootstrap interval per metric
+	double testAlpha = alpha / (1 + 2 * metrics.size());
+
+	std::vector<EquivalenceTest> ret;
+
+	EquivalenceTest hatch = EquivalenceTest();
+	hatch.metric = "Hatch_Result";
+	hatch.test = "chi_square";
+	hatch.statistic = chiSquareHomogeneity(hatchResultCounts(reference), hatchResultCounts(candidate), &hatch.pValue);
+	hatch.pass = hatch.pValue >= testAlpha;
+	ret.push_back(hatch);
+
+	for (unsigned int m = 0; m < metrics.size(); m++) {
+		std::vector<double> a = seasonMetric(reference, metrics[m]);
+		std::vector<double> b = seasonMetric(candidate, metrics[m]);
+
+		EquivalenceTest ks = EquivalenceTest();
+		ks.metric = metrics[m];
+		ks.test = "ks";
+		ks.statistic = ksTwoSample(a, b, &ks.pValue);
+		ks.pass = ks.pValue >= testAlpha;
+		ret.push_back(ks);
+
+		EquivalenceTest boot = EquivalenceTest();
+		boot.metric = metrics[m];
+		boot.test = "bootstrap_mean";
+		boot.statistic = vectorMean(b) - vectorMean(a);
+		boot.pValue = -1;
+		bootstrapMeanDifference(a, b, bootstrapResamples, 1 - testAlpha, randGen, &boot.ciLow, &boot.ciHigh);
+		boot.pass = boot.ciLow <= 0 && boot.ciHigh >= 0;
+		ret.push_back(boot);
+	}
+
+	return ret;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdint>
+
+#include "Season.hpp"
+#include "Scenario.hpp"
+#include "ForagingSchedule.hpp"
+#include "Species.hpp"
+
+/*
+Statistical equivalence of simulation engines.
+
+An alternative engine (batched, parallel, reduced precision, ...) may
+consume random numbers differently from breedingSeason(), so its seasons
+can't be compared bit for bit. Instead a reference and a candidate engine
+each run the same combination from independent seeds, and their outcome
+distributions are compared: hatch results with a chi-square test, season
+length, neglect and energies with two-sample Kolmogorov-Smirnov tests and
+bootstrap confidence intervals for the difference in means.
+*/
+
+// One combination's replicates, as handed to an engine
+struct EngineJob {
+    const Scenario* scenario;
+    int scenarioIndex;
+    long comboIndex;
+    ComboParams combo;
+    int replicates;
+    uint64_t baseSeed;              // seed replicates from this (see replicateSeed())
+    const ForagingSchedule* foragingSchedule;
+    SpeciesId species;
+};
+
+// An engine fills one SeasonResult per replicate
+typedef void (*SeasonEngine)(const EngineJob& job, std::vector<SeasonResult>& results);
+
+struct EquivalenceEngine {
+    std::string name;
+    SeasonEngine run;
+};
+
+/*
+Every registered engine.
+"reference" is the original model: Parent and Egg objects run through a
+frozen copy of the original breedingSeason() loop with full daily energy
+records. "specialized" is the sweep engine of runModel(), a SeasonMode
+kernel with running energy sums. "colony_float64", "colony_float32" and
+"colony_fixed32" run every replicate as a nest of one colony (see
+Colony.hpp) in that energy representation; they keep no energy means or
+variances and can't run one-parent scenarios (no results).
+New engines are added to this list.
+*/
+const std::vector<EquivalenceEngine>& equivalenceEngines();
+
+// Engine with the given name, or nullptr
+SeasonEngine findEngine(const std::string& name);
+
+// A single test of one metric
+struct EquivalenceTest {
+    std::string metric;             // e.g. "Hatch_Result", "Hatch_Days"
+    std::string test;               // "chi_square", "ks" or "bootstrap_mean"
+    double statistic;               // chi-square, KS D, or candidate - reference mean
+    double pValue;                  // -1 for bootstrap intervals
+    double ciLow;                   // bootstrap interval (0 for other tests)
+    double ciHigh;
+    bool pass;
+};
+
+/*
+Chi-square test of homogeneity for two samples of category counts.
+Categories empty in both samples are dropped.
+@param pValue set to the upper tail probability (1 if nothing to compare)
+@return chi-square statistic
+*/
+double chiSquareHomogeneity(const std::vector<long>& a, const std::vector<long>& b, double* pValue);
+
+/*
+Two-sample Kolmogorov-Smirnov test, with the asymptotic p-value.
+Ties are stepped over together, so for discrete values (days, neglect)
+the test is conservative.
+@param pValue set to the upper tail probability
+@return largest difference between the empirical distribution functions
+*/
+double ksTwoSample(std::vector<double> a, std::vector<double> b, double* pValue);
+
+/*
+Bootstrap interval for mean(b) - mean(a), from the bootstrap standard
+error of the difference
+@param level coverage of the interval (e.g. 0.99)
+@param randGen ptr to the random device used for resampling
+*/
+void bootstrapMeanDifference(const std::vector<double>& a, const std::vector<double>& b,
+                             int resamples, double level, std::mt19937* randGen,
+                             double* low, double* high);
+
+/*
+Compare a candidate's seasons against the reference's for one combination.
+Each test passes at level alpha / (number of tests), so alpha bounds the
+chance of a false failure for the whole combination.
+Male metrics are skipped for one-parent seasons.
+*/
+std::vector<EquivalenceTest> compareSeasons(const std::vector<SeasonResult>& reference,
+                                            const std::vector<SeasonResult>& candidate,
+                                            double alpha, int bootstrapResamples,
+                                            std::mt19937* randGen);
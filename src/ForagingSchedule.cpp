@@ -0,0 +1,152 @@
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <cstdlib>
+
+#include "ForagingSchedule.hpp"
+
+ForagingSchedule::ForagingSchedule(int days_):
+	days(days_ > 0 ? days_ : 1),
+	meanOffsets(std::vector<double>(days_ > 0 ? days_ : 1, 0.0)),
+	sdScales(std::vector<double>(days_ > 0 ? days_ : 1, 1.0))
+{}
+
+ForagingSchedule::ForagingSchedule(const double* meanOffsets_, const double* sdScales_, int days_):
+	days(days_),
+	meanOffsets(std::vector<double>(meanOffsets_, meanOffsets_ + days_)),
+	sdScales(std::vector<double>(sdScales_, sdScales_ + days_))
+{}
+
+// Parse a whole field as a finite number; false on anything else (nan and inf included)
+static bool parseField(const std::string& field, double* x)
+{
+	char* end = nullptr;
+	*x = std::strtod(field.c_str(), &end);
+	return !field.empty() && *end == '\0' && std::isfinite(*x);
+}
+
+bool ForagingSchedule::readFile(std::string fname, std::string* error)
+{
+	std::ifstream infile(fname);
+	if (!infile.is_open()) {
+		*error = "could not open " + fname;
+		return false;
+	}
+
+	std::vector<double> fileOffsets;
+	std::vector<double> fileScales;
+
+	// Skip header
+	std::string line;
+	std::getline(infile, line);
+
+	int lineNumber = 1;
+	double firstDay = 0;
+	while (std::getline(infile, line)) {
+		lineNumber++;
+		if (!line.empty() && line[line.size()-1] == '\r') {
+			line.erase(line.size() - 1);
+		}
+		if (line.empty()) {
+			continue;
+		}
+		std::string where = fname + " line " + std::to_string(lineNumber) + ": ";
+
+		std::stringstream ss(line);
+		std::vector<std::string> fields;
+		std::string field;
+		while (std::getline(ss, field, ',')) {
+			fields.push_back(field);
+		}
+		double day, offset, scale;
+		if (fields.size() != 3 || !parseField(fields[0], &day) ||
+		    !parseField(fields[1], &offset) || !parseField(fields[2], &scale)) {
+			*error = where + "expected Day,Mean_Offset,SD_Scale numbers: " + line;
+			return false;
+		}
+		if (scale < 0) {
+			*error = where + "SD_Scale can't be negative: " + line;
+			return false;
+		}
+
+		// Days run on from the first (0 or 1) without gaps
+		if (fileOffsets.empty() && (day == 0 || day == 1)) {
+			firstDay = day;
+		}
+		if (day != firstDay + fileOffsets.size()) {
+			*error = where + "expected day " + std::to_string((long)firstDay + (long)fileOffsets.size()) + ": " + line;
+			return false;
+		}
+		fileOffsets.push_back(offset);
+		fileScales.push_back(scale);
+	}
+
+	if (fileOffsets.empty()) {
+		*error = fname + ": no days";
+		return false;
+	}
+
+	this->days = fileOffsets.size();
+	this->meanOffsets = fileOffsets;
+	this->sdScales = fileScales;
+	return true;
+}
+
+ForagingSchedule ForagingSchedule::generate(const SeasonProfile& profile, double yearEffect, std::mt19937* randGen)
+{
+	ForagingSchedule ret = ForagingSchedule(profile.days);
+
+	std::normal_distribution<double> standardNormal(0.0, 1.0);
+	std::uniform_real_distribution<double> unif(0.0, 1.0);
+
+	double pi = std::acos(-1.0);
+	double rho = profile.anomalyAutocorr;
+	double anomaly = profile.anomalySD * standardNormal(*randGen);
+	int stormDaysLeft = 0;
+
+	for (int d = 0; d < ret.days; d++) {
+		// Seasonal trend and shape
+		double offset = yearEffect
+		              + profile.trendPerDay * d
+		              + profile.seasonalAmplitude * std::sin(pi * d / ret.days);
+
+		// Autocorrelated daily anomaly (stationary AR(1))
+		if (d > 0) {
+			anomaly = rho * anomaly + profile.anomalySD * std::sqrt(1 - rho * rho) * standardNormal(*randGen);
+		}
+		offset += anomaly;
+
+		// Storm events depress and destabilize foraging for a few days
+		double scale = 1.0;
+		if (stormDaysLeft == 0 && unif(*randGen) < profile.stormRate) {
+			stormDaysLeft = profile.stormLength;
+		}
+		if (stormDaysLeft > 0) {
+			offset -= profile.stormDepth;
+			scale = profile.stormSDScale;
+			stormDaysLeft--;
+		}
+
+		ret.meanOffsets[d] = offset;
+		ret.sdScales[d] = scale;
+	}
+
+	return ret;
+}
+
+std::vector<ForagingSchedule> ForagingSchedule::generateYears(const SeasonProfile& profile, int years, std::mt19937* randGen)
+{
+	std::vector<ForagingSchedule> ret;
+	std::normal_distribution<double> standardNormal(0.0, 1.0);
+
+	double rho = profile.yearEffectAutocorr;
+	double yearEffect = profile.yearEffectSD * standardNormal(*randGen);
+	for (int y = 0; y < years; y++) {
+		if (y > 0) {
+			yearEffect = rho * yearEffect + profile.yearEffectSD * std::sqrt(1 - rho * rho) * standardNormal(*randGen);
+		}
+		ret.push_back(generate(profile, yearEffect, randGen));
+	}
+
+	return ret;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <random>
+
+/*
+Settings for a procedurally generated season of foraging conditions.
+All offsets are in kJ and are added to a combination's foraging mean;
+SD scales multiply a combination's foraging SD.
+*/
+struct SeasonProfile {
+    int days;                       // table length (days past the end reuse the last day)
+    double trendPerDay;             // linear seasonal trend in the foraging mean
+    double seasonalAmplitude;       // amplitude of a single half-sine over the season (peak mid-season)
+    double stormRate;               // daily probability that a storm begins
+    int stormLength;                // days each storm lasts
+    double stormDepth;              // drop in foraging mean during a storm
+    double stormSDScale;            // foraging SD multiplier during a storm
+    double anomalySD;               // stationary SD of daily AR(1) anomalies
+    double anomalyAutocorr;         // lag-1 autocorrelation of daily anomalies
+    double yearEffectSD;            // stationary SD of the per-year offset
+    double yearEffectAutocorr;      // lag-1 autocorrelation of year offsets across years
+};
+
+/*
+Day-indexed foraging conditions for a whole season.
+
+Each day holds a foraging mean offset and an SD scale, relative to the
+foraging mean and SD of a parameter combination. Tables are built once
+per scenario (from a file or procedurally) and are read-only afterwards,
+so any number of Parents (and threads) can share a single schedule.
+*/
+class ForagingSchedule {
+
+public:
+
+    // Constructor, neutral conditions (no offset, unit scale) for a number of days
+    ForagingSchedule(int days);
+
+    // Constructor, copying per-day offsets and scales from caller arrays
+    ForagingSchedule(const double* meanOffsets_, const double* sdScales_, int days_);
+
+    /*
+    Read a schedule from a CSV file with a header line and the columns
+    Day,Mean_Offset,SD_Scale (days numbered from 0 or 1, in order, none missing;
+    finite values, SD_Scale not negative)
+    @param error set to what is wrong (and on which line) on failure
+    @return true if the file was read
+    */
+    bool readFile(std::string fname, std::string* error);
+
+    /*
+    Generate a single season
+    @param yearEffect offset (kJ) applied to every day of this season
+    */
+    static ForagingSchedule generate(const SeasonProfile& profile, double yearEffect, std::mt19937* randGen);
+
+    // Generate consecutive seasons linked by autocorrelated year effects
+    static std::vector<ForagingSchedule> generateYears(const SeasonProfile& profile, int years, std::mt19937* randGen);
+
+    // Lookups (days past the end of the table reuse the last day)
+    double getMeanOffset(int day) const { return this->meanOffsets[day < this->days ? day : this->days - 1]; }
+    double getSDScale(int day) const { return this->sdScales[day < this->days ? day : this->days - 1]; }
+    int getDays() const { return this->days; }
+
+private:
+
+    int days;
+    std::vector<double> meanOffsets;    // per-day foraging mean offset (kJ)
+    std::vector<double> sdScales;       // per-day foraging SD multiplier
+};
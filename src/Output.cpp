@@ -0,0 +1,59 @@
+#include "Output.hpp"
+
+void writeSeasonHeader(std::ostream& out)
+{
+	out << "Iteration" << ","
+	    << "Min_Energy_Thresh_F" << ","
+	    << "Max_Energy_Thresh_F" << ","
+	    << "Min_Energy_Thresh_M" << ","
+	    << "Max_Energy_Thresh_M" << ","
+	    << "Foraging_Condition_Mean" << ","
+	    << "Foraging_Condition_SD" << ","
+	    << "Egg_Tolerance" << ","
+	    << "Egg_Cost" << ","
+	    << "Num_Parents" << ","
+	    << "Hatch_Result" << ","
+	    << "Hatch_Days" << ","
+	    << "Total_Neglect" << ","
+	    << "Max_Neglect" << ","
+	    << "End_Energy_F" << ","
+	    << "Mean_Energy_F" << ","
+	    << "Var_Energy_F" << ","
+	    << "Dead_F" << ","
+	    << "End_Energy_M" << ","
+	    << "Mean_Energy_M" << ","
+	    << "Var_Energy_M" << ","
+	    << "Dead_M" << ","
+	    << "Season_History" << "\n";
+}
+
+/*
+Rows end in a plain newline rather than std::endl, so the stream
+is only flushed when its buffer fills (or the caller flushes it)
+*/
+void writeSeasonRow(std::ostream& out, int iteration, const ComboParams& combo, const SeasonResult& result)
+{
+	out << iteration << ","
+	    << combo.minEnergyThresh_F << ","
+	    << combo.maxEnergyThresh_F << ","
+	    << combo.minEnergyThresh_M << ","
+	    << combo.maxEnergyThresh_M << ","
+	    << combo.foragingMean << ","
+	    << combo.foragingSD << ","
+	    << combo.eggTolerance << ","
+	    << combo.eggCost << ","
+	    << result.numParents << ","
+	    << result.hatchResult << ","
+	    << result.hatchDays << ","
+	    << result.totNeglect << ","
+	    << result.maxNeglect << ","
+	    << result.endEnergy_F << ","
+	    << result.meanEnergy_F << ","
+	    << result.varEnergy_F << ","
+	    << result.dead_F << ","
+	    << result.endEnergy_M << ","
+	    << result.meanEnergy_M << ","
+	    << result.varEnergy_M << ","
+	    << result.dead_M << ","
+	    << result.seasonHistory << "\n";
+}
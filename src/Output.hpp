@@ -0,0 +1,11 @@
+#pragma once
+
+#include <ostream>
+
+#include "Season.hpp"
+
+// Write the sims_*.csv header line
+void writeSeasonHeader(std::ostream& out);
+
+// Write one replicate as a sims_*.csv row
+void writeSeasonRow(std::ostream& out, int iteration, const ComboParams& combo, const SeasonResult& result);
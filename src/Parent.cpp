@@ -1,19 +1,30 @@
 #include "Parent.hpp"
 
-Parent::Parent(Sex sex_, std::mt19937* randGen_):
+/*
+Constructor (see Parent.hpp file).
+Default thresholds are deterministic: incubation ceases below the
+metabolic cost of foraging for a day, and foraging ceases above the
+mean energy at which parents were found to start incubating (BASE_ENERGY)
+*/
+Parent::Parent(Sex sex_, std::mt19937* randGen_, const SpeciesParams* species_):
 	sex(sex_),
 	randGen(randGen_),
-	energy(MAX_ENERGY_THRESHOLD),
-	baseEnergy(MAX_ENERGY_THRESHOLD),
-	incubatingMetabolism(INCUBATING_METABOLISM),
-	foragingMetabolism(FORAGING_METABOLISM),
-    minEnergyThresh(MIN_ENERGY_THRESHOLD),
-	maxEnergyThresh(MAX_ENERGY_THRESHOLD),
-	foragingMean(FORAGING_MEAN),
-	foragingSD(FORAGING_SD),
-	foragingDistribution(std::normal_distribution<double>(foragingMean, foragingSD)),
+	energy(species_->baseEnergy),
+	species(species_),
+    minEnergyThresh(species_->foragingMetabolism),
+	maxEnergyThresh(species_->baseEnergy),
+	foragingMean(species_->foragingMean),
+	foragingSD(species_->foragingSD),
     foragingDays(0),
-	energyRecord(std::vector<double>())
+	day(0),
+	foragingDraws(0),
+	foragingSchedule(nullptr),
+	foragingDistribution(std::normal_distribution<double>(0.0, 1.0)),
+	energyRecord(std::vector<double>()),
+	energyDays(0),
+	endEnergy(0),
+	energyMean(0),
+	energySquares(0)
 {
 	/*
 	Females begin the season incubating, males begin foraging
@@ -27,11 +38,19 @@ Parent::Parent(Sex sex_, std::mt19937* randGen_):
 	}
 }
 
+template <bool RecordEnergy, class Species>
 void Parent::parentDay()
 {
 	if (this->state != State::dead) {
 		// Record energy values for each day
-		this->energyRecord.push_back(this->energy);
+		if (RecordEnergy) {
+			this->energyRecord.push_back(this->energy);
+		}
+		this->energyDays++;
+		this->endEnergy = this->energy;
+		double deviation = this->energy - this->energyMean;
+		this->energyMean += deviation / this->energyDays;
+		this->energySquares += deviation * (this->energy - this->energyMean);
 	}
 
 	// Did the parent die?
@@ -40,9 +59,11 @@ void Parent::parentDay()
 	}
 
 	if (this->state != State::dead) {
-	    if (this->state == State::incubating) { incubate(); } 
-        else if (this->state == State::foraging) { forage(); }
+	    if (this->state == State::incubating) { incubate<Species>(); } 
+        else if (this->state == State::foraging) { forage<Species>(); }
 	}
+
+	this->day++;
 }
 
 void Parent::changeState()
@@ -58,10 +79,11 @@ void Parent::changeState()
 	}
 }
 
+template <class Species>
 void Parent::incubate()
 {
 	// Lose energy to metabolism
-	this->energy -= this->incubatingMetabolism;
+	this->energy -= SpeciesTraits<Species>::incubatingMetabolism(this->species);
 
 	// Incubating -> Foraging depending on energy
 	if (stopIncubating()) {
@@ -77,15 +99,27 @@ Parents lose energy to (heightened) metabolism,
 and have the change to gain energy as a draw from
 a random distribution.
 */
+template <class Species>
 void Parent::forage()
 {
 	this->foragingDays++;
 
 	// Lose energy to metabolism
-	this->energy -= this->foragingMetabolism;
+	this->energy -= SpeciesTraits<Species>::foragingMetabolism(this->species);
 
-	// Gain metabolic intake given normal distribution of energy outcomes
-	double foragingEnergy = foragingDistribution(*randGen);
+	/*
+	Gain metabolic intake given normal distribution of energy outcomes.
+	With a foraging schedule, the day's conditions are a table lookup
+	relative to this parent's foraging mean and SD.
+	*/
+	double mean = this->foragingMean;
+	double sd = this->foragingSD;
+	if (this->foragingSchedule != nullptr) {
+		mean += this->foragingSchedule->getMeanOffset(this->day);
+		sd *= this->foragingSchedule->getSDScale(this->day);
+	}
+	double foragingEnergy = mean + sd * foragingDistribution(*randGen);
+	this->foragingDraws++;
     if (foragingEnergy < 0) {
         foragingEnergy = 0;
     }
@@ -142,6 +176,14 @@ void Parent::setForagingDistribution(double foragingMean_, double foragingSD_)
 {
 	this->foragingMean = foragingMean_;
 	this->foragingSD = foragingSD_;
+}
 
-	this->foragingDistribution = std::normal_distribution<double>(foragingMean_, foragingSD_);
-}
\ No newline at end of file
+// Every recording variant and species pack is compiled here for the season kernels
+template void Parent::parentDay<true, RuntimeSpecies>();
+template void Parent::parentDay<false, RuntimeSpecies>();
+template void Parent::parentDay<true, LeachsStormPetrel>();
+template void Parent::parentDay<false, LeachsStormPetrel>();
+template void Parent::parentDay<true, ForkTailedStormPetrel>();
+template void Parent::parentDay<false, ForkTailedStormPetrel>();
+template void Parent::parentDay<true, EuropeanStormPetrel>();
+template void Parent::parentDay<false, EuropeanStormPetrel>();
@@ -5,12 +5,15 @@
 #include <chrono>
 #include <iostream>
 
+#include "ForagingSchedule.hpp"
+#include "Species.hpp"
+
 enum class Sex { male, female };
 enum class State { incubating, foraging, dead };
 
 /*
-A breeding adult Leach's Storm-petrel parent, flying back and forth from
-the foraging ground to the breeding ground
+A breeding adult storm-petrel parent (Leach's by default), flying back and
+forth from the foraging ground to the breeding ground
 */
 class Parent {
 
@@ -20,16 +23,22 @@ public:
     Constructor
     @param sex_ sex of the bird (enum, male or female)
     @param randGen_ ptr to a single-seeded random number device
+    @param species_ shared species parameters (Leach's Storm-petrel by default)
     */
-    Parent(Sex sex_, std::mt19937* randGen_);
+    Parent(Sex sex_, std::mt19937* randGen_, const SpeciesParams* species_ = speciesParams<LeachsStormPetrel>());
 
     /*
     Parent behavior over a single day.
     If incubating, incubate.
     If foraging, forage.
     See individual functions for state-specific details.
+    @tparam RecordEnergy also keep the full daily energy record (running
+            sums for the end/mean/variance summaries are always kept)
+    @tparam Species compile-time species pack matching this parent's
+            species parameters, or RuntimeSpecies to read them
     */
-    void parentDay();
+    template <bool RecordEnergy, class Species = RuntimeSpecies> void parentDay();
+    void parentDay() { parentDay<true>(); }
 
     /*
     Function that changes states, called once the
@@ -41,23 +50,24 @@ public:
     void setState(State state_) { this->state = state_ ; }
     void setPrevDayState(State state_) { this->previousDayState = state_; }
     void setEnergy(double energy_) { this->energy = energy_; }
-    void setBaseEnergy(double baseEnergy_) { this->baseEnergy = baseEnergy_; }
-    void setIncubatingMetabolism(double incubatingMetabolism_) { this->incubatingMetabolism = incubatingMetabolism_; }
-    void setForagingMetabolism(double foragingMetabolism_) { this->foragingMetabolism = foragingMetabolism_; }
     void setMinEnergyThresh(double minEnergyThresh_) { this->minEnergyThresh = minEnergyThresh_; }
     void setMaxEnergyThresh(double maxEnergyThresh_) { this->maxEnergyThresh = maxEnergyThresh_; }
     void setForagingDistribution(double foragingMean_, double foragingSD_);
+    void setForagingSchedule(const ForagingSchedule* foragingSchedule_) { this->foragingSchedule = foragingSchedule_; }
 
     // Getters
     Sex getSex() { return this->sex; }
     double getEnergy() { return this->energy; }
-    double getbaseEnergy() { return this->baseEnergy; }
-    double getIncubatingMetabolism() { return this->incubatingMetabolism; }
-    double getForagingMetabolism() { return this->foragingMetabolism; }
+    double getbaseEnergy() { return this->species->baseEnergy; }
+    double getIncubatingMetabolism() { return this->species->incubatingMetabolism; }
+    double getForagingMetabolism() { return this->species->foragingMetabolism; }
+    const SpeciesParams* getSpecies() { return this->species; }
     double getMinEnergyThresh() { return this->minEnergyThresh; }
     double getMaxEnergyThresh() { return this->maxEnergyThresh; }
     double getForagingMean() { return this->foragingMean; }
     double getForagingSD() { return this->foragingSD; }
+    int getDay() { return this->day; }
+    int getForagingDraws() { return this->foragingDraws; }
 
     State getState() { return this->state; }
     bool isAlive() { return this->state != State::dead; }
@@ -65,47 +75,18 @@ public:
     State getPreviousDayState() { return this->previousDayState; }
     
     std::vector<double> getEnergyRecord() { return this->energyRecord; }
+    void takeEnergyRecord(std::vector<double>* out) { out->swap(this->energyRecord); }
+
+    // Energy summaries from running sums
+    int getEnergyDays() { return this->energyDays; }
+    double getEndEnergy() { return this->endEnergy; }
+    double getMeanEnergy() { return this->energyMean; }
+    double getVarEnergy() { return this->energySquares / this->energyDays; }
     
 private:
-    /*
-    Parameters for the mean and standard deviation for foraging,
-    in kJ of metabolic intake. Modeled as a normal distribution.
-    Montevecchi et al. (1992) for Newfoundland parameters
-    */
-    constexpr static double FORAGING_MEAN = 162.0;
-    constexpr static double FORAGING_SD = 47.0;
 
-    /*
-    Initial energy buffer at the beginning of the incubation season (kJ)
-    Derived from the mean energy adults had at the beginning of observed
-    incubation bouts in Ricklefs et al. (1986)
-    */
-    constexpr static double BASE_ENERGY = 766.0;
-
-    /*
-    Metabolic rate requirements while incubating and foraging (kJ/day)
-    From Ricklefs et al. (1986)
-    and further discussion in Montevecchi et al. (1992)
-    */
-    constexpr static double INCUBATING_METABOLISM = 52.0;
-    constexpr static double FORAGING_METABOLISM = 123.0;
-
-    /*
-    The deterministc threshold below which incubation ceases
-    (at the end of the day), here equaling the metabolic cost of
-    foraging for a day.
-    */
-    constexpr static double MIN_ENERGY_THRESHOLD = FORAGING_METABOLISM;
-
-    /*
-    The deterministic threshold above which foraging ceases
-    (at the end of the day), here equaling the mean amount of energy at
-    which parents were found to start incubating (BASE_ENERGY)
-    */
-    constexpr static double MAX_ENERGY_THRESHOLD = BASE_ENERGY;
-
-    void incubate();
-    void forage();
+    template <class Species> void incubate();
+    template <class Species> void forage();
     bool stopIncubating();
     bool stopForaging();
 
@@ -114,16 +95,22 @@ private:
     State state;                    // current state
     State previousDayState;         // state during the previous day
     double energy;                  // current energy value (kJ)
-    double baseEnergy;              // starting energy value
-    double incubatingMetabolism;    // daily metabolism cost for incubation
-    double foragingMetabolism;      // daily metabolism cost for foraging
+    const SpeciesParams* species;   // shared species parameters (metabolism, base energy)
     double minEnergyThresh;         // hunger threshold (incubating->foraging)
     double maxEnergyThresh;         // satiation threshold (foraging->incubating)
 
     double foragingMean;            // mean for distribution of foraging intake values
     double foragingSD;              // standard deviation for distribution of foraging intake values
     int foragingDays;               // number of days spent foraging
+    int day;                        // days elapsed in the season
+    int foragingDraws;              // foraging intake draws across the season
 
-    std::normal_distribution<double> foragingDistribution;      // Normal distribution to draw stochastic foraging energy intakes
+    const ForagingSchedule* foragingSchedule;                   // optional day-indexed foraging conditions (shared, read-only)
+    std::normal_distribution<double> foragingDistribution;      // Standard normal, scaled per day to draw stochastic foraging energy intakes
     std::vector<double> energyRecord;                           // energy values across all days
+
+    int energyDays;                 // number of days with a recorded energy value
+    double endEnergy;               // last recorded energy value
+    double energyMean;              // running mean and sum of squared deviations (Welford's method,
+    double energySquares;           // which doesn't cancel like a sum of squares)
 };
\ No newline at end of file
@@ -0,0 +1,400 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+#include "QuantileSketch.hpp"
+
+static const double NA = std::numeric_limits<double>::quiet_NaN();
+
+const char* const SKETCH_METRICS[NUM_SKETCH_METRICS] = {
+	"Hatch_Days", "Total_Neglect", "Max_Neglect",
+	"End_Energy_F", "Mean_Energy_F", "End_Energy_M", "Mean_Energy_M",
+	"Incubation_Bout", "Foraging_Bout"
+};
+
+static const int NUM_SKETCH_QUANTILES = 5;
+static const double SKETCH_QUANTILES[NUM_SKETCH_QUANTILES] = { 0.05, 0.25, 0.5, 0.75, 0.95 };
+static const char* const SKETCH_QUANTILE_NAMES[NUM_SKETCH_QUANTILES] = { "Q05", "Q25", "Median", "Q75", "Q95" };
+
+QuantileSketch::QuantileSketch(double compression_):
+	compression(compression_),
+	centroids(std::vector<Centroid>()),
+	buffer(std::vector<Centroid>()),
+	totalWeight(0),
+	bufferWeight(0),
+	min(std::numeric_limits<double>::infinity()),
+	max(-std::numeric_limits<double>::infinity())
+{}
+
+void QuantileSketch::add(double x)
+{
+	Centroid c = { x, 1.0, true };
+	this->buffer.push_back(c);
+	this->bufferWeight += 1.0;
+	this->min = std::min(this->min, x);
+	this->max = std::max(this->max, x);
+
+	if (this->buffer.size() >= 5 * this->compression) {
+		compress();
+	}
+}
+
+void QuantileSketch::merge(const QuantileSketch& other)
+{
+	this->buffer.insert(this->buffer.end(), other.centroids.begin(), other.centroids.end());
+	this->buffer.insert(this->buffer.end(), other.buffer.begin(), other.buffer.end());
+	this->bufferWeight += other.totalWeight + other.bufferWeight;
+	this->min = std::min(this->min, other.min);
+	this->max = std::max(this->max, other.max);
+	compress();
+}
+
+/*
+Runs of equal values are first pooled into one exact centroid each. If
+that leaves no more than compression centroids, all of them exact, they
+are kept as they are: an exact histogram. Otherwise a greedy merge in
+order of the means, where a centroid may only grow while it spans at
+most one unit of the k1 scale function
+k(q) = compression / (2 pi) * asin(2q - 1), which keeps centroids near
+q = 0 and q = 1 small
+*/
+void QuantileSketch::compress()
+{
+	if (this->buffer.empty()) {
+		return;
+	}
+
+	// Exact centroids first among equal means, so each run of a value is contiguous
+	std::vector<Centroid> all = this->centroids;
+	all.insert(all.end(), this->buffer.begin(), this->buffer.end());
+	std::sort(all.begin(), all.end(), [](const Centroid& a, const Centroid& b) {
+		return a.mean < b.mean || (a.mean == b.mean && a.exact && !b.exact);
+	});
+
+	std::vector<Centroid> pooled;
+	bool allExact = true;
+	for (unsigned int i = 0; i < all.size(); i++) {
+		if (!pooled.empty() && pooled.back().exact && all[i].exact && pooled.back().mean == all[i].mean) {
+			pooled.back().weight += all[i].weight;
+		} else {
+			pooled.push_back(all[i]);
+			allExact = allExact && all[i].exact;
+		}
+	}
+
+	double total = this->totalWeight + this->bufferWeight;
+	this->buffer.clear();
+	this->totalWeight = total;
+	this->bufferWeight = 0;
+	if (allExact && pooled.size() <= this->compression) {
+		this->centroids = pooled;
+		return;
+	}
+
+	double normalizer = this->compression / (2 * M_PI);
+	auto k = [normalizer](double q) { return normalizer * std::asin(2 * std::min(1.0, q) - 1); };
+
+	std::vector<Centroid> merged;
+	merged.push_back(pooled[0]);
+	double weightSoFar = 0;
+	double kLimit = k(0) + 1;
+	for (unsigned int i = 1; i < pooled.size(); i++) {
+		Centroid& last = merged.back();
+		double q = (weightSoFar + last.weight + pooled[i].weight) / total;
+		if (k(q) <= kLimit) {
+			double weight = last.weight + pooled[i].weight;
+			last.mean += (pooled[i].mean - last.mean) * pooled[i].weight / weight;
+			last.exact = false;
+			last.weight = weight;
+		} else {
+			weightSoFar += last.weight;
+			kLimit = k(weightSoFar / total) + 1;
+			merged.push_back(pooled[i]);
+		}
+	}
+
+	this->centroids = merged;
+}
+
+/*
+A quantile falling on an exact centroid is its value. Otherwise, linear
+interpolation between centroid means, each centroid's weight centred on
+its mean; the tails interpolate to the exact min and max
+*/
+double QuantileSketch::quantile(double q)
+{
+	compress();
+	if (this->centroids.empty()) {
+		return NA;
+	}
+	if (this->centroids.size() == 1) {
+		return this->centroids[0].mean;
+	}
+
+	const std::vector<Centroid>& c = this->centroids;
+	double target = std::min(q * this->totalWeight, this->totalWeight * (1 - 1e-12));
+
+	double left = 0;
+	for (unsigned int i = 0; i < c.size(); i++) {
+		if (target < left + c[i].weight) {
+			if (c[i].exact) {
+				return c[i].mean;
+			}
+			break;
+		}
+		left += c[i].weight;
+	}
+
+	if (target < c[0].weight / 2) {
+		if (c[0].weight == 1) {
+			return this->min;
+		}
+		return this->min + (c[0].mean - this->min) * target / (c[0].weight / 2);
+	}
+
+	double cumulative = c[0].weight / 2;
+	for (unsigned int i = 0; i + 1 < c.size(); i++) {
+		double step = (c[i].weight + c[i + 1].weight) / 2;
+		if (target < cumulative + step) {
+			return c[i].mean + (c[i + 1].mean - c[i].mean) * (target - cumulative) / step;
+		}
+		cumulative += step;
+	}
+
+	const Centroid& last = c.back();
+	if (last.weight == 1) {
+		return this->max;
+	}
+	double tail = std::min(1.0, (target - cumulative) / (last.weight / 2));
+	return last.mean + (this->max - last.mean) * tail;
+}
+
+std::string QuantileSketch::serialize()
+{
+	compress();
+	std::string ret;
+	char buffer[64];
+	std::snprintf(buffer, sizeof(buffer), "%.17g;%.17g", this->min, this->max);
+	ret += buffer;
+	for (unsigned int i = 0; i < this->centroids.size(); i++) {
+		std::snprintf(buffer, sizeof(buffer), ";%.17g:%.17g:%d", this->centroids[i].mean, this->centroids[i].weight,
+		              this->centroids[i].exact ? 1 : 0);
+		ret += buffer;
+	}
+	return ret;
+}
+
+bool QuantileSketch::parse(const std::string& text, QuantileSketch* sketch)
+{
+	*sketch = QuantileSketch();
+
+	std::stringstream ss(text);
+	std::string item;
+	std::vector<std::string> items;
+	while (std::getline(ss, item, ';')) {
+		items.push_back(item);
+	}
+	if (items.size() < 2) {
+		return false;
+	}
+
+	char* end = nullptr;
+	sketch->min = std::strtod(items[0].c_str(), &end);
+	sketch->max = std::strtod(items[1].c_str(), &end);
+	for (unsigned int i = 2; i < items.size(); i++) {
+		std::size_t colon = items[i].find(':');
+		std::size_t exactColon = colon == std::string::npos ? colon : items[i].find(':', colon + 1);
+		if (exactColon == std::string::npos) {
+			return false;
+		}
+		Centroid c = { std::strtod(items[i].substr(0, colon).c_str(), &end),
+		               std::strtod(items[i].substr(colon + 1, exactColon - colon - 1).c_str(), &end),
+		               items[i].substr(exactColon + 1) == "1" };
+		sketch->centroids.push_back(c);
+		sketch->totalWeight += c.weight;
+	}
+	return true;
+}
+
+// Run lengths of days with and without a parent incubating
+static void addBouts(const std::string& history, char parent, QuantileSketch& incubation, QuantileSketch& foraging)
+{
+	std::size_t i = 0;
+	while (i < history.size()) {
+		bool incubating = history[i] == parent;
+		std::size_t start = i;
+		while (i < history.size() && (history[i] == parent) == incubating) {
+			i++;
+		}
+		(incubating ? incubation : foraging).add(i - start);
+	}
+}
+
+void ComboSketches::addSeason(const SeasonResult& result)
+{
+	this->metrics[0].add(result.hatchDays);
+	this->metrics[1].add(result.totNeglect);
+	this->metrics[2].add(result.maxNeglect);
+	this->metrics[3].add(result.endEnergy_F);
+	this->metrics[4].add(result.meanEnergy_F);
+	if (result.numParents == 2) {
+		this->metrics[5].add(result.endEnergy_M);
+		this->metrics[6].add(result.meanEnergy_M);
+	}
+
+	if (result.hatchResult == "hatched") {
+		addBouts(result.seasonHistory, 'F', this->metrics[7], this->metrics[8]);
+		if (result.numParents == 2) {
+			addBouts(result.seasonHistory, 'M', this->metrics[7], this->metrics[8]);
+		}
+	}
+}
+
+void ComboSketches::merge(const ComboSketches& other)
+{
+	for (int m = 0; m < NUM_SKETCH_METRICS; m++) {
+		this->metrics[m].merge(other.metrics[m]);
+	}
+}
+
+std::string comboKey(const ComboParams& combo, int numParents)
+{
+	std::ostringstream ss;
+	ss << combo.minEnergyThresh_F << ","
+	   << combo.maxEnergyThresh_F << ","
+	   << combo.minEnergyThresh_M << ","
+	   << combo.maxEnergyThresh_M << ","
+	   << combo.foragingMean << ","
+	   << combo.foragingSD << ","
+	   << combo.eggTolerance << ","
+	   << combo.eggCost << ","
+	   << numParents;
+	return ss.str();
+}
+
+static void writeKeyHeader(std::ostream& out)
+{
+	out << "Min_Energy_Thresh_F" << ","
+	    << "Max_Energy_Thresh_F" << ","
+	    << "Min_Energy_Thresh_M" << ","
+	    << "Max_Energy_Thresh_M" << ","
+	    << "Foraging_Condition_Mean" << ","
+	    << "Foraging_Condition_SD" << ","
+	    << "Egg_Tolerance" << ","
+	    << "Egg_Cost" << ","
+	    << "Num_Parents";
+}
+
+void writeQuantileHeader(std::ostream& out)
+{
+	writeKeyHeader(out);
+	out << ",N";
+	for (int m = 0; m < NUM_SKETCH_METRICS; m++) {
+		for (int q = 0; q < NUM_SKETCH_QUANTILES; q++) {
+			out << "," << SKETCH_METRICS[m] << "_" << SKETCH_QUANTILE_NAMES[q];
+		}
+	}
+	out << "\n";
+}
+
+void writeQuantileRow(std::ostream& out, const std::string& key, ComboSketches& sketches)
+{
+	std::string row = key;
+	row += ",";
+	row += std::to_string(static_cast<long>(sketches.metrics[0].getCount()));
+
+	char buffer[32];
+	for (int m = 0; m < NUM_SKETCH_METRICS; m++) {
+		for (int q = 0; q < NUM_SKETCH_QUANTILES; q++) {
+			row += ",";
+			double x = sketches.metrics[m].quantile(SKETCH_QUANTILES[q]);
+			if (x == x) {
+				std::snprintf(buffer, sizeof(buffer), "%.6g", x);
+				row += buffer;
+			}
+		}
+	}
+	row += "\n";
+	out.write(row.data(), row.size());
+}
+
+void writeSketchHeader(std::ostream& out)
+{
+	writeKeyHeader(out);
+	out << ",Metric,Sketch\n";
+}
+
+void writeSketchRows(std::ostream& out, const std::string& key, ComboSketches& sketches)
+{
+	for (int m = 0; m < NUM_SKETCH_METRICS; m++) {
+		out << key << "," << SKETCH_METRICS[m] << "," << sketches.metrics[m].serialize() << "\n";
+	}
+}
+
+bool mergeSketchFiles(const std::vector<std::string>& fnames, std::ostream& sketchOut, std::ostream& quantileOut)
+{
+	std::vector<std::string> keys;
+	std::vector<ComboSketches> merged;
+	std::unordered_map<std::string, int> index;
+
+	for (unsigned int f = 0; f < fnames.size(); f++) {
+		std::ifstream infile(fnames[f]);
+		if (!infile.is_open()) {
+			return false;
+		}
+
+		// Skip header
+		std::string line;
+		std::getline(infile, line);
+
+		while (std::getline(infile, line)) {
+			if (!line.empty() && line[line.size() - 1] == '\r') {
+				line.erase(line.size() - 1);
+			}
+			if (line.empty()) {
+				continue;
+			}
+
+			// Nine key fields, then the metric and its sketch
+			std::size_t pos = 0;
+			for (int field = 0; field < 9 && pos != std::string::npos; field++) {
+				pos = line.find(',', pos);
+				if (pos != std::string::npos) {
+					pos++;
+				}
+			}
+			std::size_t metricEnd = pos == std::string::npos ? pos : line.find(',', pos);
+			if (metricEnd == std::string::npos) {
+				return false;
+			}
+			std::string key = line.substr(0, pos - 1);
+			std::string metric = line.substr(pos, metricEnd - pos);
+
+			int m = std::find(SKETCH_METRICS, SKETCH_METRICS + NUM_SKETCH_METRICS, metric) - SKETCH_METRICS;
+			QuantileSketch sketch;
+			if (m == NUM_SKETCH_METRICS || !QuantileSketch::parse(line.substr(metricEnd + 1), &sketch)) {
+				return false;
+			}
+
+			if (index.find(key) == index.end()) {
+				index[key] = keys.size();
+				keys.push_back(key);
+				merged.push_back(ComboSketches());
+			}
+			merged[index[key]].metrics[m].merge(sketch);
+		}
+	}
+
+	writeSketchHeader(sketchOut);
+	writeQuantileHeader(quantileOut);
+	for (unsigned int i = 0; i < keys.size(); i++) {
+		writeSketchRows(sketchOut, keys[i], merged[i]);
+		writeQuantileRow(quantileOut, keys[i], merged[i]);
+	}
+	return true;
+}
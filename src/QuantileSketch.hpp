@@ -0,0 +1,112 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "Season.hpp"
+
+/*
+Mergeable quantile sketch (a merging t-digest, Dunning 2019).
+
+Values are kept as weighted centroids, small near the tails and larger
+towards the median, so extreme quantiles stay accurate in a few hundred
+bytes whatever the number of values. Equal values are pooled into one
+exact centroid, and while there are no more distinct values than the
+compression nothing else is merged, so discrete metrics (days, neglect,
+bouts) are held as an exact histogram and their quantiles are exact.
+Two sketches of parts of the same sample merge into a sketch of the
+whole, so sketches from sharded or parallel runs can be combined after
+the fact.
+*/
+class QuantileSketch {
+
+public:
+
+    /*
+    Constructor
+    @param compression_ roughly the number of centroids kept (accuracy vs size)
+    */
+    QuantileSketch(double compression_ = 100);
+
+    void add(double x);
+    void merge(const QuantileSketch& other);
+
+    // Interpolated quantile (NaN if the sketch is empty)
+    double quantile(double q);
+
+    double getCount() const { return this->totalWeight + this->bufferWeight; }
+
+    /*
+    Text form "min;max;mean:weight:exact;..." (exact is 1 for a centroid
+    of equal values) with doubles written at full precision, so a parsed
+    sketch equals the original
+    */
+    std::string serialize();
+
+    // Read a sketch written by serialize(); false if the text is malformed
+    static bool parse(const std::string& text, QuantileSketch* sketch);
+
+private:
+
+    struct Centroid {
+        double mean;
+        double weight;
+        bool exact;                     // every value equals the mean
+    };
+
+    // Merge buffered values into the centroids
+    void compress();
+
+    double compression;
+    std::vector<Centroid> centroids;    // sorted by mean
+    std::vector<Centroid> buffer;       // values added since the last compress()
+    double totalWeight;                 // weight in centroids
+    double bufferWeight;                // weight in buffer
+    double min;
+    double max;
+};
+
+/*
+Per-combination outcome distributions.
+Hatch_Days, neglect and energies are sketched over every season; bout
+lengths (untrimmed, both sexes pooled) over hatched seasons, like the
+bout means of processGroup(). Male metrics are left empty for one-parent
+seasons, and bouts need the season history.
+*/
+static const int NUM_SKETCH_METRICS = 9;
+extern const char* const SKETCH_METRICS[NUM_SKETCH_METRICS];
+
+struct ComboSketches {
+    QuantileSketch metrics[NUM_SKETCH_METRICS];
+
+    void addSeason(const SeasonResult& result);
+    void merge(const ComboSketches& other);
+};
+
+/*
+A combination's GROUP_KEYS (see R/process_simulation_results.r), formatted
+as in the sims_*.csv rows, so sketch output joins with processed_*.csv
+*/
+std::string comboKey(const ComboParams& combo, int numParents);
+
+/*
+quantiles_*.csv: one row per combination with 5%, 25%, 50%, 75% and 95%
+quantiles of every metric (<Metric>_Q05 ... <Metric>_Q95, empty when
+there were no values)
+*/
+void writeQuantileHeader(std::ostream& out);
+void writeQuantileRow(std::ostream& out, const std::string& key, ComboSketches& sketches);
+
+// sketches_*.csv: one serialized sketch per combination and metric
+void writeSketchHeader(std::ostream& out);
+void writeSketchRows(std::ostream& out, const std::string& key, ComboSketches& sketches);
+
+/*
+Merge sketches_*.csv files (e.g. shards of one sweep split by iteration),
+combination by combination, in order of first appearance
+@param sketchOut merged sketches_*.csv
+@param quantileOut quantiles_*.csv of the merged sketches
+@return false if a file can't be read or holds a malformed row
+*/
+bool mergeSketchFiles(const std::vector<std::string>& fnames, std::ostream& sketchOut, std::ostream& quantileOut);
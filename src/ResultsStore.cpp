@@ -0,0 +1,515 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "ResultsStore.hpp"
+
+static const std::size_t STORE_PAGE = 4096;
+static const double INF = std::numeric_limits<double>::infinity();
+static const double NA = std::numeric_limits<double>::quiet_NaN();
+
+static const int NUM_STORE_COLUMNS = NUM_GROUP_KEYS + NUM_PROCESSED_METRICS;
+
+// Directory entry: first row's keys, then every column's minimum, then maximum
+static const int DIRECTORY_ENTRY = NUM_GROUP_KEYS + 2 * NUM_STORE_COLUMNS;
+
+/*
+Row order: environment first, then strategy, so the usual queries over
+foraging conditions and egg parameters touch few blocks
+*/
+static const int SORT_KEYS[NUM_GROUP_KEYS] = { 4, 5, 6, 7, 0, 1, 2, 3, 8 };
+
+static std::size_t pageRound(std::size_t bytes)
+{
+	return STORE_PAGE * ((bytes + STORE_PAGE - 1) / STORE_PAGE);
+}
+
+// Keys of a combination in GROUP_KEYS order
+static void comboKeys(const ComboParams& combo, int numParents, double keys[NUM_GROUP_KEYS])
+{
+	keys[0] = combo.minEnergyThresh_F;
+	keys[1] = combo.maxEnergyThresh_F;
+	keys[2] = combo.minEnergyThresh_M;
+	keys[3] = combo.maxEnergyThresh_M;
+	keys[4] = combo.foragingMean;
+	keys[5] = combo.foragingSD;
+	keys[6] = combo.eggTolerance;
+	keys[7] = combo.eggCost;
+	keys[8] = numParents;
+}
+
+ResultsStoreWriter::ResultsStoreWriter():
+	rowOf(std::vector<long>()),
+	rows(0),
+	blockRows(0),
+	blocks(0),
+	mapping(nullptr),
+	size(0),
+	directory(nullptr),
+	data(nullptr)
+{}
+
+ResultsStoreWriter::~ResultsStoreWriter()
+{
+	close();
+}
+
+double* ResultsStoreWriter::cell(long row, int column)
+{
+	long block = row / this->blockRows;
+	long rowsInBlock = std::min(this->blockRows, this->rows - block * this->blockRows);
+	return this->data + block * this->blockRows * NUM_STORE_COLUMNS + column * rowsInBlock + row % this->blockRows;
+}
+
+bool ResultsStoreWriter::create(const std::string& fname, const std::string& scenarioName,
+                                const std::vector<ComboParams>& combos, int numParents, int blockRows)
+{
+	close();
+
+	this->rows = combos.size();
+	this->blockRows = std::max(1, blockRows);
+	this->blocks = (this->rows + this->blockRows - 1) / this->blockRows;
+
+	// Sort order of the combinations by their keys
+	std::vector< std::vector<double> > keys(this->rows, std::vector<double>(NUM_GROUP_KEYS));
+	for (long i = 0; i < this->rows; i++) {
+		comboKeys(combos[i], numParents, keys[i].data());
+	}
+	std::vector<long> order(this->rows);
+	for (long i = 0; i < this->rows; i++) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&keys](long a, long b) {
+		for (int k = 0; k < NUM_GROUP_KEYS; k++) {
+			if (keys[a][SORT_KEYS[k]] != keys[b][SORT_KEYS[k]]) {
+				return keys[a][SORT_KEYS[k]] < keys[b][SORT_KEYS[k]];
+			}
+		}
+		return false;
+	});
+	this->rowOf.assign(this->rows, 0);
+	for (long r = 0; r < this->rows; r++) {
+		this->rowOf[order[r]] = r;
+	}
+
+	std::vector<std::string> names(GROUP_KEYS, GROUP_KEYS + NUM_GROUP_KEYS);
+	std::vector<std::string> metricNames = processedMetricNames();
+	names.insert(names.end(), metricNames.begin(), metricNames.end());
+
+	uint16_t byteOrder = 1;
+	std::ostringstream header;
+	header << "lhsp_results_store 1\n"
+	       << "scenario " << scenarioName << "\n"
+	       << "dtype float64\n"
+	       << "byte_order " << (*reinterpret_cast<unsigned char*>(&byteOrder) == 1 ? "little" : "big") << "\n"
+	       << "rows " << this->rows << "\n"
+	       << "block_rows " << this->blockRows << "\n"
+	       << "blocks " << this->blocks << "\n"
+	       << "sort_keys";
+	for (int k = 0; k < NUM_GROUP_KEYS; k++) {
+		header << " " << GROUP_KEYS[SORT_KEYS[k]];
+	}
+	header << "\n"
+	       << "columns " << names.size() << "\n";
+	for (unsigned int c = 0; c < names.size(); c++) {
+		header << "column " << names[c] << "\n";
+	}
+
+	// The offsets are part of the header, so size it with room for them
+	std::size_t directoryOffset = pageRound(header.str().size() + 64);
+	std::size_t dataOffset = pageRound(directoryOffset + this->blocks * DIRECTORY_ENTRY * sizeof(double));
+	header << "directory_offset " << directoryOffset << "\n"
+	       << "data_offset " << dataOffset << "\n"
+	       << "end\n";
+	std::string text = header.str();
+
+	this->size = dataOffset + this->rows * NUM_STORE_COLUMNS * sizeof(double);
+	int fd = open(fname.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		return false;
+	}
+	if (ftruncate(fd, this->size) != 0) {
+		::close(fd);
+		return false;
+	}
+	void* mapped = mmap(nullptr, this->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (mapped == MAP_FAILED) {
+		return false;
+	}
+	this->mapping = static_cast<char*>(mapped);
+	this->directory = reinterpret_cast<double*>(this->mapping + directoryOffset);
+	this->data = reinterpret_cast<double*>(this->mapping + dataOffset);
+
+	std::memset(this->mapping, '\n', directoryOffset);
+	std::memcpy(this->mapping, text.data(), text.size());
+
+	for (long r = 0; r < this->rows; r++) {
+		for (int k = 0; k < NUM_GROUP_KEYS; k++) {
+			*cell(r, k) = keys[order[r]][k];
+		}
+		for (int c = NUM_GROUP_KEYS; c < NUM_STORE_COLUMNS; c++) {
+			*cell(r, c) = NA;
+		}
+	}
+	for (long b = 0; b < this->blocks; b++) {
+		double* entry = this->directory + b * DIRECTORY_ENTRY;
+		std::copy(keys[order[b * this->blockRows]].begin(), keys[order[b * this->blockRows]].end(), entry);
+		std::fill(entry + NUM_GROUP_KEYS, entry + NUM_GROUP_KEYS + NUM_STORE_COLUMNS, -INF);
+		std::fill(entry + NUM_GROUP_KEYS + NUM_STORE_COLUMNS, entry + DIRECTORY_ENTRY, INF);
+	}
+	return true;
+}
+
+void ResultsStoreWriter::setRow(long comboIndex, const SimsGroup& group)
+{
+	if (this->mapping == nullptr || comboIndex < 0 || comboIndex >= this->rows) {
+		return;
+	}
+	double values[NUM_PROCESSED_METRICS];
+	group.metrics(values);
+	long row = this->rowOf[comboIndex];
+	for (int m = 0; m < NUM_PROCESSED_METRICS; m++) {
+		*cell(row, NUM_GROUP_KEYS + m) = values[m];
+	}
+}
+
+void ResultsStoreWriter::close()
+{
+	if (this->mapping == nullptr) {
+		return;
+	}
+
+	// Zone maps; a column with no values in a block gets NaN bounds
+	for (long b = 0; b < this->blocks; b++) {
+		double* entry = this->directory + b * DIRECTORY_ENTRY;
+		long first = b * this->blockRows;
+		long last = std::min(this->rows, first + this->blockRows);
+		for (int c = 0; c < NUM_STORE_COLUMNS; c++) {
+			double min = INF;
+			double max = -INF;
+			for (long r = first; r < last; r++) {
+				double x = *cell(r, c);
+				if (x == x) {
+					min = std::min(min, x);
+					max = std::max(max, x);
+				}
+			}
+			entry[NUM_GROUP_KEYS + c] = min <= max ? min : NA;
+			entry[NUM_GROUP_KEYS + NUM_STORE_COLUMNS + c] = min <= max ? max : NA;
+		}
+	}
+
+	munmap(this->mapping, this->size);
+	this->mapping = nullptr;
+	this->directory = nullptr;
+	this->data = nullptr;
+	this->size = 0;
+}
+
+bool StorePredicate::matches(double x) const
+{
+	return (this->lowInclusive ? x >= this->low : x > this->low) &&
+	       (this->highInclusive ? x <= this->high : x < this->high);
+}
+
+bool StorePredicate::mayMatch(double min, double max) const
+{
+	if (min != min) {
+		return false;
+	}
+	return (this->lowInclusive ? max >= this->low : max > this->low) &&
+	       (this->highInclusive ? min <= this->high : min < this->high);
+}
+
+ResultsStore::ResultsStore():
+	columns(std::vector<std::string>()),
+	leadingColumn(-1),
+	rows(0),
+	blockRows(0),
+	blocks(0),
+	mapping(nullptr),
+	size(0),
+	directory(nullptr),
+	data(nullptr)
+{}
+
+ResultsStore::~ResultsStore()
+{
+	close();
+}
+
+bool ResultsStore::open(const std::string& fname)
+{
+	close();
+
+	int fd = ::open(fname.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+	this->size = fileStat.st_size;
+	void* mapped = mmap(nullptr, this->size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (mapped == MAP_FAILED) {
+		this->size = 0;
+		return false;
+	}
+	this->mapping = static_cast<const char*>(mapped);
+
+	// Header lines up to "end"
+	std::size_t directoryOffset = 0;
+	std::size_t dataOffset = 0;
+	std::string leadingKey;
+	bool isStore = false;
+	bool ended = false;
+	std::size_t pos = 0;
+	while (pos < this->size && !ended) {
+		const char* lineEnd = static_cast<const char*>(std::memchr(this->mapping + pos, '\n', this->size - pos));
+		if (lineEnd == nullptr) {
+			break;
+		}
+		std::string line(this->mapping + pos, lineEnd);
+		pos = lineEnd - this->mapping + 1;
+
+		std::string key = line.substr(0, line.find(' '));
+		std::string value = line.find(' ') == std::string::npos ? "" : line.substr(line.find(' ') + 1);
+		if (key == "lhsp_results_store") {
+			isStore = value == "1";
+		} else if (key == "rows") {
+			this->rows = std::atol(value.c_str());
+		} else if (key == "block_rows") {
+			this->blockRows = std::atol(value.c_str());
+		} else if (key == "blocks") {
+			this->blocks = std::atol(value.c_str());
+		} else if (key == "sort_keys") {
+			leadingKey = value.substr(0, value.find(' '));
+		} else if (key == "column") {
+			this->columns.push_back(value);
+		} else if (key == "directory_offset") {
+			directoryOffset = std::strtoull(value.c_str(), nullptr, 10);
+		} else if (key == "data_offset") {
+			dataOffset = std::strtoull(value.c_str(), nullptr, 10);
+		} else if (key == "end") {
+			ended = true;
+		}
+	}
+
+	if (!isStore || !ended || this->columns.size() != (std::size_t)NUM_STORE_COLUMNS || this->blockRows < 1 ||
+	    dataOffset + this->rows * NUM_STORE_COLUMNS * sizeof(double) > this->size ||
+	    directoryOffset + this->blocks * DIRECTORY_ENTRY * sizeof(double) > dataOffset) {
+		close();
+		return false;
+	}
+	this->leadingColumn = findColumn(leadingKey);
+	if (this->leadingColumn < 0 || this->leadingColumn >= NUM_GROUP_KEYS) {
+		close();
+		return false;
+	}
+	this->directory = reinterpret_cast<const double*>(this->mapping + directoryOffset);
+	this->data = reinterpret_cast<const double*>(this->mapping + dataOffset);
+	return true;
+}
+
+void ResultsStore::close()
+{
+	if (this->mapping != nullptr) {
+		munmap(const_cast<char*>(this->mapping), this->size);
+	}
+	this->columns.clear();
+	this->leadingColumn = -1;
+	this->rows = 0;
+	this->blockRows = 0;
+	this->blocks = 0;
+	this->mapping = nullptr;
+	this->size = 0;
+	this->directory = nullptr;
+	this->data = nullptr;
+}
+
+int ResultsStore::findColumn(const std::string& name) const
+{
+	for (unsigned int c = 0; c < this->columns.size(); c++) {
+		if (this->columns[c] == name) {
+			return c;
+		}
+	}
+	return -1;
+}
+
+bool ResultsStore::parsePredicate(const std::string& text, StorePredicate* predicate) const
+{
+	std::size_t opStart = text.find_first_of("=<>");
+	if (opStart == std::string::npos || opStart == 0) {
+		return false;
+	}
+	std::size_t opEnd = opStart + 1;
+	if (opEnd < text.size() && text[opEnd] == '=' && text[opStart] != '=') {
+		opEnd++;
+	}
+	std::string op = text.substr(opStart, opEnd - opStart);
+	std::string value = text.substr(opEnd);
+
+	*predicate = StorePredicate();
+	predicate->column = findColumn(text.substr(0, opStart));
+	predicate->low = -INF;
+	predicate->high = INF;
+	predicate->lowInclusive = true;
+	predicate->highInclusive = true;
+	if (predicate->column < 0 || value.empty()) {
+		return false;
+	}
+
+	char* end = nullptr;
+	if (op == "=") {
+		// Both bounds of a range are needed (strtod reads an empty one as 0)
+		std::size_t colon = value.find(':');
+		if (colon == 0 || colon == value.size() - 1) {
+			return false;
+		}
+		predicate->low = std::strtod(value.substr(0, colon).c_str(), &end);
+		if (*end != '\0') {
+			return false;
+		}
+		predicate->high = predicate->low;
+		if (colon != std::string::npos) {
+			predicate->high = std::strtod(value.substr(colon + 1).c_str(), &end);
+		}
+	} else {
+		double x = std::strtod(value.c_str(), &end);
+		if (op[0] == '>') {
+			predicate->low = x;
+			predicate->lowInclusive = op == ">=";
+		} else {
+			predicate->high = x;
+			predicate->highInclusive = op == "<=";
+		}
+	}
+	return *end == '\0';
+}
+
+// A value as fwrite() writes it: up to 15 significant digits, NaN as empty
+static void appendValue(std::string& row, double x)
+{
+	if (x != x) {
+		return;
+	}
+	char buffer[32];
+	std::snprintf(buffer, sizeof(buffer), "%.15g", x);
+	row += buffer;
+}
+
+void ResultsStore::query(const std::vector<StorePredicate>& predicates, const std::vector<int>& projection,
+                         std::ostream& out, StoreQueryStats* stats) const
+{
+	*stats = StoreQueryStats();
+	stats->blocks = this->blocks;
+
+	std::string row;
+	for (unsigned int p = 0; p < projection.size(); p++) {
+		row += (p == 0 ? "" : ",") + this->columns[projection[p]];
+	}
+	row += '\n';
+	out.write(row.data(), row.size());
+
+	// Sparse index: rows are sorted on the leading key, so its range is a contiguous run of blocks
+	auto firstKey = [this](long b) {
+		return b < this->blocks ? this->directory[b * DIRECTORY_ENTRY + this->leadingColumn] : INF;
+	};
+	long firstBlock = 0;
+	long endBlock = this->blocks;
+	for (unsigned int p = 0; p < predicates.size(); p++) {
+		if (predicates[p].column != this->leadingColumn) {
+			continue;
+		}
+		// First block whose keys reach the range
+		long low = firstBlock;
+		long high = endBlock;
+		while (low < high) {
+			long mid = (low + high) / 2;
+			if (predicates[p].mayMatch(-INF, firstKey(mid + 1))) {
+				high = mid;
+			} else {
+				low = mid + 1;
+			}
+		}
+		firstBlock = low;
+
+		// First block starting past the range
+		high = endBlock;
+		while (low < high) {
+			long mid = (low + high) / 2;
+			if (predicates[p].mayMatch(firstKey(mid), INF)) {
+				low = mid + 1;
+			} else {
+				high = mid;
+			}
+		}
+		endBlock = low;
+	}
+
+	for (long b = firstBlock; b < endBlock; b++) {
+		const double* entry = this->directory + b * DIRECTORY_ENTRY;
+
+		// Zone maps
+		bool mayMatch = true;
+		for (unsigned int p = 0; p < predicates.size() && mayMatch; p++) {
+			int c = predicates[p].column;
+			mayMatch = predicates[p].mayMatch(entry[NUM_GROUP_KEYS + c], entry[NUM_GROUP_KEYS + NUM_STORE_COLUMNS + c]);
+		}
+		if (!mayMatch) {
+			continue;
+		}
+		stats->blocksRead++;
+
+		long first = b * this->blockRows;
+		long rowsInBlock = std::min(this->blockRows, this->rows - first);
+		const double* block = this->data + first * NUM_STORE_COLUMNS;
+		for (long r = 0; r < rowsInBlock; r++) {
+			stats->rowsRead++;
+			bool matches = true;
+			for (unsigned int p = 0; p < predicates.size() && matches; p++) {
+				matches = predicates[p].matches(block[predicates[p].column * rowsInBlock + r]);
+			}
+			if (!matches) {
+				continue;
+			}
+			stats->rowsMatched++;
+
+			row.clear();
+			for (unsigned int p = 0; p < projection.size(); p++) {
+				if (p > 0) {
+					row += ',';
+				}
+				appendValue(row, block[projection[p] * rowsInBlock + r]);
+			}
+			row += '\n';
+			out.write(row.data(), row.size());
+		}
+	}
+}
+
+void ResultsStore::readColumn(int column, std::vector<double>* values) const
+{
+	values->clear();
+	values->reserve(this->rows);
+	for (long b = 0; b < this->blocks; b++) {
+		long first = b * this->blockRows;
+		long rowsInBlock = std::min(this->blockRows, this->rows - first);
+		const double* block = this->data + first * NUM_STORE_COLUMNS + column * rowsInBlock;
+		values->insert(values->end(), block, block + rowsInBlock);
+	}
+}
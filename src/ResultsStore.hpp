@@ -0,0 +1,148 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstddef>
+
+#include "Season.hpp"
+#include "SimsProcessor.hpp"
+
+/*
+Indexed results store: a scenario's processed metrics (see
+SimsGroup::metrics()), one row per combination, for range queries over
+parameters without rescanning CSVs.
+
+Rows are sorted by their GROUP_KEYS, environment (foraging, egg) before
+strategy (thresholds), and cut into blocks of blockRows rows, stored
+column by column as float64, so a query reads only the columns it needs
+from the blocks it can't rule out. A directory holds, for every block,
+the keys of its first row (a sparse index: a range on the leading sort
+key is found by binary search) and the minimum and maximum of every
+column (zone maps: a block is skipped when a predicate can't match
+anything between them).
+
+The file starts with a text header, padded with newlines to a multiple of
+4096 bytes:
+
+    lhsp_results_store 1
+    scenario regular
+    dtype float64
+    byte_order little
+    rows 209952
+    block_rows 64
+    blocks 3281
+    sort_keys Foraging_Condition_Mean Foraging_Condition_SD ...
+    columns 58                  (the GROUP_KEYS first)
+    column Min_Energy_Thresh_F
+    ...
+    directory_offset 4096       (per block: first keys, column minima, column maxima)
+    data_offset 3289088         (block b at data_offset + b * block_rows * columns * 8)
+    end
+
+Metrics are NaN until their combination has run. Zone maps are open
+(-Inf, Inf) until the writer closes, so a partial store still answers
+queries, only without skipping blocks.
+*/
+
+class ResultsStoreWriter {
+
+public:
+
+    ResultsStoreWriter();
+    ~ResultsStoreWriter();
+
+    /*
+    Create the store for a scenario's combinations, with every key filled in
+    @param combos the scenario's combinations (see scenarioCombos())
+    @return false if the file can't be created or mapped
+    */
+    bool create(const std::string& fname, const std::string& scenarioName,
+                const std::vector<ComboParams>& combos, int numParents, int blockRows);
+
+    // Fill the metrics of combos[comboIndex]
+    void setRow(long comboIndex, const SimsGroup& group);
+
+    // Compute the zone maps and unmap the file (also done on destruction)
+    void close();
+
+private:
+
+    double* cell(long row, int column);
+
+    std::vector<long> rowOf;        // sorted row of each combination
+    long rows;
+    long blockRows;
+    long blocks;
+    char* mapping;
+    std::size_t size;
+    double* directory;
+    double* data;
+};
+
+// A range on one column; rows with a NaN in the column never match
+struct StorePredicate {
+    int column;
+    double low;                     // -Inf if unbounded
+    double high;                    // Inf if unbounded
+    bool lowInclusive;
+    bool highInclusive;
+
+    bool matches(double x) const;
+
+    // Could any value in [min, max] match? (min NaN: the block has no values)
+    bool mayMatch(double min, double max) const;
+};
+
+struct StoreQueryStats {
+    long blocks;                    // blocks in the store
+    long blocksRead;                // blocks whose columns were read
+    long rowsRead;
+    long rowsMatched;
+};
+
+class ResultsStore {
+
+public:
+
+    ResultsStore();
+    ~ResultsStore();
+
+    // Map a store read-only; false if it can't be read or isn't a results store
+    bool open(const std::string& fname);
+    void close();
+
+    const std::vector<std::string>& getColumns() const { return this->columns; }
+
+    // Index of a column, or -1
+    int findColumn(const std::string& name) const;
+
+    /*
+    Parse "Column=value", "Column=low:high", "Column>=value", "Column>value",
+    "Column<=value" or "Column<value"
+    @return false if malformed or the column doesn't exist
+    */
+    bool parsePredicate(const std::string& text, StorePredicate* predicate) const;
+
+    /*
+    Write the rows matching every predicate as CSV, with the projected
+    columns in the given order (NaN as an empty field)
+    */
+    void query(const std::vector<StorePredicate>& predicates, const std::vector<int>& projection,
+               std::ostream& out, StoreQueryStats* stats) const;
+
+    // Every value of a column, in row order (e.g. to train an emulator; see Emulator.hpp)
+    void readColumn(int column, std::vector<double>* values) const;
+
+private:
+
+    std::vector<std::string> columns;
+    int leadingColumn;              // first sort key
+    long rows;
+    long blockRows;
+    long blocks;
+    const char* mapping;
+    std::size_t size;
+    const double* directory;
+    const double* data;
+};
@@ -0,0 +1,156 @@
+#include <cstdlib>
+
+#include "Scenario.hpp"
+
+const char* const SCENARIO_AXES[NUM_SCENARIO_AXES] = {
+	"Min_Energy_Thresh_F", "Max_Energy_Thresh_F",
+	"Min_Energy_Thresh_M", "Max_Energy_Thresh_M",
+	"Foraging_Condition_Mean", "Foraging_Condition_SD",
+	"Egg_Tolerance", "Egg_Cost"
+};
+
+int findScenarioAxis(const std::string& name)
+{
+	for (int a = 0; a < NUM_SCENARIO_AXES; a++) {
+		if (name == SCENARIO_AXES[a]) {
+			return a;
+		}
+	}
+	return -1;
+}
+
+double comboValue(const ComboParams& combo, int axis)
+{
+	switch (axis) {
+	case 0: return combo.minEnergyThresh_F;
+	case 1: return combo.maxEnergyThresh_F;
+	case 2: return combo.minEnergyThresh_M;
+	case 3: return combo.maxEnergyThresh_M;
+	case 4: return combo.foragingMean;
+	case 5: return combo.foragingSD;
+	case 6: return combo.eggTolerance;
+	default: return combo.eggCost;
+	}
+}
+
+bool ScenarioConstraint::allows(const ComboParams& combo) const
+{
+	double x = comboValue(combo, this->axis);
+	double y = this->otherAxis < 0 ? this->value : comboValue(combo, this->otherAxis);
+	if (this->op == "<") { return x < y; }
+	if (this->op == "<=") { return x <= y; }
+	if (this->op == ">") { return x > y; }
+	if (this->op == ">=") { return x >= y; }
+	return x == y;
+}
+
+bool parseConstraint(const std::string& text, ScenarioConstraint* constraint)
+{
+	std::size_t opStart = text.find_first_of("=<>");
+	if (opStart == std::string::npos || opStart == 0) {
+		return false;
+	}
+	std::size_t opEnd = opStart + 1;
+	if (opEnd < text.size() && text[opEnd] == '=' && text[opStart] != '=') {
+		opEnd++;
+	}
+	std::string other = text.substr(opEnd);
+
+	*constraint = ScenarioConstraint();
+	constraint->axis = findScenarioAxis(text.substr(0, opStart));
+	constraint->op = text.substr(opStart, opEnd - opStart);
+	constraint->otherAxis = findScenarioAxis(other);
+	constraint->value = 0;
+	if (constraint->axis < 0 || other.empty()) {
+		return false;
+	}
+	if (constraint->otherAxis < 0) {
+		char* end = nullptr;
+		constraint->value = std::strtod(other.c_str(), &end);
+		return *end == '\0';
+	}
+	return true;
+}
+
+std::vector<ComboParams> scenarioCombos(const Scenario& scenario)
+{
+	std::vector<ComboParams> ret;
+
+	// Same nesting as the original sweeps, so combination order is unchanged
+	for (unsigned int a = 0; a < scenario.minEnergyThresh_F.size(); a++) {
+	for (unsigned int b = 0; b < scenario.maxEnergyThresh_F.size(); b++) {
+	for (unsigned int c = 0; c < scenario.minEnergyThresh_M.size(); c++) {
+	for (unsigned int d = 0; d < scenario.maxEnergyThresh_M.size(); d++) {
+
+		// Skip if hunger threshold >= satiation threshold (doesn't make sense!)
+		if (scenario.minEnergyThresh_F[a] >= scenario.maxEnergyThresh_F[b] ||
+		    scenario.minEnergyThresh_M[c] >= scenario.maxEnergyThresh_M[d]) {
+			continue;
+		}
+
+	for (unsigned int e = 0; e < scenario.foragingMean.size(); e++) {
+	for (unsigned int f = 0; f < scenario.foragingSD.size(); f++) {
+	for (unsigned int g = 0; g < scenario.eggTolerance.size(); g++) {
+	for (unsigned int h = 0; h < scenario.eggCost.size(); h++) {
+		ComboParams combo = ComboParams();
+		combo.minEnergyThresh_F = scenario.minEnergyThresh_F[a];
+		combo.maxEnergyThresh_F = scenario.maxEnergyThresh_F[b];
+		combo.minEnergyThresh_M = scenario.minEnergyThresh_M[c];
+		combo.maxEnergyThresh_M = scenario.maxEnergyThresh_M[d];
+		combo.foragingMean = scenario.foragingMean[e];
+		combo.foragingSD = scenario.foragingSD[f];
+		combo.eggTolerance = scenario.eggTolerance[g];
+		combo.eggCost = scenario.eggCost[h];
+
+		bool allowed = true;
+		for (unsigned int k = 0; k < scenario.constraints.size(); k++) {
+			allowed = allowed && scenario.constraints[k].allows(combo);
+		}
+		if (allowed) {
+			ret.push_back(combo);
+		}
+	} } } } } } } } // End parameter loops
+
+	return ret;
+}
+
+long findCombo(const std::vector<ComboParams>& combos, const ComboParams& combo)
+{
+	for (unsigned int i = 0; i < combos.size(); i++) {
+		const ComboParams& c = combos[i];
+		if (c.minEnergyThresh_F == combo.minEnergyThresh_F &&
+		    c.maxEnergyThresh_F == combo.maxEnergyThresh_F &&
+		    c.minEnergyThresh_M == combo.minEnergyThresh_M &&
+		    c.maxEnergyThresh_M == combo.maxEnergyThresh_M &&
+		    c.foragingMean == combo.foragingMean &&
+		    c.foragingSD == combo.foragingSD &&
+		    c.eggTolerance == combo.eggTolerance &&
+		    c.eggCost == combo.eggCost) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+// One splitmix64 step (Steele et al. 2014)
+static uint64_t splitmix64(uint64_t x)
+{
+	x += 0x9E3779B97F4A7C15ULL;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
+}
+
+uint64_t replicateSeed(uint64_t baseSeed, int scenario, long combo, int iteration)
+{
+	uint64_t x = splitmix64(baseSeed);
+	x = splitmix64(x ^ static_cast<uint64_t>(scenario));
+	x = splitmix64(x ^ static_cast<uint64_t>(combo));
+	return splitmix64(x ^ static_cast<uint64_t>(iteration));
+}
+
+void seedReplicate(std::mt19937* randGen, uint64_t seed)
+{
+	std::seed_seq sequence{ static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32) };
+	randGen->seed(sequence);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <random>
+
+#include "Season.hpp"
+
+// The swept parameters, named as in the sims_*.csv columns
+static const int NUM_SCENARIO_AXES = 8;
+extern const char* const SCENARIO_AXES[NUM_SCENARIO_AXES];
+
+// Index of a SCENARIO_AXES name, or -1
+int findScenarioAxis(const std::string& name);
+
+// A combination's value on one axis
+double comboValue(const ComboParams& combo, int axis);
+
+/*
+Extra rule on a scenario's combinations: an axis compared to a value or
+to another axis, e.g. "Egg_Cost<=300" or "Min_Energy_Thresh_M<Min_Energy_Thresh_F"
+*/
+struct ScenarioConstraint {
+    int axis;
+    std::string op;                 // "=", "<", "<=", ">" or ">="
+    int otherAxis;                  // -1 to compare with value
+    double value;
+
+    bool allows(const ComboParams& combo) const;
+};
+
+// Parse a constraint; false if malformed or an axis doesn't exist
+bool parseConstraint(const std::string& text, ScenarioConstraint* constraint);
+
+/*
+A parameter sweep: every combination of the listed values, each replicated
+over a number of iterations. Combinations where a hunger threshold is not
+below the satiation threshold are skipped, as are those breaking any of
+the scenario's constraints.
+*/
+struct Scenario {
+    std::string name;
+    std::vector<double> minEnergyThresh_F;
+    std::vector<double> maxEnergyThresh_F;
+    std::vector<double> minEnergyThresh_M;
+    std::vector<double> maxEnergyThresh_M;
+    std::vector<double> foragingMean;
+    std::vector<double> foragingSD;
+    std::vector<int> eggTolerance;
+    std::vector<double> eggCost;
+    bool oneParent;
+    bool swapSexOrder;
+    int iterations;                 // replicates per combination (0 for the run's ITERATIONS)
+    std::vector<ScenarioConstraint> constraints;
+};
+
+/*
+A scenario's combinations in sweep order. A combination's index in this
+list identifies it (with the scenario, iteration and base seed) for replays.
+*/
+std::vector<ComboParams> scenarioCombos(const Scenario& scenario);
+
+// Index of the combination matching every parameter, or -1 if there is none
+long findCombo(const std::vector<ComboParams>& combos, const ComboParams& combo);
+
+/*
+Seed for a single replicate.
+Mixes the run's base seed with the scenario, combination and iteration
+indices (splitmix64 steps), so every replicate draws from its own stream
+and can be regenerated on its own, in any order or on any thread.
+*/
+uint64_t replicateSeed(uint64_t baseSeed, int scenario, long combo, int iteration);
+
+// Seed a random device with all 64 bits of a replicate seed (both halves through std::seed_seq)
+void seedReplicate(std::mt19937* randGen, uint64_t seed);
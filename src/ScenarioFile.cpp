@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+
+#include "ScenarioFile.hpp"
+#include "Util.hpp"
+
+// Parse a number; false on anything else
+static bool parseNumber(const std::string& text, double* x)
+{
+	char* end = nullptr;
+	*x = std::strtod(text.c_str(), &end);
+	return !text.empty() && *end == '\0';
+}
+
+bool parseParamValues(const std::vector<std::string>& items, std::vector<double>* values)
+{
+	values->clear();
+	for (unsigned int i = 0; i < items.size(); i++) {
+		std::stringstream ss(items[i]);
+		std::string part;
+		std::vector<double> range;
+		while (std::getline(ss, part, ':')) {
+			double x;
+			if (!parseNumber(part, &x)) {
+				return false;
+			}
+			range.push_back(x);
+		}
+
+		if (range.size() == 1) {
+			values->push_back(range[0]);
+		} else if (range.size() == 3 && range[2] > 0) {
+			std::vector<double> v = paramVector(range.data());
+			values->insert(values->end(), v.begin(), v.end());
+		} else {
+			return false;
+		}
+	}
+	return !values->empty();
+}
+
+// A scenario's values on one axis
+static void setAxis(Scenario& scenario, int axis, const std::vector<double>& values)
+{
+	switch (axis) {
+	case 0: scenario.minEnergyThresh_F = values; break;
+	case 1: scenario.maxEnergyThresh_F = values; break;
+	case 2: scenario.minEnergyThresh_M = values; break;
+	case 3: scenario.maxEnergyThresh_M = values; break;
+	case 4: scenario.foragingMean = values; break;
+	case 5: scenario.foragingSD = values; break;
+	case 6: scenario.eggTolerance = std::vector<int>(values.begin(), values.end()); break;
+	default: scenario.eggCost = values; break;
+	}
+}
+
+// Parse a yes/no value, true if absent
+static bool parseFlag(const std::vector<std::string>& items, bool* flag)
+{
+	if (items.empty() || items[0] == "true" || items[0] == "1") {
+		*flag = true;
+	} else if (items[0] == "false" || items[0] == "0") {
+		*flag = false;
+	} else {
+		return false;
+	}
+	return items.size() <= 1;
+}
+
+bool readScenarioFile(const std::string& fname, ScenarioFile* file, std::string* error)
+{
+	std::ifstream infile(fname);
+	if (!infile.is_open()) {
+		*error = "could not open " + fname;
+		return false;
+	}
+
+	file->options.clear();
+	file->scenarios.clear();
+
+	Scenario scenario = Scenario();
+	bool inScenario = false;
+	bool axisSet[NUM_SCENARIO_AXES];
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(infile, line)) {
+		lineNumber++;
+		std::string where = fname + " line " + std::to_string(lineNumber) + ": ";
+
+		std::stringstream ss(line.substr(0, line.find('#')));
+		std::string keyword;
+		if (!(ss >> keyword)) {
+			continue;
+		}
+		std::vector<std::string> items;
+		std::string item;
+		while (ss >> item) {
+			items.push_back(item);
+		}
+
+		if (!inScenario) {
+			if (keyword == "scenario") {
+				if (items.size() != 1) {
+					*error = where + "expected a scenario name";
+					return false;
+				}
+				for (unsigned int i = 0; i < file->scenarios.size(); i++) {
+					if (file->scenarios[i].name == items[0]) {
+						*error = where + "scenario " + items[0] + " is defined twice";
+						return false;
+					}
+				}
+				scenario = Scenario();
+				scenario.name = items[0];
+				std::fill(axisSet, axisSet + NUM_SCENARIO_AXES, false);
+				inScenario = true;
+			} else if (keyword == "end") {
+				*error = where + "end outside a scenario";
+				return false;
+			} else {
+				std::string value;
+				for (unsigned int i = 0; i < items.size(); i++) {
+					value += (i > 0 ? " " : "") + items[i];
+				}
+				file->options.push_back(std::make_pair(keyword, value));
+			}
+			continue;
+		}
+
+		int axis = findScenarioAxis(keyword);
+		if (axis >= 0) {
+			std::vector<double> values;
+			if (!parseParamValues(items, &values)) {
+				*error = where + "malformed values for " + keyword;
+				return false;
+			}
+			if (axis == 6) {
+				for (unsigned int i = 0; i < values.size(); i++) {
+					if (values[i] != static_cast<int>(values[i])) {
+						*error = where + "Egg_Tolerance values must be whole days";
+						return false;
+					}
+				}
+			}
+			setAxis(scenario, axis, values);
+			axisSet[axis] = true;
+		} else if (keyword == "one_parent") {
+			if (!parseFlag(items, &scenario.oneParent)) {
+				*error = where + "expected one_parent [true|false]";
+				return false;
+			}
+		} else if (keyword == "swap_sex_order") {
+			if (!parseFlag(items, &scenario.swapSexOrder)) {
+				*error = where + "expected swap_sex_order [true|false]";
+				return false;
+			}
+		} else if (keyword == "iterations") {
+			double x;
+			if (items.size() != 1 || !parseNumber(items[0], &x) || x < 1 || x != static_cast<int>(x)) {
+				*error = where + "expected a positive number of iterations";
+				return false;
+			}
+			scenario.iterations = static_cast<int>(x);
+		} else if (keyword == "constraint") {
+			ScenarioConstraint constraint;
+			if (items.size() != 1 || !parseConstraint(items[0], &constraint)) {
+				*error = where + "malformed constraint (e.g. Egg_Cost<=300, Min_Energy_Thresh_M<Min_Energy_Thresh_F)";
+				return false;
+			}
+			scenario.constraints.push_back(constraint);
+		} else if (keyword == "end") {
+			for (int a = 0; a < NUM_SCENARIO_AXES; a++) {
+				if (!axisSet[a]) {
+					*error = where + "scenario " + scenario.name + " has no " + SCENARIO_AXES[a];
+					return false;
+				}
+			}
+			if (scenario.oneParent && scenario.swapSexOrder) {
+				*error = where + "scenario " + scenario.name + " can't have both one_parent and swap_sex_order";
+				return false;
+			}
+			file->scenarios.push_back(scenario);
+			inScenario = false;
+		} else {
+			*error = where + "unknown scenario keyword " + keyword;
+			return false;
+		}
+	}
+
+	if (inScenario) {
+		*error = fname + ": scenario " + scenario.name + " has no end";
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "Scenario.hpp"
+
+/*
+Scenario definition files: the sweeps and run options of a run, so
+scenarios can be changed and selected without recompiling.
+
+Lines hold a keyword and its values, separated by spaces; '#' starts a
+comment. Lines outside a scenario block are run options, named as the
+settings at the top of src/main.cpp in lower case (iterations,
+output_suffix, threads, compress_output, ...). A scenario block lists
+every axis, with its name as in the sims_*.csv columns, as values and
+min:max:by ranges, then any mode flags, iterations and constraints:
+
+    iterations 1000
+    output_suffix ms-1000iter
+
+    scenario regular
+    Min_Energy_Thresh_F 200:1100:100
+    Max_Energy_Thresh_F 400:1200:100
+    Min_Energy_Thresh_M 200:1100:100
+    Max_Energy_Thresh_M 400:1200:100
+    Foraging_Condition_Mean 130:170:10 162
+    Foraging_Condition_SD 0:100:10 47
+    Egg_Tolerance 7
+    Egg_Cost 69.7
+    end
+
+    scenario oneParent
+    ...
+    one_parent                  (or swap_sex_order, not both)
+    iterations 500              (instead of the run's)
+    constraint Egg_Cost<=300    (see parseConstraint())
+    end
+
+A scenario's position in the file is part of every replicate's seed (see
+replicateSeed()), so new scenarios go at the end.
+*/
+struct ScenarioFile {
+    std::vector< std::pair<std::string, std::string> > options;    // run options, in file order
+    std::vector<Scenario> scenarios;
+};
+
+/*
+Read a scenario file
+@param error set to what is wrong (and on which line) on failure
+@return false if the file can't be read or is malformed
+*/
+bool readScenarioFile(const std::string& fname, ScenarioFile* file, std::string* error);
+
+/*
+Parse axis values and min:max:by ranges (as paramVector()), in order
+@return false if a value is malformed or a step isn't positive
+*/
+bool parseParamValues(const std::vector<std::string>& items, std::vector<double>* values);
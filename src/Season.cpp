@@ -0,0 +1,51 @@
+#include "Season.hpp"
+
+/*
+Full breeding season for two parents.
+Breeding season lasts until the egg hatches succesfully, or
+if the egg hits the hard cut-off of incubation days due to
+accumulated neglect (see seasonKernel() for the daily loop)
+*/
+std::string breedingSeason(Parent& pf, Parent& pm, Egg& egg, bool swapSexOrder, std::mt19937* randGen)
+{
+	if (swapSexOrder) {
+		return seasonKernel< SeasonMode<2, true, true, true, RuntimeSpecies> >(pf, pm, egg, randGen);
+	}
+	return seasonKernel< SeasonMode<2, false, true, true, RuntimeSpecies> >(pf, pm, egg, randGen);
+}
+
+std::string breedingSeason_oneParent(Parent& pf, Egg& egg)
+{
+	// The one-parent kernel never touches the male or the tie-breaker
+	return seasonKernel< SeasonMode<1, false, true, true, RuntimeSpecies> >(pf, pf, egg, nullptr);
+}
+
+template <class Species>
+static SeasonResult simulateSeasonFor(const ComboParams& combo,
+                                      bool oneParent, bool swapSexOrder,
+                                      const ForagingSchedule* foragingSchedule,
+                                      std::mt19937* randGen,
+                                      std::ostream* trace)
+{
+	if (oneParent) {
+		return simulateSeason< SeasonMode<1, false, true, false, Species> >(combo, foragingSchedule, randGen, nullptr, trace);
+	} else if (swapSexOrder) {
+		return simulateSeason< SeasonMode<2, true, true, false, Species> >(combo, foragingSchedule, randGen, nullptr, trace);
+	}
+	return simulateSeason< SeasonMode<2, false, true, false, Species> >(combo, foragingSchedule, randGen, nullptr, trace);
+}
+
+SeasonResult simulateSeason(const ComboParams& combo,
+                            bool oneParent, bool swapSexOrder,
+                            const ForagingSchedule* foragingSchedule,
+                            std::mt19937* randGen,
+                            SpeciesId species,
+                            std::ostream* trace)
+{
+	if (species == SpeciesId::forkTailed) {
+		return simulateSeasonFor<ForkTailedStormPetrel>(combo, oneParent, swapSexOrder, foragingSchedule, randGen, trace);
+	} else if (species == SpeciesId::european) {
+		return simulateSeasonFor<EuropeanStormPetrel>(combo, oneParent, swapSexOrder, foragingSchedule, randGen, trace);
+	}
+	return simulateSeasonFor<LeachsStormPetrel>(combo, oneParent, swapSexOrder, foragingSchedule, randGen, trace);
+}
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <string>
+#include <random>
+#include <ostream>
+#include <vector>
+
+#include "Parent.hpp"
+#include "Egg.hpp"
+#include "ForagingSchedule.hpp"
+#include "Util.hpp"
+
+// A single parameter combination
+struct ComboParams {
+    double minEnergyThresh_F;
+    double maxEnergyThresh_F;
+    double minEnergyThresh_M;
+    double maxEnergyThresh_M;
+    double foragingMean;
+    double foragingSD;
+    int eggTolerance;
+    double eggCost;
+};
+
+// Outcome of a single breeding season, as written to the sims_*.csv output
+struct SeasonResult {
+    std::string hatchResult;        // see checkSeasonSuccess()
+    double hatchDays;               // total number of days (maybe limit)
+    int totNeglect;                 // total neglect across season
+    int maxNeglect;                 // maximum neglect streak
+    double endEnergy_F;             // final energy value (-1 if never recorded)
+    double meanEnergy_F;            // arithmetic mean energy across season
+    double varEnergy_F;             // variance in energy across season
+    bool dead_F;
+    double endEnergy_M;
+    double meanEnergy_M;
+    double varEnergy_M;
+    bool dead_M;
+    int numParents;
+    std::string seasonHistory;      // daily start state ('F', 'M', or 'N')
+
+    // Work counters for runtime telemetry (not written to the CSV)
+    int seasonDays;                 // days simulated
+    int foragingDraws;              // foraging intake draws, both parents
+    int tieBreaks;                  // random tie-breaks between returning parents
+};
+
+// Daily energy of both parents across a season (male empty with one parent)
+struct SeasonTrajectory {
+    std::vector<double> energy_F;
+    std::vector<double> energy_M;
+};
+
+/*
+Compile-time season modes.
+Each scenario runs a season kernel specialized on its mode, so branches
+on the number of parents, starting order and what gets recorded are
+resolved by the compiler rather than checked every day. New modes
+(e.g. a three-state parent) only need a new policy and kernel branch.
+@tparam NumParents 1 (female only) or 2
+@tparam SwapSexOrder females begin foraging, males incubating
+@tparam RecordHistory build the daily 'F'/'M'/'N' season history
+@tparam RecordEnergy keep full daily energy records (summaries always
+        come from running sums, so recording leaves the results unchanged)
+@tparam Species species pack folded into the kernel (see Species.hpp),
+        or RuntimeSpecies to read the parents' and egg's SpeciesParams
+*/
+template <int NumParents, bool SwapSexOrder, bool RecordHistory, bool RecordEnergy,
+          class Species = LeachsStormPetrel>
+struct SeasonMode {
+    static constexpr int NUM_PARENTS = NumParents;
+    static constexpr bool SWAP_SEX_ORDER = SwapSexOrder;
+    static constexpr bool RECORD_HISTORY = RecordHistory;
+    static constexpr bool RECORD_ENERGY = RecordEnergy;
+    typedef Species SpeciesPack;
+};
+
+/*
+Run a full breeding season for two parents
+@param randGen ptr to the random device used for tie-breaks
+@return season history
+*/
+std::string breedingSeason(Parent& pf, Parent& pm, Egg& egg, bool swapSexOrder, std::mt19937* randGen);
+
+// Run a full breeding season for a single (female) parent
+std::string breedingSeason_oneParent(Parent& pf, Egg& egg);
+
+/*
+Simulate one replicate of a parameter combination from fresh parents and egg.
+Holds no state between calls, so independent random devices can drive
+independent calls concurrently. Dispatches to the specialized kernel
+(recording the history, summarizing energy from running sums).
+@param trace optional stream for a day-by-day trace (see printDailyTrace())
+*/
+SeasonResult simulateSeason(const ComboParams& combo,
+                            bool oneParent, bool swapSexOrder,
+                            const ForagingSchedule* foragingSchedule,
+                            std::mt19937* randGen,
+                            SpeciesId species = SpeciesId::leachs,
+                            std::ostream* trace = nullptr);
+
+/*
+Season kernel specialized on a SeasonMode (see breedingSeason() for the model).
+pm is ignored (and never touched) in one-parent modes.
+@param tieBreaks optional count of random tie-breaks (for telemetry)
+@param trace optional stream for a day-by-day trace (see printDailyTrace())
+@return season history (empty unless Mode::RECORD_HISTORY)
+*/
+template <class Mode>
+std::string seasonKernel(Parent& pf, Parent& pm, Egg& egg, std::mt19937* randGen,
+                         int* tieBreaks = nullptr, std::ostream* trace = nullptr)
+{
+	typedef typename Mode::SpeciesPack Species;
+
+	// Season history that records state at the start of each day
+	std::string seasonHistory;
+	if (Mode::RECORD_HISTORY) {
+		seasonHistory.reserve(static_cast<int>(egg.getMaxHatchDays()) + 2);
+	}
+
+	// The female pays the initial cost of the egg
+	pf.setEnergy(pf.getEnergy() - egg.getEggCost());
+
+	if (Mode::NUM_PARENTS == 2 && Mode::SWAP_SEX_ORDER) {
+		pf.setState(State::foraging);
+		pf.setPrevDayState(State::foraging);
+
+		pm.setState(State::incubating);
+		pm.setPrevDayState(State::incubating);
+	}
+
+	double maxHatchDays = egg.getMaxHatchDays();
+	while (egg.isAlive() && !egg.isHatched() && (egg.getIncubationDays() <= maxHatchDays)) {
+
+		if (trace != nullptr) {
+			printDailyTrace(pf, pm, egg, *trace);
+		}
+
+		State femaleStartState = pf.getState();
+		State maleStartState = State::foraging;
+		if (Mode::NUM_PARENTS == 2) {
+			maleStartState = pm.getState();
+		}
+
+		// Add the daily start state to the season history
+		if (Mode::RECORD_HISTORY) {
+			if (femaleStartState == State::incubating) { seasonHistory += 'F'; }
+			else if (maleStartState == State::incubating) { seasonHistory += 'M'; }
+			else { seasonHistory += 'N'; }
+		}
+
+		// Egg behavior based on incubation
+		egg.eggDay<Species>(femaleStartState == State::incubating || maleStartState == State::incubating);
+
+		// Parent behavior, including state change
+		pf.parentDay<Mode::RECORD_ENERGY, Species>();
+		if (Mode::NUM_PARENTS == 2) {
+			pm.parentDay<Mode::RECORD_ENERGY, Species>();
+		}
+
+		State femaleState = pf.getState();
+		if (Mode::NUM_PARENTS == 1) {
+			if (femaleState == State::dead) {
+				break;
+			}
+			continue;
+		}
+
+		State maleState = pm.getState();
+		if (femaleState == State::dead || maleState == State::dead) {
+			break;
+		}
+
+		// Both incubating: the returning parent relieves its partner, ties are random
+		if (femaleState == State::incubating && maleState == State::incubating) {
+			State previousFemaleState = pf.getPreviousDayState();
+			State previousMaleState = pm.getPreviousDayState();
+
+			if (previousFemaleState == State::incubating && previousMaleState == State::foraging) {
+				pf.changeState();
+			} else if (previousMaleState == State::incubating && previousFemaleState == State::foraging) {
+				pm.changeState();
+			} else {
+				if (tieBreaks != nullptr) {
+					(*tieBreaks)++;
+				}
+				std::uniform_real_distribution<double> tieBreaker(0.0, 1.0);
+				if (tieBreaker(*randGen) <= 0.5) {
+					pf.changeState();
+				} else {
+					pm.changeState();
+				}
+			}
+		}
+	}
+
+	// Final state after the last day
+	if (trace != nullptr) {
+		printDailyTrace(pf, pm, egg, *trace);
+	}
+
+	return seasonHistory;
+}
+
+// Energy end/mean/variance summary for one parent (-1 if never recorded)
+template <bool RecordEnergy>
+void summarizeEnergy(Parent& p, double& endEnergy, double& meanEnergy, double& varEnergy)
+{
+	endEnergy = -1;
+	meanEnergy = -1;
+	varEnergy = -1;
+	if (RecordEnergy) {
+		std::vector<double> energy = p.getEnergyRecord();
+		if (energy.size() > 0) {
+			endEnergy = energy[energy.size()-1];
+			meanEnergy = vectorMean(energy);
+			varEnergy = vectorVar(energy);
+		}
+	} else if (p.getEnergyDays() > 0) {
+		endEnergy = p.getEndEnergy();
+		meanEnergy = p.getMeanEnergy();
+		varEnergy = p.getVarEnergy();
+	}
+}
+
+/*
+Specialized simulateSeason() for a SeasonMode
+@param species run-time species parameters; must match Mode's species pack
+       unless that is RuntimeSpecies (nullptr for the pack's own values)
+@param trace optional stream for a day-by-day trace
+@param trajectory optional daily energies of both parents (Mode::RECORD_ENERGY only)
+*/
+template <class Mode>
+SeasonResult simulateSeason(const ComboParams& combo,
+                            const ForagingSchedule* foragingSchedule,
+                            std::mt19937* randGen,
+                            const SpeciesParams* species = nullptr,
+                            std::ostream* trace = nullptr,
+                            SeasonTrajectory* trajectory = nullptr)
+{
+	if (species == nullptr) {
+		species = speciesParams<typename Mode::SpeciesPack>();
+	}
+
+	// A fresh egg
+	Egg egg = Egg(species);
+	egg.setNeglectMax(combo.eggTolerance);
+	egg.setEggCost(combo.eggCost);
+
+	// Two shiny new parents
+	Parent pf = Parent(Sex::female, randGen, species);
+	Parent pm = Parent(Sex::male, randGen, species);
+
+	// Set both parent's parameters according to the combo
+	pf.setMinEnergyThresh(combo.minEnergyThresh_F);
+	pf.setMaxEnergyThresh(combo.maxEnergyThresh_F);
+	pf.setForagingDistribution(combo.foragingMean, combo.foragingSD);
+	pf.setForagingSchedule(foragingSchedule);
+
+	pm.setMinEnergyThresh(combo.minEnergyThresh_M);
+	pm.setMaxEnergyThresh(combo.maxEnergyThresh_M);
+	pm.setForagingDistribution(combo.foragingMean, combo.foragingSD);
+	pm.setForagingSchedule(foragingSchedule);
+
+	SeasonResult result = SeasonResult();
+	result.numParents = Mode::NUM_PARENTS;
+	result.seasonHistory = seasonKernel<Mode>(pf, pm, egg, randGen, &result.tieBreaks, trace);
+	if (Mode::NUM_PARENTS == 1) {
+		result.hatchResult = checkSeasonSuccess(pf, egg);
+	} else {
+		result.hatchResult = checkSeasonSuccess(pf, pm, egg);
+	}
+
+	result.hatchDays = egg.getIncubationDays();
+	result.totNeglect = egg.getTotNeg();
+	result.maxNeglect = egg.getMaxNeg();
+
+	summarizeEnergy<false>(pf, result.endEnergy_F, result.meanEnergy_F, result.varEnergy_F);
+	result.dead_F = !pf.isAlive();
+	summarizeEnergy<false>(pm, result.endEnergy_M, result.meanEnergy_M, result.varEnergy_M);
+	result.dead_M = !pm.isAlive();
+
+	if (Mode::RECORD_ENERGY && trajectory != nullptr) {
+		pf.takeEnergyRecord(&trajectory->energy_F);
+		pm.takeEnergyRecord(&trajectory->energy_M);
+	}
+
+	result.seasonDays = pf.getDay();
+	result.foragingDraws = pf.getForagingDraws() + pm.getForagingDraws();
+
+	return result;
+}
@@ -0,0 +1,721 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <unordered_set>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "SimsProcessor.hpp"
+#include "CompressedOutput.hpp"
+
+static const double NA = std::numeric_limits<double>::quiet_NaN();
+
+const char* const BOUT_COLUMNS[NUM_BOUT_COLUMNS] = {
+	"Mean_Incubation_Bout_Both",
+	"Mean_Incubation_Bout_Both_Trimmed",
+	"Mean_Foraging_Bout_Both",
+	"Mean_Foraging_Bout_Both_Trimmed",
+	"N_Incubation_Bouts_F",
+	"Mean_Incubation_Bout_F",
+	"Mean_Incubation_Bout_F_Trimmed",
+	"Var_Incubation_Bout_F",
+	"N_Foraging_Bouts_F",
+	"Mean_Foraging_Bout_F",
+	"Mean_Foraging_Bout_F_Trimmed",
+	"Var_Foraging_Bout_F",
+	"N_Incubation_Bouts_M",
+	"Mean_Incubation_Bout_M",
+	"Mean_Incubation_Bout_M_Trimmed",
+	"Var_Incubation_Bout_M",
+	"N_Foraging_Bouts_M",
+	"Mean_Foraging_Bout_M",
+	"Mean_Foraging_Bout_M_Trimmed",
+	"Var_Foraging_Bout_M"
+};
+
+const char* const GROUP_KEYS[NUM_GROUP_KEYS] = {
+	"Min_Energy_Thresh_F", "Max_Energy_Thresh_F",
+	"Min_Energy_Thresh_M", "Max_Energy_Thresh_M",
+	"Foraging_Condition_Mean", "Foraging_Condition_SD",
+	"Egg_Tolerance", "Egg_Cost", "Num_Parents"
+};
+
+static const char* const OVERALL_COLUMNS[8] = {
+	"Overall_Mean_Energy_F", "Overall_Var_Energy_F",
+	"Overall_Mean_Energy_M", "Overall_Var_Energy_M",
+	"Overall_Total_Neglect", "Overall_Max_Neglect",
+	"Overall_Prop_Neglect", "Overall_Hatch_Date"
+};
+
+static const char* const SUCCESSFUL_COLUMNS[12] = {
+	"Successful_Mean_Energy_F", "Successful_Var_Energy_F",
+	"Successful_Mean_Energy_M", "Successful_Var_Energy_M",
+	"Successful_Total_Neglect", "Successful_Max_Neglect",
+	"Successful_Prop_Neglect", "Successful_Hatch_Date",
+	"Successful_Attendance_F", "Successful_Prop_F",
+	"Successful_Attendance_M", "Successful_Prop_M"
+};
+
+double RunningMean::mean() const
+{
+	if (this->count == 0) {
+		return NA;
+	}
+	return static_cast<double>(this->sum / this->count);
+}
+
+// Lengths of runs of days with and without the parent incubating (rle())
+static void boutRuns(const char* history, std::size_t length, char parent,
+                     std::vector<int>& incubation, std::vector<int>& foraging)
+{
+	std::size_t i = 0;
+	while (i < length) {
+		bool incubating = history[i] == parent;
+		std::size_t start = i;
+		while (i < length && (history[i] == parent) == incubating) {
+			i++;
+		}
+		(incubating ? incubation : foraging).push_back(i - start);
+	}
+}
+
+static double boutMean(const std::vector<int>& a, const std::vector<int>& b)
+{
+	if (a.empty() && b.empty()) {
+		return NA;
+	}
+	long double sum = 0;
+	for (unsigned int i = 0; i < a.size(); i++) { sum += a[i]; }
+	for (unsigned int i = 0; i < b.size(); i++) { sum += b[i]; }
+	return static_cast<double>(sum / (a.size() + b.size()));
+}
+
+// Sample variance, NA below two bouts (var())
+static double boutVar(const std::vector<int>& a)
+{
+	if (a.size() < 2) {
+		return NA;
+	}
+	std::vector<int> none;
+	double mean = boutMean(a, none);
+	long double sqSum = 0;
+	for (unsigned int i = 0; i < a.size(); i++) {
+		sqSum += (a[i] - mean) * (a[i] - mean);
+	}
+	return static_cast<double>(sqSum / (a.size() - 1));
+}
+
+/*
+Drop a parent's first and last bouts, whichever kind they are, to reduce
+sensitivity to the arbitrary start and end of the season
+*/
+static void trimBouts(const char* history, std::size_t length, char parent,
+                      std::vector<int>& incubation, std::vector<int>& foraging)
+{
+	if (length == 0) {
+		return;
+	}
+	bool first = history[0] == parent;
+	bool last = history[length - 1] == parent;
+
+	std::vector<int>& firstBouts = first ? incubation : foraging;
+	if (!firstBouts.empty()) {
+		firstBouts.erase(firstBouts.begin());
+	}
+	std::vector<int>& lastBouts = last ? incubation : foraging;
+	if (!lastBouts.empty()) {
+		lastBouts.pop_back();
+	}
+}
+
+void calcBouts(const char* history, std::size_t length, double values[NUM_BOUT_COLUMNS])
+{
+	std::vector<int> incubation[2];
+	std::vector<int> foraging[2];
+	boutRuns(history, length, 'F', incubation[0], foraging[0]);
+	boutRuns(history, length, 'M', incubation[1], foraging[1]);
+
+	std::vector<int> incubationTrimmed[2] = { incubation[0], incubation[1] };
+	std::vector<int> foragingTrimmed[2] = { foraging[0], foraging[1] };
+	trimBouts(history, length, 'F', incubationTrimmed[0], foragingTrimmed[0]);
+	trimBouts(history, length, 'M', incubationTrimmed[1], foragingTrimmed[1]);
+
+	std::vector<int> none;
+	values[0] = boutMean(incubation[0], incubation[1]);
+	values[1] = boutMean(incubationTrimmed[0], incubationTrimmed[1]);
+	values[2] = boutMean(foraging[0], foraging[1]);
+	values[3] = boutMean(foragingTrimmed[0], foragingTrimmed[1]);
+
+	for (int p = 0; p < 2; p++) {
+		double* v = values + 4 + 8 * p;
+		v[0] = incubation[p].size();
+		v[1] = boutMean(incubation[p], none);
+		v[2] = boutMean(incubationTrimmed[p], none);
+		v[3] = boutVar(incubation[p]);
+		v[4] = foraging[p].size();
+		v[5] = boutMean(foraging[p], none);
+		v[6] = boutMean(foragingTrimmed[p], none);
+		v[7] = boutVar(foraging[p]);
+	}
+}
+
+void SimsGroup::merge(const SimsGroup& other)
+{
+	this->n += other.n;
+	this->nSuccess += other.nSuccess;
+	this->nFailEggTime += other.nFailEggTime;
+	this->nFailEggCold += other.nFailEggCold;
+	this->nFailParentDead += other.nFailParentDead;
+	for (int i = 0; i < 8; i++) { this->overall[i].merge(other.overall[i]); }
+	for (int i = 0; i < 12; i++) { this->successful[i].merge(other.successful[i]); }
+	for (int i = 0; i < NUM_BOUT_COLUMNS; i++) { this->bouts[i].merge(other.bouts[i]); }
+}
+
+// A value as fwrite() writes it: up to 15 significant digits, NA/NaN as empty
+static void writeValue(std::string& row, double x)
+{
+	row += ',';
+	if (x != x) {
+		return;
+	}
+	if (std::isinf(x)) {
+		row += x > 0 ? "Inf" : "-Inf";
+		return;
+	}
+	char buffer[32];
+	std::snprintf(buffer, sizeof(buffer), "%.15g", x);
+	row += buffer;
+}
+
+void SimsGroup::metrics(double values[NUM_PROCESSED_METRICS]) const
+{
+	double* v = values;
+	*v++ = this->n;
+	*v++ = this->nSuccess;
+	*v++ = this->nFailEggTime;
+	*v++ = this->nFailEggCold;
+	*v++ = this->nFailParentDead;
+	for (int i = 0; i < 8; i++) { *v++ = this->overall[i].mean(); }
+	for (int i = 0; i < 12; i++) { *v++ = this->successful[i].mean(); }
+
+	double total = this->n;
+	*v++ = this->nSuccess / total;
+	*v++ = this->nFailEggTime / total;
+	*v++ = this->nFailEggCold / total;
+	*v++ = this->nFailParentDead / total;
+
+	for (int i = 0; i < NUM_BOUT_COLUMNS; i++) { *v++ = this->bouts[i].mean(); }
+}
+
+void SimsGroup::writeRow(std::ostream& out) const
+{
+	std::string row = this->key;
+	row.reserve(1024);
+
+	double values[NUM_PROCESSED_METRICS];
+	metrics(values);
+	for (int i = 0; i < NUM_PROCESSED_METRICS; i++) {
+		writeValue(row, values[i]);
+	}
+
+	row += '\n';
+	out.write(row.data(), row.size());
+}
+
+std::vector<std::string> processedMetricNames()
+{
+	static const char* const COUNT_COLUMNS[5] = {
+		"N_Total", "N_Success", "N_Fail_Egg_Time", "N_Fail_Egg_Cold", "N_Fail_Parent_Dead"
+	};
+	static const char* const RATE_COLUMNS[4] = {
+		"Rate_Success", "Rate_Fail_Egg_Time", "Rate_Fail_Egg_Cold", "Rate_Fail_Parent_Dead"
+	};
+
+	std::vector<std::string> ret(COUNT_COLUMNS, COUNT_COLUMNS + 5);
+	ret.insert(ret.end(), OVERALL_COLUMNS, OVERALL_COLUMNS + 8);
+	ret.insert(ret.end(), SUCCESSFUL_COLUMNS, SUCCESSFUL_COLUMNS + 12);
+	ret.insert(ret.end(), RATE_COLUMNS, RATE_COLUMNS + 4);
+	ret.insert(ret.end(), BOUT_COLUMNS, BOUT_COLUMNS + NUM_BOUT_COLUMNS);
+	return ret;
+}
+
+void writeProcessedHeader(std::ostream& out)
+{
+	for (int i = 0; i < 9; i++) {
+		out << (i == 0 ? "" : ",") << GROUP_KEYS[i];
+	}
+	std::vector<std::string> names = processedMetricNames();
+	for (unsigned int i = 0; i < names.size(); i++) {
+		out << "," << names[i];
+	}
+	out << "\n";
+}
+
+// Positions of the sims_*.csv columns processGroup() reads
+struct SimsColumns {
+    int numColumns;
+    int keys[9];
+    int hatchResult;
+    int hatchDays;
+    int totalNeglect;
+    int maxNeglect;
+    int meanEnergy_F;
+    int varEnergy_F;
+    int meanEnergy_M;
+    int varEnergy_M;
+    int seasonHistory;
+};
+
+// Split a line into its fields (start, end pairs); trailing '\r' is dropped
+static void splitFields(const char* begin, const char* end, std::vector<const char*>& fields)
+{
+	if (end > begin && end[-1] == '\r') {
+		end--;
+	}
+	fields.clear();
+	fields.push_back(begin);
+	for (const char* c = begin; c < end; c++) {
+		if (*c == ',') {
+			fields.push_back(c);
+			fields.push_back(c + 1);
+		}
+	}
+	fields.push_back(end);
+}
+
+static bool findColumns(const char* begin, const char* end, SimsColumns* cols)
+{
+	std::vector<const char*> fields;
+	splitFields(begin, end, fields);
+	cols->numColumns = fields.size() / 2;
+
+	const char* names[9 + 9] = { GROUP_KEYS[0], GROUP_KEYS[1], GROUP_KEYS[2], GROUP_KEYS[3], GROUP_KEYS[4],
+	                             GROUP_KEYS[5], GROUP_KEYS[6], GROUP_KEYS[7], GROUP_KEYS[8],
+	                             "Hatch_Result", "Hatch_Days", "Total_Neglect", "Max_Neglect",
+	                             "Mean_Energy_F", "Var_Energy_F", "Mean_Energy_M", "Var_Energy_M",
+	                             "Season_History" };
+	int* positions[9 + 9] = { &cols->keys[0], &cols->keys[1], &cols->keys[2], &cols->keys[3], &cols->keys[4],
+	                          &cols->keys[5], &cols->keys[6], &cols->keys[7], &cols->keys[8],
+	                          &cols->hatchResult, &cols->hatchDays, &cols->totalNeglect, &cols->maxNeglect,
+	                          &cols->meanEnergy_F, &cols->varEnergy_F, &cols->meanEnergy_M, &cols->varEnergy_M,
+	                          &cols->seasonHistory };
+
+	for (int n = 0; n < 9 + 9; n++) {
+		*positions[n] = -1;
+		for (int f = 0; f < cols->numColumns; f++) {
+			std::string name(fields[2 * f], fields[2 * f + 1]);
+			if (name == names[n]) {
+				*positions[n] = f;
+			}
+		}
+		if (*positions[n] < 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static double numberField(const std::vector<const char*>& fields, int col)
+{
+	const char* begin = fields[2 * col];
+	char buffer[64];
+	std::size_t length = std::min<std::size_t>(fields[2 * col + 1] - begin, sizeof(buffer) - 1);
+	std::memcpy(buffer, begin, length);
+	buffer[length] = '\0';
+	return std::strtod(buffer, nullptr);
+}
+
+enum SeasonOutcome { outcomeOther, outcomeHatched, outcomeEggTimeFail, outcomeEggColdFail, outcomeParentDead };
+
+/*
+Add one season to its combination's summary
+@param values the Overall_* values, in OVERALL_COLUMNS order
+*/
+static void addOutcome(SimsGroup& group, SeasonOutcome outcome, const double values[8],
+                       const char* history, std::size_t length)
+{
+	group.n++;
+	for (int i = 0; i < 8; i++) {
+		group.overall[i].add(values[i]);
+	}
+
+	if (outcome == outcomeEggTimeFail) {
+		group.nFailEggTime++;
+	} else if (outcome == outcomeEggColdFail) {
+		group.nFailEggCold++;
+	} else if (outcome == outcomeParentDead) {
+		group.nFailParentDead++;
+	} else if (outcome == outcomeHatched) {
+		group.nSuccess++;
+
+		for (int i = 0; i < 8; i++) {
+			group.successful[i].add(values[i]);
+		}
+
+		// Without a recorded history (RECORD_HISTORY off) attendance and bouts are NA, not zero
+		if (length == 0) {
+			return;
+		}
+
+		double hatchDays = values[7];
+		double attendance_F = std::count(history, history + length, 'F');
+		double attendance_M = std::count(history, history + length, 'M');
+		group.successful[8].add(attendance_F);
+		group.successful[9].add(attendance_F / hatchDays);
+		group.successful[10].add(attendance_M);
+		group.successful[11].add(attendance_M / hatchDays);
+
+		double bouts[NUM_BOUT_COLUMNS];
+		calcBouts(history, length, bouts);
+		for (int i = 0; i < NUM_BOUT_COLUMNS; i++) {
+			group.bouts[i].addPresent(bouts[i]);
+		}
+	}
+}
+
+static SeasonOutcome outcomeOf(const char* hatchResult, std::size_t length)
+{
+	static const char* const NAMES[4] = { "hatched", "egg time fail", "egg cold fail", "dead parent" };
+	static const SeasonOutcome OUTCOMES[4] = { outcomeHatched, outcomeEggTimeFail, outcomeEggColdFail, outcomeParentDead };
+	for (int i = 0; i < 4; i++) {
+		if (std::strlen(NAMES[i]) == length && std::memcmp(NAMES[i], hatchResult, length) == 0) {
+			return OUTCOMES[i];
+		}
+	}
+	return outcomeOther;
+}
+
+void SimsGroup::addSeason(const SeasonResult& result)
+{
+	double values[8] = { result.meanEnergy_F, result.varEnergy_F,
+	                     result.meanEnergy_M, result.varEnergy_M,
+	                     (double)result.totNeglect, (double)result.maxNeglect,
+	                     result.totNeglect / result.hatchDays, result.hatchDays };
+	addOutcome(*this, outcomeOf(result.hatchResult.data(), result.hatchResult.size()), values,
+	           result.seasonHistory.data(), result.seasonHistory.size());
+}
+
+// Add one sims_*.csv row to its combination's summary
+static void addRow(SimsGroup& group, const SimsColumns& cols, const std::vector<const char*>& fields)
+{
+	double hatchDays = numberField(fields, cols.hatchDays);
+	double totalNeglect = numberField(fields, cols.totalNeglect);
+	double values[8] = { numberField(fields, cols.meanEnergy_F), numberField(fields, cols.varEnergy_F),
+	                     numberField(fields, cols.meanEnergy_M), numberField(fields, cols.varEnergy_M),
+	                     totalNeglect, numberField(fields, cols.maxNeglect),
+	                     totalNeglect / hatchDays, hatchDays };
+
+	const char* hatchResult = fields[2 * cols.hatchResult];
+	const char* history = fields[2 * cols.seasonHistory];
+	addOutcome(group, outcomeOf(hatchResult, fields[2 * cols.hatchResult + 1] - hatchResult), values,
+	           history, fields[2 * cols.seasonHistory + 1] - history);
+}
+
+// One chunk's combinations, in file order
+struct ChunkResult {
+    std::vector<SimsGroup> groups;
+    long rows;
+    bool ok;
+};
+
+static void parseChunk(const char* begin, const char* end, const SimsColumns* cols, ChunkResult* result)
+{
+	result->rows = 0;
+	result->ok = true;
+
+	std::vector<const char*> fields;
+	std::string key;
+	const char* line = begin;
+	while (line < end) {
+		const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', end - line));
+		if (lineEnd == nullptr) {
+			lineEnd = end;
+		}
+		if (lineEnd == line || (lineEnd == line + 1 && *line == '\r')) {
+			line = lineEnd + 1;
+			continue;
+		}
+
+		splitFields(line, lineEnd, fields);
+		if (static_cast<int>(fields.size() / 2) != cols->numColumns) {
+			result->ok = false;
+			return;
+		}
+
+		key.clear();
+		for (int k = 0; k < 9; k++) {
+			if (k > 0) {
+				key += ',';
+			}
+			key.append(fields[2 * cols->keys[k]], fields[2 * cols->keys[k] + 1]);
+		}
+		if (result->groups.empty() || result->groups.back().key != key) {
+			result->groups.push_back(SimsGroup());
+			result->groups.back().key = key;
+		}
+		addRow(result->groups.back(), *cols, fields);
+		result->rows++;
+
+		line = lineEnd + 1;
+	}
+}
+
+/*
+Combinations in file order, stitched across chunk boundaries. Rows of one
+combination are expected to be contiguous, so only the combination being
+assembled is held back.
+*/
+struct GroupStitcher {
+    std::ostream* out;
+    ProcessStats* stats;
+    bool hasPending;
+    SimsGroup pending;
+    std::unordered_set<std::string> seenKeys;
+
+    GroupStitcher(std::ostream* out_, ProcessStats* stats_):
+        out(out_), stats(stats_), hasPending(false), pending(SimsGroup()) {}
+
+    /*
+    Parse a window of chunks in parallel, then write every combination they finish
+    @return false if a chunk has a malformed row
+    */
+    bool addWindow(const std::vector<const char*>& begins, const std::vector<const char*>& ends, const SimsColumns* cols);
+
+    // Write the last combination
+    void finish();
+};
+
+bool GroupStitcher::addWindow(const std::vector<const char*>& begins, const std::vector<const char*>& ends, const SimsColumns* cols)
+{
+	unsigned int count = begins.size();
+	std::vector<ChunkResult> results(count);
+	std::vector<std::thread> workers;
+	for (unsigned int i = 0; i < count; i++) {
+		workers.push_back(std::thread(parseChunk, begins[i], ends[i], cols, &results[i]));
+	}
+	for (unsigned int i = 0; i < count; i++) {
+		workers[i].join();
+	}
+
+	for (unsigned int i = 0; i < count; i++) {
+		if (!results[i].ok) {
+			return false;
+		}
+		this->stats->rows += results[i].rows;
+		for (unsigned int g = 0; g < results[i].groups.size(); g++) {
+			SimsGroup& group = results[i].groups[g];
+			if (this->hasPending && this->pending.key == group.key) {
+				this->pending.merge(group);
+				continue;
+			}
+			if (this->hasPending) {
+				this->pending.writeRow(*this->out);
+				this->stats->groups++;
+			}
+			if (!this->seenKeys.insert(group.key).second) {
+				this->stats->repeatedKeys++;
+			}
+			this->pending = group;
+			this->hasPending = true;
+		}
+	}
+	return true;
+}
+
+void GroupStitcher::finish()
+{
+	if (this->hasPending) {
+		this->pending.writeRow(*this->out);
+		this->stats->groups++;
+	}
+	this->hasPending = false;
+}
+
+// Pages of a parsed window won't be read again
+static void dropPages(const char* data, const char* windowStart, const char* windowEnd)
+{
+	std::size_t pageSize = sysconf(_SC_PAGESIZE);
+	std::size_t startOffset = (windowStart - data) / pageSize * pageSize;
+	std::size_t endOffset = (windowEnd - data) / pageSize * pageSize;
+	if (endOffset > startOffset) {
+		madvise(const_cast<char*>(data) + startOffset, endOffset - startOffset, MADV_DONTNEED);
+	}
+}
+
+static void inflateChunk(const char* data, const BgzfBlock* blocks, std::size_t count, std::string* text, char* ok)
+{
+	*ok = inflateBlocks(data, blocks, count, text);
+}
+
+/*
+A BGZF-compressed sims_*.csv.gz: chunks of consecutive blocks are
+decompressed in parallel, rows cut by a chunk boundary are carried over
+to the next chunk, and the chunks are parsed in parallel
+*/
+static bool processBgzf(const char* data, std::size_t size, GroupStitcher& stitcher,
+                        int threads, std::size_t chunkBytes)
+{
+	std::vector<BgzfBlock> blocks;
+	if (!bgzfBlocks(data, size, &blocks)) {
+		return false;
+	}
+
+	// Chunks of about chunkBytes of text
+	std::vector<std::size_t> chunkStarts(1, 0);
+	std::size_t text = 0;
+	for (std::size_t b = 0; b < blocks.size(); b++) {
+		text += blocks[b].rawSize;
+		if (text >= chunkBytes && b + 1 < blocks.size()) {
+			chunkStarts.push_back(b + 1);
+			text = 0;
+		}
+	}
+	chunkStarts.push_back(blocks.size());
+	unsigned int numChunks = chunkStarts.size() - 1;
+
+	SimsColumns cols;
+	std::string carry;
+	for (unsigned int first = 0; first < numChunks; first += threads) {
+		unsigned int count = std::min<unsigned int>(threads, numChunks - first);
+
+		std::vector<std::string> texts(count);
+		std::vector<char> inflated(count);
+		std::vector<std::thread> workers;
+		for (unsigned int i = 0; i < count; i++) {
+			std::size_t start = chunkStarts[first + i];
+			workers.push_back(std::thread(inflateChunk, data, &blocks[start], chunkStarts[first + i + 1] - start,
+			                              &texts[i], &inflated[i]));
+		}
+		for (unsigned int i = 0; i < count; i++) {
+			workers[i].join();
+		}
+
+		// Whole rows only: each chunk gives its cut-off last row to the next
+		std::vector<const char*> begins(count);
+		std::vector<const char*> ends(count);
+		for (unsigned int i = 0; i < count; i++) {
+			if (!inflated[i]) {
+				return false;
+			}
+			texts[i].insert(0, carry);
+			carry.clear();
+			if (first + i + 1 < numChunks) {
+				std::size_t cut = texts[i].rfind('\n');
+				cut = cut == std::string::npos ? 0 : cut + 1;
+				carry = texts[i].substr(cut);
+				texts[i].resize(cut);
+			}
+
+			std::size_t bodyStart = 0;
+			if (first + i == 0) {
+				std::size_t headerEnd = std::min(texts[i].find('\n'), texts[i].size());
+				if (!findColumns(texts[i].data(), texts[i].data() + headerEnd, &cols)) {
+					return false;
+				}
+				bodyStart = std::min(headerEnd + 1, texts[i].size());
+			}
+			begins[i] = texts[i].data() + bodyStart;
+			ends[i] = texts[i].data() + texts[i].size();
+		}
+
+		if (!stitcher.addWindow(begins, ends, &cols)) {
+			return false;
+		}
+		std::size_t windowEnd = chunkStarts[first + count] < blocks.size() ? blocks[chunkStarts[first + count]].offset : size;
+		dropPages(data, data + blocks[chunkStarts[first]].offset, data + windowEnd);
+	}
+	return true;
+}
+
+bool processSimsFile(const std::string& fname, std::ostream& out,
+                     int threads, std::size_t chunkBytes,
+                     ProcessStats* stats)
+{
+	*stats = ProcessStats();
+
+	int fd = open(fname.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+		close(fd);
+		return false;
+	}
+	std::size_t size = fileStat.st_size;
+	void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		return false;
+	}
+	madvise(mapping, size, MADV_SEQUENTIAL);
+	const char* data = static_cast<const char*>(mapping);
+	const char* dataEnd = data + size;
+
+	if (threads < 1) {
+		threads = 1;
+	}
+	stats->bytes = size;
+	GroupStitcher stitcher(&out, stats);
+
+	if (isBgzf(data, size)) {
+		writeProcessedHeader(out);
+		bool ok = processBgzf(data, size, stitcher, threads, chunkBytes);
+		if (ok) {
+			stitcher.finish();
+		}
+		munmap(mapping, size);
+		return ok;
+	}
+
+	// Header line
+	const char* headerEnd = static_cast<const char*>(std::memchr(data, '\n', size));
+	if (headerEnd == nullptr) {
+		headerEnd = dataEnd;
+	}
+	SimsColumns cols;
+	if (!findColumns(data, headerEnd, &cols)) {
+		munmap(mapping, size);
+		return false;
+	}
+
+	// Chunk boundaries, each just past a newline
+	std::vector<const char*> bounds;
+	bounds.push_back(headerEnd < dataEnd ? headerEnd + 1 : dataEnd);
+	while (bounds.back() < dataEnd) {
+		const char* next = bounds.back() + chunkBytes;
+		if (next >= dataEnd) {
+			bounds.push_back(dataEnd);
+			break;
+		}
+		const char* newline = static_cast<const char*>(std::memchr(next, '\n', dataEnd - next));
+		bounds.push_back(newline == nullptr ? dataEnd : newline + 1);
+	}
+
+	writeProcessedHeader(out);
+
+	bool ok = true;
+	unsigned int numChunks = bounds.size() - 1;
+	for (unsigned int first = 0; first < numChunks && ok; first += threads) {
+		unsigned int count = std::min<unsigned int>(threads, numChunks - first);
+
+		// Parse a window of chunks in parallel
+		std::vector<const char*> begins(bounds.begin() + first, bounds.begin() + first + count);
+		std::vector<const char*> ends(bounds.begin() + first + 1, bounds.begin() + first + count + 1);
+		ok = stitcher.addWindow(begins, ends, &cols);
+		dropPages(data, bounds[first], bounds[first + count]);
+	}
+
+	if (ok) {
+		stitcher.finish();
+	}
+
+	munmap(mapping, size);
+	return ok;
+}
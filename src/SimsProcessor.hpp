@@ -0,0 +1,116 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstddef>
+
+#include "Season.hpp"
+
+/*
+Native post-processing of sims_*.csv output.
+
+Produces the same table as R/process_simulation_results.r: one row per
+parameter combination (the nine GROUP_KEYS), with every processGroup()
+and calcBouts() column under the same name. NaN stands in for R's NA
+and NaN throughout, and is written as an empty field, as fwrite() does.
+*/
+
+static const int NUM_GROUP_KEYS = 9;
+
+// Columns identifying a parameter combination, as named in sims_*.csv
+extern const char* const GROUP_KEYS[NUM_GROUP_KEYS];
+
+static const int NUM_BOUT_COLUMNS = 20;
+
+// processed_*.csv columns after the GROUP_KEYS: counts, means, rates and bouts
+static const int NUM_PROCESSED_METRICS = 5 + 8 + 12 + 4 + NUM_BOUT_COLUMNS;
+
+// calcBouts() column names, in R's order
+extern const char* const BOUT_COLUMNS[NUM_BOUT_COLUMNS];
+
+/*
+Bout summaries of one season history, as calcBouts() computes them
+@param history daily 'F'/'M'/'N' season history
+@param values filled with one value per BOUT_COLUMNS entry
+*/
+void calcBouts(const char* history, std::size_t length, double values[NUM_BOUT_COLUMNS]);
+
+/*
+Running mean. Like R's mean(), the mean of nothing is NaN and a single
+NaN makes the mean NaN, unless it is added with addPresent() (na.rm = TRUE)
+*/
+struct RunningMean {
+    long double sum;
+    long count;
+
+    void add(double x) { this->sum += x; this->count++; }
+    void addPresent(double x) { if (x == x) { add(x); } }
+    void merge(const RunningMean& other) { this->sum += other.sum; this->count += other.count; }
+    double mean() const;
+};
+
+/*
+Streaming summary of a single parameter combination (processGroup()).
+Rows can be added in any order, and summaries of two parts of the same
+combination merge exactly (e.g. across chunk boundaries).
+*/
+struct SimsGroup {
+    std::string key;                // the GROUP_KEYS fields, comma-separated as written
+    long n;
+    long nSuccess;
+    long nFailEggTime;
+    long nFailEggCold;
+    long nFailParentDead;
+    RunningMean overall[8];         // Overall_* columns
+    RunningMean successful[12];     // Successful_* columns
+    RunningMean bouts[NUM_BOUT_COLUMNS];    // calcBouts() means over successful seasons
+
+    /*
+    Add a season straight from the simulation, without a sims_*.csv round
+    trip (values keep full precision; attendance and bouts need the season
+    history, and are NA for a combination without one)
+    */
+    void addSeason(const SeasonResult& result);
+
+    void merge(const SimsGroup& other);
+
+    // Every processed_*.csv value after the keys, in column order (NaN for NA)
+    void metrics(double values[NUM_PROCESSED_METRICS]) const;
+
+    // Write the processed_*.csv row
+    void writeRow(std::ostream& out) const;
+};
+
+// Names of the metrics() values, as in the processed_*.csv header
+std::vector<std::string> processedMetricNames();
+
+// Write the processed_*.csv header line
+void writeProcessedHeader(std::ostream& out);
+
+// Work done by processSimsFile()
+struct ProcessStats {
+    long rows;
+    long groups;
+    long repeatedKeys;              // combinations that reappear after other rows (see processSimsFile())
+    std::size_t bytes;
+};
+
+/*
+Summarize a whole sims_*.csv file in one streaming pass.
+
+The file is memory-mapped and cut into chunks of about chunkBytes, each
+ending on a row boundary. Up to `threads` chunks are parsed at once,
+each into the combinations it holds; a combination cut by a chunk
+boundary is merged with its other part. Rows of one combination are
+expected to be contiguous, as runModel() writes them, so only the
+combination being assembled is ever held back and memory stays bounded
+by the chunks in flight. A combination that reappears later is counted
+in repeatedKeys and summarized as a separate row.
+A BGZF-compressed sims_*.csv.gz (COMPRESS_OUTPUT) is read the same way,
+its blocks decompressed chunk by chunk in parallel.
+@return false if the file can't be mapped, lacks a column or has a malformed row
+*/
+bool processSimsFile(const std::string& fname, std::ostream& out,
+                     int threads, std::size_t chunkBytes,
+                     ProcessStats* stats);
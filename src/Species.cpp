@@ -0,0 +1,35 @@
+#include "Species.hpp"
+
+const SpeciesParams* speciesParams(SpeciesId id)
+{
+	if (id == SpeciesId::forkTailed) {
+		return speciesParams<ForkTailedStormPetrel>();
+	} else if (id == SpeciesId::european) {
+		return speciesParams<EuropeanStormPetrel>();
+	}
+	return speciesParams<LeachsStormPetrel>();
+}
+
+static const SpeciesId SPECIES_IDS[] = { SpeciesId::leachs, SpeciesId::forkTailed, SpeciesId::european };
+static const char* const SPECIES_NAMES[] = { "leachs", "forkTailed", "european" };
+
+const char* speciesName(SpeciesId id)
+{
+	for (int i = 0; i < 3; i++) {
+		if (SPECIES_IDS[i] == id) {
+			return SPECIES_NAMES[i];
+		}
+	}
+	return SPECIES_NAMES[0];
+}
+
+bool findSpecies(const std::string& name, SpeciesId* id)
+{
+	for (int i = 0; i < 3; i++) {
+		if (name == SPECIES_NAMES[i]) {
+			*id = SPECIES_IDS[i];
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "SummaryTensor.hpp"
+
+static const int NUM_TENSOR_AXES = 8;
+static const char* const TENSOR_AXES[NUM_TENSOR_AXES] = {
+	"Min_Energy_Thresh_F", "Max_Energy_Thresh_F",
+	"Min_Energy_Thresh_M", "Max_Energy_Thresh_M",
+	"Foraging_Condition_Mean", "Foraging_Condition_SD",
+	"Egg_Tolerance", "Egg_Cost"
+};
+
+static const std::size_t TENSOR_PAGE = 4096;
+
+SummaryTensor::SummaryTensor():
+	axes(std::vector< std::vector<double> >()),
+	cells(0),
+	mapping(nullptr),
+	size(0),
+	data(nullptr),
+	mask(nullptr)
+{}
+
+SummaryTensor::~SummaryTensor()
+{
+	close();
+}
+
+bool SummaryTensor::create(const std::string& fname, const Scenario& scenario, int numParents)
+{
+	close();
+
+	this->axes.clear();
+	this->axes.push_back(scenario.minEnergyThresh_F);
+	this->axes.push_back(scenario.maxEnergyThresh_F);
+	this->axes.push_back(scenario.minEnergyThresh_M);
+	this->axes.push_back(scenario.maxEnergyThresh_M);
+	this->axes.push_back(scenario.foragingMean);
+	this->axes.push_back(scenario.foragingSD);
+	this->axes.push_back(std::vector<double>(scenario.eggTolerance.begin(), scenario.eggTolerance.end()));
+	this->axes.push_back(scenario.eggCost);
+
+	this->cells = 1;
+	for (int a = 0; a < NUM_TENSOR_AXES; a++) {
+		this->cells *= this->axes[a].size();
+	}
+
+	std::vector<std::string> metricNames = processedMetricNames();
+	std::size_t dataBytes = metricNames.size() * this->cells * sizeof(float);
+
+	// Header text, then its size rounded up to whole pages
+	uint16_t byteOrder = 1;
+	std::ostringstream header;
+	header << "lhsp_summary_tensor 1\n"
+	       << "scenario " << scenario.name << "\n"
+	       << "num_parents " << numParents << "\n"
+	       << "dtype float32\n"
+	       << "byte_order " << (*reinterpret_cast<unsigned char*>(&byteOrder) == 1 ? "little" : "big") << "\n"
+	       << "layout column_major\n"
+	       << "cells " << this->cells << "\n"
+	       << "axes " << NUM_TENSOR_AXES << "\n";
+	// Axis values round-trip exactly, so they match the grids they label
+	header << std::setprecision(17);
+	for (int a = 0; a < NUM_TENSOR_AXES; a++) {
+		header << "axis " << TENSOR_AXES[a] << " " << this->axes[a].size();
+		for (unsigned int i = 0; i < this->axes[a].size(); i++) {
+			header << " " << this->axes[a][i];
+		}
+		header << "\n";
+	}
+	header << "metrics " << metricNames.size() << "\n";
+	for (unsigned int m = 0; m < metricNames.size(); m++) {
+		header << "metric " << metricNames[m] << "\n";
+	}
+	std::string fixed = header.str();
+
+	// The offsets are part of the header, so size it with room for them
+	std::size_t dataOffset = TENSOR_PAGE * ((fixed.size() + 64) / TENSOR_PAGE + 1);
+	std::size_t maskOffset = dataOffset + dataBytes;
+	header << "data_offset " << dataOffset << "\n"
+	       << "mask_offset " << maskOffset << "\n"
+	       << "end\n";
+	std::string text = header.str();
+
+	this->size = maskOffset + this->cells;
+	int fd = open(fname.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		return false;
+	}
+	if (ftruncate(fd, this->size) != 0) {
+		::close(fd);
+		return false;
+	}
+	void* mapped = mmap(nullptr, this->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (mapped == MAP_FAILED) {
+		return false;
+	}
+	this->mapping = static_cast<char*>(mapped);
+	this->data = reinterpret_cast<float*>(this->mapping + dataOffset);
+	this->mask = reinterpret_cast<unsigned char*>(this->mapping + maskOffset);
+
+	// Newline padding after "end"; the file is otherwise zeros, so the mask starts all 0
+	std::memset(this->mapping, '\n', dataOffset);
+	std::memcpy(this->mapping, text.data(), text.size());
+	std::fill(this->data, this->data + metricNames.size() * this->cells, std::numeric_limits<float>::quiet_NaN());
+	return true;
+}
+
+long SummaryTensor::cellIndex(const ComboParams& combo) const
+{
+	double values[NUM_TENSOR_AXES] = {
+		combo.minEnergyThresh_F, combo.maxEnergyThresh_F,
+		combo.minEnergyThresh_M, combo.maxEnergyThresh_M,
+		combo.foragingMean, combo.foragingSD,
+		(double)combo.eggTolerance, combo.eggCost
+	};
+
+	long index = 0;
+	long stride = 1;
+	for (int a = 0; a < NUM_TENSOR_AXES; a++) {
+		const std::vector<double>& axis = this->axes[a];
+		long i = std::find(axis.begin(), axis.end(), values[a]) - axis.begin();
+		if (i == (long)axis.size()) {
+			return -1;
+		}
+		index += i * stride;
+		stride *= axis.size();
+	}
+	return index;
+}
+
+void SummaryTensor::setCell(const ComboParams& combo, const SimsGroup& group)
+{
+	long cell = cellIndex(combo);
+	if (this->mapping == nullptr || cell < 0) {
+		return;
+	}
+
+	double values[NUM_PROCESSED_METRICS];
+	group.metrics(values);
+	for (int m = 0; m < NUM_PROCESSED_METRICS; m++) {
+		this->data[m * this->cells + cell] = static_cast<float>(values[m]);
+	}
+	this->mask[cell] = 1;
+}
+
+void SummaryTensor::close()
+{
+	if (this->mapping != nullptr) {
+		munmap(this->mapping, this->size);
+	}
+	this->mapping = nullptr;
+	this->data = nullptr;
+	this->mask = nullptr;
+	this->size = 0;
+}
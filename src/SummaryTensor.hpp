@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "Scenario.hpp"
+#include "SimsProcessor.hpp"
+
+/*
+Dense summary tensors: every processed_*.csv metric of a scenario (counts,
+rates, mean energies, bout means; see SimsGroup::metrics()) as an
+N-dimensional float32 array over the scenario's parameter grids, one axis
+per swept parameter (the GROUP_KEYS but Num_Parents) with the values of
+its paramVector() grid, so a 2-D plane for a heatmap is read straight out
+of the file with no group-by.
+
+The file starts with a text header, padded with newlines to a multiple of
+4096 bytes:
+
+    lhsp_summary_tensor 1
+    scenario regular
+    num_parents 2
+    dtype float32
+    byte_order little
+    layout column_major             (first axis varies fastest, as R arrays)
+    cells 583200
+    axes 8
+    axis Min_Energy_Thresh_F 10 200 300 ...     (name, length, values to 17 digits)
+    ...
+    metrics 49
+    metric N_Total
+    ...
+    data_offset 4096                (metric m at data_offset + m * cells * 4)
+    mask_offset 114311296           (one byte per cell)
+    end
+
+Cells whose mask byte is 0 are NaN in every metric: combinations skipped
+because a hunger threshold is not below the satiation threshold, and
+combinations not yet run. The file is written in place as combinations
+finish, so a partial run is still a valid tensor.
+*/
+class SummaryTensor {
+
+public:
+
+    SummaryTensor();
+    ~SummaryTensor();
+
+    /*
+    Create the tensor file for a scenario, every cell masked
+    @return false if the file can't be created or mapped
+    */
+    bool create(const std::string& fname, const Scenario& scenario, int numParents);
+
+    // Fill a combination's cell from its summary and unmask it
+    void setCell(const ComboParams& combo, const SimsGroup& group);
+
+    // Unmap the file (also done on destruction)
+    void close();
+
+private:
+
+    // Column-major index of a combination's cell, or -1 if off the grid
+    long cellIndex(const ComboParams& combo) const;
+
+    std::vector< std::vector<double> > axes;    // parameter values, in TENSOR_AXES order
+    long cells;
+    char* mapping;
+    std::size_t size;
+    float* data;
+    unsigned char* mask;
+};
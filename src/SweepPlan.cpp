@@ -0,0 +1,61 @@
+#include <algorithm>
+#include <cmath>
+
+#include "SweepPlan.hpp"
+
+std::vector<SweepTask> planSweeps(std::vector<SweepJob>& jobs, int workers)
+{
+	double totalCost = 0;
+	for (unsigned int j = 0; j < jobs.size(); j++) {
+		jobs[j].cost = (double)jobs[j].combos * jobs[j].iterations * jobs[j].numParents;
+		totalCost += jobs[j].cost;
+	}
+
+	// Costliest first; ties keep scenario order
+	std::vector<int> order;
+	for (unsigned int j = 0; j < jobs.size(); j++) {
+		order.push_back(j);
+	}
+	std::stable_sort(order.begin(), order.end(), [&jobs](int a, int b) { return jobs[a].cost > jobs[b].cost; });
+
+	double taskCost = totalCost / (std::max(1, workers) * TASKS_PER_WORKER);
+	std::vector<SweepTask> tasks;
+	for (unsigned int k = 0; k < order.size(); k++) {
+		const SweepJob& job = jobs[order[k]];
+		double comboCost = (double)job.iterations * job.numParents;
+		long taskCombos = std::max(1L, (long)std::floor(taskCost / comboCost));
+		taskCombos = std::min(taskCombos, std::max(1L, MAX_TASK_SEASONS / job.iterations));
+
+		for (long first = 0; first < job.combos; first += taskCombos) {
+			SweepTask task = { order[k], first, std::min(job.combos, first + taskCombos) };
+			tasks.push_back(task);
+		}
+	}
+	return tasks;
+}
+
+void printSweepPlan(const std::vector<SweepJob>& jobs, const std::vector<SweepTask>& tasks,
+                    int workers, std::ostream& out)
+{
+	double totalCost = 0;
+	for (unsigned int j = 0; j < jobs.size(); j++) {
+		totalCost += jobs[j].cost;
+	}
+
+	out << "Plan for " << jobs.size() << " scenarios on " << workers << " workers, "
+	    << tasks.size() << " tasks:\n";
+	for (unsigned int t = 0; t < tasks.size(); t++) {
+		// One line per job, where its first task is queued
+		if (t > 0 && tasks[t].job == tasks[t-1].job) {
+			continue;
+		}
+		const SweepJob& job = jobs[tasks[t].job];
+		long jobTasks = std::count_if(tasks.begin(), tasks.end(),
+		                              [&tasks, t](const SweepTask& x) { return x.job == tasks[t].job; });
+		out << "  " << job.name
+		    << ": " << job.combos << " combinations x " << job.iterations << " iterations"
+		    << (job.numParents == 1 ? " (one parent)" : "")
+		    << ", " << std::round(job.cost / std::max(totalCost, 1.0) * 1000) / 10 << "% of the cost, "
+		    << jobTasks << " tasks\n";
+	}
+}
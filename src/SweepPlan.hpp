@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+/*
+Plan for running several scenarios as one job on a shared pool of workers.
+
+Each scenario's cost is estimated from its size: combinations x iterations
+x parents simulated (a one-parent season simulates half the birds). The
+scenarios are cut into tasks of consecutive combinations, and the task
+queue takes the costliest scenario first, in combination order, so
+workers finishing a scenario move straight on to the next one instead of
+waiting for its slowest task, and the smallest scenarios fill the end of
+the run. Only the scenarios at the front of the queue are open at once.
+
+Tasks hold about 1/TASKS_PER_WORKER of a worker's share of the job, so the
+pool stays balanced, but never more than MAX_TASK_SEASONS seasons, which
+bounds the output a worker buffers before it is written in order.
+*/
+
+static const int TASKS_PER_WORKER = 16;
+static const long MAX_TASK_SEASONS = 100000;
+
+// A scenario to run
+struct SweepJob {
+    std::string name;
+    int scenarioIndex;              // position in the scenario list (part of every seed)
+    long combos;
+    int iterations;
+    int numParents;
+    double cost;                    // estimated, in parent-seasons (see planSweeps())
+};
+
+// Consecutive combinations [firstCombo, endCombo) of a job
+struct SweepTask {
+    int job;
+    long firstCombo;
+    long endCombo;
+};
+
+/*
+Estimate every job's cost and cut the jobs into tasks, in queue order
+@param workers size of the worker pool
+*/
+std::vector<SweepTask> planSweeps(std::vector<SweepJob>& jobs, int workers);
+
+// Print the plan: every job's cost, share of the total and tasks, in queue order
+void printSweepPlan(const std::vector<SweepJob>& jobs, const std::vector<SweepTask>& tasks,
+                    int workers, std::ostream& out);
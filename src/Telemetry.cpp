@@ -0,0 +1,192 @@
+#include <fstream>
+#include <cstdio>
+
+#include "Telemetry.hpp"
+
+void TelemetryCounters::addSeason(const SeasonResult& result)
+{
+	this->seasons++;
+	this->days += result.seasonDays;
+	this->foragingDraws += result.foragingDraws;
+	this->tieBreaks += result.tieBreaks;
+
+	if (result.hatchResult == "hatched") { this->hatched++; }
+	else if (result.hatchResult == "egg cold fail") { this->eggColdFails++; }
+	else if (result.hatchResult == "egg time fail") { this->eggTimeFails++; }
+	else if (result.hatchResult == "dead parent") { this->deadParents++; }
+}
+
+void TelemetryCounters::merge(const TelemetryCounters& other)
+{
+	this->seasons += other.seasons;
+	this->days += other.days;
+	this->foragingDraws += other.foragingDraws;
+	this->tieBreaks += other.tieBreaks;
+	this->hatched += other.hatched;
+	this->eggColdFails += other.eggColdFails;
+	this->eggTimeFails += other.eggTimeFails;
+	this->deadParents += other.deadParents;
+	this->bytesWritten += other.bytesWritten;
+	this->simulationSeconds += other.simulationSeconds;
+	this->formattingSeconds += other.formattingSeconds;
+	this->ioSeconds += other.ioSeconds;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+Telemetry::Telemetry(std::string statusFileName_, double intervalSeconds_):
+	statusFileName(statusFileName_),
+	intervalSeconds(intervalSeconds_),
+	startTime(std::chrono::steady_clock::now()),
+	lastWrite(std::chrono::steady_clock::now()),
+	scenarios(std::vector<ScenarioTelemetry>())
+{}
+
+int Telemetry::addScenario(std::string name, long totalCombos)
+{
+	std::lock_guard<std::mutex> guard(this->lock);
+
+	ScenarioTelemetry scenario = ScenarioTelemetry();
+	scenario.name = name;
+	scenario.status = "pending";
+	scenario.totalCombos = totalCombos;
+	scenario.combosDone = 0;
+	scenario.counters = TelemetryCounters();
+	scenario.wallSeconds = 0;
+	this->scenarios.push_back(scenario);
+	return this->scenarios.size() - 1;
+}
+
+void Telemetry::beginScenario(int scenario)
+{
+	std::lock_guard<std::mutex> guard(this->lock);
+	this->scenarios[scenario].status = "running";
+	this->scenarios[scenario].startTime = std::chrono::steady_clock::now();
+	writeStatusLocked();
+}
+
+void Telemetry::endScenario(int scenario)
+{
+	std::lock_guard<std::mutex> guard(this->lock);
+	this->scenarios[scenario].status = "done";
+	this->scenarios[scenario].wallSeconds = secondsSince(this->scenarios[scenario].startTime);
+	writeStatusLocked();
+}
+
+void Telemetry::comboDone(int scenario, const TelemetryCounters& counters, int combos)
+{
+	std::lock_guard<std::mutex> guard(this->lock);
+	this->scenarios[scenario].counters.merge(counters);
+	this->scenarios[scenario].combosDone += combos;
+
+	if (secondsSince(this->lastWrite) >= this->intervalSeconds) {
+		writeStatusLocked();
+	}
+}
+
+TelemetryCounters Telemetry::getCounters(int scenario)
+{
+	std::lock_guard<std::mutex> guard(this->lock);
+	return this->scenarios[scenario].counters;
+}
+
+// A string's contents as a JSON string literal body (quotes, backslashes and control characters escaped)
+static std::string jsonEscape(const std::string& text)
+{
+	std::string escaped;
+	for (unsigned int i = 0; i < text.size(); i++) {
+		unsigned char c = text[i];
+		if (c == '"' || c == '\\') {
+			escaped += '\\';
+			escaped += c;
+		} else if (c < 0x20) {
+			char code[8];
+			std::snprintf(code, sizeof(code), "\\u%04x", c);
+			escaped += code;
+		} else {
+			escaped += c;
+		}
+	}
+	return escaped;
+}
+
+void Telemetry::writeStatus()
+{
+	std::lock_guard<std::mutex> guard(this->lock);
+	writeStatusLocked();
+}
+
+/*
+Write the status file as a whole to a temporary file, then rename it over
+the old one, so a reader never sees a half-written file
+*/
+void Telemetry::writeStatusLocked()
+{
+	this->lastWrite = std::chrono::steady_clock::now();
+	if (this->statusFileName.empty()) {
+		return;
+	}
+
+	std::string tmpFileName = this->statusFileName + ".tmp";
+	std::ofstream out;
+	out.open(tmpFileName, std::ofstream::trunc);
+	if (!out.is_open()) {
+		return;
+	}
+
+	out << "{\n"
+	    << "  \"elapsed_seconds\": " << secondsSince(this->startTime) << ",\n"
+	    << "  \"scenarios\": [";
+
+	for (unsigned int i = 0; i < this->scenarios.size(); i++) {
+		ScenarioTelemetry& s = this->scenarios[i];
+		TelemetryCounters& c = s.counters;
+
+		double wallSeconds = s.wallSeconds;
+		if (s.status == "running") {
+			wallSeconds = secondsSince(s.startTime);
+		}
+
+		// Remaining time, assuming the remaining combinations run at the average rate so far
+		double etaSeconds = -1;
+		if (s.status == "done") {
+			etaSeconds = 0;
+		} else if (s.combosDone > 0) {
+			etaSeconds = wallSeconds / s.combosDone * (s.totalCombos - s.combosDone);
+		}
+
+		double seasonsPerSec = wallSeconds > 0 ? c.seasons / wallSeconds : 0;
+		double daysPerSec = wallSeconds > 0 ? c.days / wallSeconds : 0;
+
+		out << (i == 0 ? "\n" : ",\n")
+		    << "    {\"name\": \"" << jsonEscape(s.name) << "\", "
+		    << "\"status\": \"" << s.status << "\",\n"
+		    << "     \"combos_done\": " << s.combosDone << ", "
+		    << "\"combos_total\": " << s.totalCombos << ", "
+		    << "\"wall_seconds\": " << wallSeconds << ", "
+		    << "\"eta_seconds\": " << etaSeconds << ",\n"
+		    << "     \"seasons\": " << c.seasons << ", "
+		    << "\"days\": " << c.days << ", "
+		    << "\"foraging_draws\": " << c.foragingDraws << ", "
+		    << "\"tie_breaks\": " << c.tieBreaks << ", "
+		    << "\"bytes_written\": " << c.bytesWritten << ",\n"
+		    << "     \"hatched\": " << c.hatched << ", "
+		    << "\"egg_cold_fail\": " << c.eggColdFails << ", "
+		    << "\"egg_time_fail\": " << c.eggTimeFails << ", "
+		    << "\"dead_parent\": " << c.deadParents << ",\n"
+		    << "     \"simulation_seconds\": " << c.simulationSeconds << ", "
+		    << "\"formatting_seconds\": " << c.formattingSeconds << ", "
+		    << "\"io_seconds\": " << c.ioSeconds << ",\n"
+		    << "     \"seasons_per_sec\": " << seasonsPerSec << ", "
+		    << "\"days_per_sec\": " << daysPerSec << "}";
+	}
+
+	out << "\n  ]\n}\n";
+	out.close();
+
+	std::rename(tmpFileName.c_str(), this->statusFileName.c_str());
+}
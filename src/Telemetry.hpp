@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+#include "Season.hpp"
+
+/*
+Work counters and phase timers for a batch of seasons.
+Each worker fills its own counters without locking; Telemetry merges
+them into the scenario totals once per parameter combination.
+*/
+struct TelemetryCounters {
+    long seasons;
+    long days;
+    long foragingDraws;
+    long tieBreaks;
+    long hatched;
+    long eggColdFails;
+    long eggTimeFails;
+    long deadParents;
+    long bytesWritten;
+    double simulationSeconds;
+    double formattingSeconds;
+    double ioSeconds;
+
+    // Count one simulated season
+    void addSeason(const SeasonResult& result);
+
+    // Add another set of counters (e.g. from another thread)
+    void merge(const TelemetryCounters& other);
+};
+
+// Seconds elapsed since a steady clock time point
+double secondsSince(std::chrono::steady_clock::time_point start);
+
+/*
+Per-scenario telemetry for a model run.
+Scenario totals are updated under a lock once per combination, and a JSON
+status file (throughput, ETA and where the time goes, per scenario) is
+rewritten at most every intervalSeconds, so long cluster jobs can be
+monitored by reading the file.
+*/
+class Telemetry {
+
+public:
+
+    /*
+    Constructor
+    @param statusFileName_ JSON status file (empty for no status file)
+    @param intervalSeconds_ minimum time between status file rewrites
+    */
+    Telemetry(std::string statusFileName_, double intervalSeconds_);
+
+    // Register a scenario before it runs, so the status file lists it as pending
+    int addScenario(std::string name, long totalCombos);
+
+    void beginScenario(int scenario);
+    void endScenario(int scenario);
+
+    // Merge a worker's counters for finished combinations (0 for work outside a combination)
+    void comboDone(int scenario, const TelemetryCounters& counters, int combos = 1);
+
+    // Scenario totals so far
+    TelemetryCounters getCounters(int scenario);
+
+    // Rewrite the status file now
+    void writeStatus();
+
+private:
+
+    struct ScenarioTelemetry {
+        std::string name;
+        std::string status;         // "pending", "running" or "done"
+        long totalCombos;
+        long combosDone;
+        TelemetryCounters counters;
+        std::chrono::steady_clock::time_point startTime;
+        double wallSeconds;         // elapsed (running) or total (done) wall time
+    };
+
+    void writeStatusLocked();
+
+    std::string statusFileName;
+    double intervalSeconds;
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::time_point lastWrite;
+    std::vector<ScenarioTelemetry> scenarios;
+    std::mutex lock;
+};
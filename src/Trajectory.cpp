@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <sstream>
+
+#include "Trajectory.hpp"
+
+static const std::size_t TRAJECTORY_PAGE = 4096;
+
+TrajectorySink::TrajectorySink():
+	rate(0),
+	outcomes(std::vector<std::string>()),
+	offset(0),
+	seasons(0),
+	packed(std::vector<float>())
+{}
+
+TrajectorySink::~TrajectorySink()
+{
+	close();
+}
+
+bool TrajectorySink::open(const std::string& fname, const std::string& indexName, const std::string& scenarioName,
+                          double rate_, const std::vector<std::string>& outcomes_)
+{
+	close();
+	this->rate = rate_;
+	this->outcomes = outcomes_;
+	this->seasons = 0;
+
+	this->data.open(fname, std::ofstream::binary | std::ofstream::trunc);
+	this->index.open(indexName, std::ofstream::trunc);
+	if (!this->data.is_open() || !this->index.is_open()) {
+		close();
+		return false;
+	}
+
+	// Index file named without its directory, as it sits next to the data file
+	std::string indexBase = indexName.substr(indexName.find_last_of('/') + 1);
+	uint16_t byteOrder = 1;
+	std::ostringstream header;
+	header << "lhsp_trajectories 1\n"
+	       << "scenario " << scenarioName << "\n"
+	       << "dtype float32\n"
+	       << "byte_order " << (*reinterpret_cast<unsigned char*>(&byteOrder) == 1 ? "little" : "big") << "\n"
+	       << "index " << indexBase << "\n"
+	       << "data_offset " << TRAJECTORY_PAGE << "\n"
+	       << "end\n";
+	std::string text = header.str();
+	text.resize(TRAJECTORY_PAGE, '\n');
+	this->data.write(text.data(), text.size());
+	this->offset = TRAJECTORY_PAGE;
+
+	this->index << "Combo" << ","
+	            << "Iteration" << ","
+	            << "Min_Energy_Thresh_F" << ","
+	            << "Max_Energy_Thresh_F" << ","
+	            << "Min_Energy_Thresh_M" << ","
+	            << "Max_Energy_Thresh_M" << ","
+	            << "Foraging_Condition_Mean" << ","
+	            << "Foraging_Condition_SD" << ","
+	            << "Egg_Tolerance" << ","
+	            << "Egg_Cost" << ","
+	            << "Num_Parents" << ","
+	            << "Hatch_Result" << ","
+	            << "Offset" << ","
+	            << "Days_F" << ","
+	            << "Days_M" << "\n";
+	return true;
+}
+
+/*
+The seed is remixed (murmur3's 64-bit finalizer) so the choice doesn't
+follow the bits the season's own random stream starts from
+*/
+bool TrajectorySink::sampled(uint64_t replicateSeed) const
+{
+	uint64_t x = replicateSeed ^ 0x9e3779b97f4a7c15ULL;
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return (x >> 32) < this->rate * 4294967296.0;
+}
+
+bool TrajectorySink::keeps(const SeasonResult& result) const
+{
+	return this->outcomes.empty() ||
+	       std::find(this->outcomes.begin(), this->outcomes.end(), result.hatchResult) != this->outcomes.end();
+}
+
+void TrajectorySink::addSeason(const TrajectoryRecord& record)
+{
+	const ComboParams& combo = record.combo;
+	const SeasonTrajectory& trajectory = record.trajectory;
+
+	this->packed.assign(trajectory.energy_F.begin(), trajectory.energy_F.end());
+	this->packed.insert(this->packed.end(), trajectory.energy_M.begin(), trajectory.energy_M.end());
+	this->data.write(reinterpret_cast<const char*>(this->packed.data()), this->packed.size() * sizeof(float));
+
+	this->index << record.comboIndex << ","
+	            << record.iteration << ","
+	            << combo.minEnergyThresh_F << ","
+	            << combo.maxEnergyThresh_F << ","
+	            << combo.minEnergyThresh_M << ","
+	            << combo.maxEnergyThresh_M << ","
+	            << combo.foragingMean << ","
+	            << combo.foragingSD << ","
+	            << combo.eggTolerance << ","
+	            << combo.eggCost << ","
+	            << record.result.numParents << ","
+	            << record.result.hatchResult << ","
+	            << this->offset << ","
+	            << trajectory.energy_F.size() << ","
+	            << trajectory.energy_M.size() << "\n";
+
+	this->offset += this->packed.size() * sizeof(float);
+	this->seasons++;
+}
+
+bool TrajectorySink::close()
+{
+	if (!this->data.is_open() && !this->index.is_open()) {
+		return true;
+	}
+	bool ok = this->data.good() && this->index.good();
+	this->data.close();
+	this->index.close();
+	return ok && !this->data.fail() && !this->index.fail();
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+
+#include "Season.hpp"
+
+/*
+Daily energy trajectories of sampled seasons, too long for the sims_*.csv
+output, packed into a binary side file with a CSV index.
+
+The data file starts with a text header, padded with newlines to 4096
+bytes, followed by one record per season: the female's daily energies,
+then the male's, as float32:
+
+    lhsp_trajectories 1
+    scenario regular
+    dtype float32
+    byte_order little
+    index trajectories_regular_<suffix>.csv
+    data_offset 4096
+    end
+
+The index has a row per record: its combination (index in the sweep
+order, see scenarioCombos()) and iteration, the combination's parameters
+and outcome as in the sims_*.csv output, and where its energies are
+(Offset in bytes from the start of the file, Days_F then Days_M values).
+
+Seasons are sampled by replicate seed at a given rate, so a rerun with the
+same base seed samples the same seasons, and kept only if their outcome is
+one of the given Hatch_Results (any if none are given). Sampling is
+thread-safe; workers collect kept seasons in their own TrajectoryBatch.
+*/
+// A kept season, waiting to be written
+struct TrajectoryRecord {
+    long comboIndex;
+    int iteration;
+    ComboParams combo;
+    SeasonResult result;
+    SeasonTrajectory trajectory;
+};
+
+class TrajectorySink;
+
+// Seasons kept by one worker, written out in combination order by the sink
+struct TrajectoryBatch {
+    const TrajectorySink* sink;     // sampling rate and outcome filter
+    std::vector<TrajectoryRecord> records;
+};
+
+class TrajectorySink {
+
+public:
+
+    TrajectorySink();
+    ~TrajectorySink();
+
+    /*
+    Create the data file and its index
+    @param rate share of seasons sampled (0 - 1)
+    @param outcomes Hatch_Results of the seasons kept (any if empty)
+    @return false if either file can't be created
+    */
+    bool open(const std::string& fname, const std::string& indexName, const std::string& scenarioName,
+              double rate, const std::vector<std::string>& outcomes);
+
+    // Is the season with this replicate seed sampled? (decided before it runs)
+    bool sampled(uint64_t replicateSeed) const;
+
+    // Is a sampled season kept, given its outcome?
+    bool keeps(const SeasonResult& result) const;
+
+    // Append a kept season's record and index row
+    void addSeason(const TrajectoryRecord& record);
+
+    // Close both files; false if any write failed
+    bool close();
+
+    bool is_open() const { return this->data.is_open(); }
+    long getSeasons() const { return this->seasons; }
+
+private:
+
+    std::ofstream data;
+    std::ofstream index;
+    double rate;
+    std::vector<std::string> outcomes;
+    uint64_t offset;                // of the next record in the data file
+    long seasons;                   // records written
+    std::vector<float> packed;      // a record being packed
+};
@@ -137,6 +137,10 @@ std::string checkSeasonSuccess(Parent& pf, Egg& egg)
 }
 
 void printDailyInfo(Parent& pf, Parent& pm, Egg& egg) {
+	printDailyInfo(pf, pm, egg, std::cout);
+}
+
+void printDailyInfo(Parent& pf, Parent& pm, Egg& egg, std::ostream& out) {
 	int days = egg.getIncubationDays();
 	double maxDays = egg.getMaxHatchDays();
 	int eggNeglect = egg.getTotNeg();
@@ -147,10 +151,40 @@ void printDailyInfo(Parent& pf, Parent& pm, Egg& egg) {
 	double maleEnergy = pm.getEnergy();
 	std::string maleState = pm.getStrState();
 
-	std::cout << "On day " << days << " of " << maxDays
+	out << "On day " << days << " of " << maxDays
 	   	      << " with egg neglect " << eggNeglect << ".///"
 	   	      << " Female is " << femaleState
 	   	      << " with " << femaleEnergy << " energy.///"
 	   	      << " Male is " << maleState
 	   	      << " with " << maleEnergy << " energy.///\n";
+}
+
+void printDailyTraceHeader(std::ostream& out) {
+	out << "Day" << ","
+	    << "State_F" << ","
+	    << "Energy_F" << ","
+	    << "State_M" << ","
+	    << "Energy_M" << ","
+	    << "Egg_Age" << ","
+	    << "Egg_Hatch_Days" << ","
+	    << "Egg_Neglect_Streak" << ","
+	    << "Egg_Total_Neglect" << ","
+	    << "Egg_Max_Neglect" << ","
+	    << "Egg_Alive" << ","
+	    << "Egg_Hatched" << "\n";
+}
+
+void printDailyTrace(Parent& pf, Parent& pm, Egg& egg, std::ostream& out) {
+	out << pf.getDay() << ","
+	    << pf.getStrState() << ","
+	    << pf.getEnergy() << ","
+	    << pm.getStrState() << ","
+	    << pm.getEnergy() << ","
+	    << egg.getIncubationDays() << ","
+	    << egg.getHatchDays() << ","
+	    << egg.getCurrNeg() << ","
+	    << egg.getTotNeg() << ","
+	    << egg.getMaxNeg() << ","
+	    << egg.isAlive() << ","
+	    << egg.isHatched() << "\n";
 }
\ No newline at end of file
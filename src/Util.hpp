@@ -35,3 +35,8 @@ std::string checkSeasonSuccess(Parent&, Egg&); // overloaded 1 parent
 
 // Print a day's energetic and state information to the system
 void printDailyInfo(Parent&, Parent&, Egg&);
+void printDailyInfo(Parent&, Parent&, Egg&, std::ostream&); // overloaded output stream
+
+// Print a day's full state (energies, states, egg counters) as a CSV trace row
+void printDailyTraceHeader(std::ostream&);
+void printDailyTrace(Parent&, Parent&, Egg&, std::ostream&);
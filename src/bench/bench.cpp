@@ -0,0 +1,221 @@
+/*
+Micro and macro benchmarks for the simulation core (make bench).
+
+Every benchmark runs on a fixed seed and a representative parameter set,
+repeating until it has run for at least MIN_SECONDS. Results are printed
+as one JSON object per line, so runs before and after an engine change
+can be diffed or loaded straight into R (jsonlite::stream_in).
+*/
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+
+#include "../Parent.hpp"
+#include "../Egg.hpp"
+#include "../Season.hpp"
+#include "../Output.hpp"
+
+static const double MIN_SECONDS = 0.5;
+static const unsigned int SEED = 12345;
+static const int COMBO_REPLICATES = 1000;
+
+// A named, representative parameter set
+struct BenchParams {
+	std::string name;
+	ComboParams combo;
+};
+
+static std::vector<BenchParams> benchParamSets()
+{
+	std::vector<BenchParams> ret;
+
+	// Empirical strategies and foraging conditions (~90% hatch)
+	BenchParams empirical = { "empirical", { 500, 800, 500, 800, 162.0, 47.0, 7, 69.7 } };
+
+	// Low thresholds in a poor, noisy environment (~60% dead parent)
+	BenchParams highDeath = { "high-death", { 200, 400, 200, 400, 130.0, 100.0, 7, 69.7 } };
+
+	// Poor foraging and a tolerant egg, so most seasons run to the hatch limit
+	BenchParams longSeason = { "long-season", { 400, 1200, 400, 1200, 130.0, 47.0, 60, 69.7 } };
+
+	ret.push_back(empirical);
+	ret.push_back(highDeath);
+	ret.push_back(longSeason);
+	return ret;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+static void report(const std::string& bench, const std::string& params,
+				   long iterations, double seconds,
+				   long seasons, long days, long bytes)
+{
+	std::cout << "{\"bench\":\"" << bench << "\","
+			  << "\"params\":\"" << params << "\","
+			  << "\"iterations\":" << iterations << ","
+			  << "\"seconds\":" << seconds << ","
+			  << "\"seasons_per_sec\":" << seasons / seconds << ","
+			  << "\"days_per_sec\":" << days / seconds << ","
+			  << "\"bytes_per_sec\":" << bytes / seconds << "}" << std::endl;
+}
+
+static void setParents(Parent& pf, Parent& pm, const ComboParams& combo)
+{
+	pf.setMinEnergyThresh(combo.minEnergyThresh_F);
+	pf.setMaxEnergyThresh(combo.maxEnergyThresh_F);
+	pf.setForagingDistribution(combo.foragingMean, combo.foragingSD);
+	pm.setMinEnergyThresh(combo.minEnergyThresh_M);
+	pm.setMaxEnergyThresh(combo.maxEnergyThresh_M);
+	pm.setForagingDistribution(combo.foragingMean, combo.foragingSD);
+}
+
+// Parent::parentDay() alone, resetting energy so the parent never dies
+static void benchParentDay(const BenchParams& p)
+{
+	std::mt19937 randGen = std::mt19937(SEED);
+	Parent pf = Parent(Sex::female, &randGen);
+	Parent pm = Parent(Sex::male, &randGen);
+	setParents(pf, pm, p.combo);
+
+	long days = 0;
+	auto start = std::chrono::steady_clock::now();
+	while (secondsSince(start) < MIN_SECONDS) {
+		for (int i = 0; i < 100000; i++) {
+			pf.parentDay<false>();
+			if (!pf.isAlive() || pf.getEnergy() < 0) {
+				pf.setState(State::foraging);
+				pf.setEnergy(p.combo.maxEnergyThresh_F);
+			}
+		}
+		days += 100000;
+	}
+	report("Parent::parentDay", p.name, days, secondsSince(start), 0, days, 0);
+}
+
+// Egg::eggDay() alone, with the empirical ~10% neglect rate
+static void benchEggDay(const BenchParams& p)
+{
+	std::mt19937 randGen = std::mt19937(SEED);
+	std::uniform_real_distribution<double> unif(0.0, 1.0);
+	std::vector<bool> incubated(4096);
+	for (unsigned int i = 0; i < incubated.size(); i++) {
+		incubated[i] = unif(randGen) > 0.1;
+	}
+
+	long days = 0;
+	long eggs = 0;
+	auto start = std::chrono::steady_clock::now();
+	Egg egg = Egg();
+	egg.setNeglectMax(p.combo.eggTolerance);
+	while (secondsSince(start) < MIN_SECONDS) {
+		for (int i = 0; i < 100000; i++) {
+			egg.eggDay<LeachsStormPetrel>(incubated[(days + i) & 4095]);
+			if (!egg.isAlive() || egg.isHatched() || egg.getIncubationDays() > egg.getMaxHatchDays()) {
+				egg = Egg();
+				egg.setNeglectMax(p.combo.eggTolerance);
+				eggs++;
+			}
+		}
+		days += 100000;
+	}
+	report("Egg::eggDay", p.name, days, secondsSince(start), eggs, days, 0);
+}
+
+// One season of breedingSeason() or breedingSeason_oneParent() per iteration
+static void benchSeason(const BenchParams& p, bool oneParent)
+{
+	std::mt19937 randGen = std::mt19937(SEED);
+
+	long seasons = 0;
+	long days = 0;
+	auto start = std::chrono::steady_clock::now();
+	while (secondsSince(start) < MIN_SECONDS) {
+		for (int i = 0; i < 1000; i++) {
+			Egg egg = Egg();
+			egg.setNeglectMax(p.combo.eggTolerance);
+			egg.setEggCost(p.combo.eggCost);
+			Parent pf = Parent(Sex::female, &randGen);
+			Parent pm = Parent(Sex::male, &randGen);
+			setParents(pf, pm, p.combo);
+
+			if (oneParent) {
+				breedingSeason_oneParent(pf, egg);
+			} else {
+				breedingSeason(pf, pm, egg, false, &randGen);
+			}
+			days += egg.getIncubationDays();
+		}
+		seasons += 1000;
+	}
+
+	std::string bench = oneParent ? "breedingSeason_oneParent" : "breedingSeason";
+	report(bench, p.name, seasons, secondsSince(start), seasons, days, 0);
+}
+
+// A full combination of replicates as runModel() runs it, formatted into memory
+static void benchCombo(const BenchParams& p)
+{
+	std::mt19937 randGen = std::mt19937(SEED);
+
+	long combos = 0;
+	long days = 0;
+	long bytes = 0;
+	auto start = std::chrono::steady_clock::now();
+	while (secondsSince(start) < MIN_SECONDS) {
+		std::ostringstream out;
+		for (int i = 0; i < COMBO_REPLICATES; i++) {
+			SeasonResult result = simulateSeason< SeasonMode<2, false, true, false> >(p.combo, nullptr, &randGen);
+			writeSeasonRow(out, i, p.combo, result);
+			days += result.hatchDays;
+		}
+		bytes += out.tellp();
+		combos++;
+	}
+	report("combo_1000_replicates", p.name, combos, secondsSince(start),
+		   combos * COMBO_REPLICATES, days, bytes);
+}
+
+// Output formatting alone, over precomputed seasons
+static void benchFormatting(const BenchParams& p)
+{
+	std::mt19937 randGen = std::mt19937(SEED);
+	std::vector<SeasonResult> results;
+	for (int i = 0; i < COMBO_REPLICATES; i++) {
+		results.push_back(simulateSeason< SeasonMode<2, false, true, false> >(p.combo, nullptr, &randGen));
+	}
+
+	long rows = 0;
+	long bytes = 0;
+	auto start = std::chrono::steady_clock::now();
+	while (secondsSince(start) < MIN_SECONDS) {
+		std::ostringstream out;
+		for (int i = 0; i < COMBO_REPLICATES; i++) {
+			writeSeasonRow(out, i, p.combo, results[i]);
+		}
+		bytes += out.tellp();
+		rows += COMBO_REPLICATES;
+	}
+	report("writeSeasonRow", p.name, rows, secondsSince(start), rows, 0, bytes);
+}
+
+int main()
+{
+	std::vector<BenchParams> sets = benchParamSets();
+	for (unsigned int i = 0; i < sets.size(); i++) {
+		benchParentDay(sets[i]);
+		benchEggDay(sets[i]);
+		benchSeason(sets[i], false);
+		benchSeason(sets[i], true);
+		benchCombo(sets[i]);
+		benchFormatting(sets[i]);
+	}
+	return 0;
+}
@@ -0,0 +1,70 @@
+/*
+Correctness checks of the simulation core and its summaries (make check).
+
+Every check runs on a fixed seed and prints one line, "ok" or "FAILED"
+with what went wrong, and the program exits non-zero if any check
+fails, so it can gate a build. Timings live in bench/ instead.
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "../QuantileSketch.hpp"
+
+static const unsigned int SEED = 12345;
+static const int SKETCH_VALUES = 100000;
+
+static bool report(const std::string& check, bool passed)
+{
+	std::cout << check << ": " << (passed ? "ok" : "FAILED") << std::endl;
+	return passed;
+}
+
+/*
+Sketching a discrete metric (binomial counts, like days or neglect), as
+two halves merged the way sharded runs are. With fewer distinct values
+than the compression the sketch is an exact histogram, so its quantiles
+are checked against the sorted values
+@return false if a quantile isn't exact
+*/
+static bool checkSketch()
+{
+	std::mt19937 randGen = std::mt19937(SEED);
+	std::binomial_distribution<int> binomial(200, 0.3);
+	std::vector<double> values;
+	for (int i = 0; i < SKETCH_VALUES; i++) {
+		values.push_back(binomial(randGen));
+	}
+
+	const double qs[] = { 0.05, 0.25, 0.5, 0.75, 0.95 };
+	std::vector<double> sorted = values;
+	std::sort(sorted.begin(), sorted.end());
+
+	QuantileSketch sketch;
+	QuantileSketch half;
+	for (int i = 0; i < SKETCH_VALUES; i++) {
+		(i % 2 == 0 ? sketch : half).add(values[i]);
+	}
+	sketch.merge(half);
+
+	bool exact = true;
+	for (double q : qs) {
+		double expected = sorted[static_cast<std::size_t>(q * SKETCH_VALUES)];
+		if (sketch.quantile(q) != expected) {
+			std::cerr << "QuantileSketch: quantile " << q << " of binomial counts is " << sketch.quantile(q)
+			          << ", expected " << expected << std::endl;
+			exact = false;
+		}
+	}
+	return report("QuantileSketch_binomial", exact);
+}
+
+int main()
+{
+	bool passed = true;
+	passed = checkSketch() && passed;
+	return passed ? 0 : 1;
+}
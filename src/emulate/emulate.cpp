@@ -0,0 +1,506 @@
+/*
+Surrogate emulator of outcome rates (make emulate; see Emulator.hpp).
+
+Trains on results stores (store_*.bin), processed_*.csv tables or learned
+points, then either predicts every outcome's rate, with its sd and 95%
+interval, at the given parameters, or runs active learning: rounds of
+simulating a batch of points where the emulator is most uncertain (and a
+share at random, --explore), added to its training data, so error falls
+faster than by refining the grid.
+
+Usage: lhsp_emulate --train FILE [--train FILE ...] predict Column=value ...
+       lhsp_emulate --train FILE [--train FILE ...] predict - < points.csv
+       lhsp_emulate [--train FILE ...] learn --scenarios FILE --scenario NAME [--rounds R] [--batch B]
+                    [--iterations N] [--candidates C] [--explore 0.25] [--outcome Rate_Success] [--seed S]
+                    [--threads T] [--points learned_<scenario>.csv] [--species leachs]
+       lhsp_emulate --train FILE [--train FILE ...] check --scenarios FILE --scenario NAME [--points 200]
+                    [--iterations N] [--seed 1] [--threads T] [--species leachs]
+Columns are named as in sims_*.csv. Axes constant in the training data
+may be left out. With "predict -", query points are read as CSV with the
+axis columns from stdin and written back with the predictions.
+Learning prints one CSV row per round: the emulator's mean and largest sd
+over the candidates before the round, and its error at the round's batch
+(RMSE of the rate, mean |z| against the simulated rate), and rewrites the
+learned points after every round, with the species simulated (leachs,
+forkTailed or european, see Species.hpp) in their Species column.
+Checking simulates held-out points at random candidates and prints, per
+outcome, the share whose simulated counts are consistent with the
+predicted 95% interval, overall and at rates below 0.05 or above 0.95;
+it fails if any share is below 90%.
+e.g. lhsp_emulate --train store_eggCost_ms-1000iter.bin predict Foraging_Condition_Mean=155 Egg_Cost=120
+*/
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+
+#include "../Emulator.hpp"
+#include "../ScenarioFile.hpp"
+
+static void printTraining(const OutcomeEmulator& emulator, double seconds)
+{
+	std::cerr << "Trained on " << emulator.getPoints().size() << " points in " << seconds << " s";
+	for (int o = 0; o < NUM_EMULATED_OUTCOMES; o++) {
+		std::cerr << "; " << EMULATED_OUTCOMES[o] << " length scale " << emulator.getLengthScale(o)
+		          << ", signal variance " << emulator.getSignalVariance(o)
+		          << ", LOO RMSE " << emulator.getValidationError(o);
+	}
+	std::cerr << std::endl;
+}
+
+static bool train(OutcomeEmulator& emulator, bool verbose)
+{
+	auto start = std::chrono::steady_clock::now();
+	if (!emulator.train()) {
+		return false;
+	}
+	if (verbose) {
+		printTraining(emulator, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+	return true;
+}
+
+// The single value of an axis in the training data, false if it varies
+static bool constantAxis(const OutcomeEmulator& emulator, int axis, double* value)
+{
+	const std::vector<EmulatorPoint>& points = emulator.getPoints();
+	*value = points[0].x[axis];
+	for (unsigned int i = 1; i < points.size(); i++) {
+		if (points[i].x[axis] != *value) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static int predictPoint(const OutcomeEmulator& emulator, const std::vector<std::string>& args)
+{
+	double x[NUM_SCENARIO_AXES];
+	bool given[NUM_SCENARIO_AXES] = {};
+	for (unsigned int i = 0; i < args.size(); i++) {
+		std::size_t eq = args[i].find('=');
+		int axis = findScenarioAxis(args[i].substr(0, eq));
+		char* end = nullptr;
+		if (eq == std::string::npos || axis < 0 ||
+		    (x[axis] = std::strtod(args[i].c_str() + eq + 1, &end), *end != '\0' || end == args[i].c_str() + eq + 1)) {
+			std::cerr << "Could not parse " << args[i] << " (expected Column=value)" << std::endl;
+			return 1;
+		}
+		given[axis] = true;
+	}
+	for (int a = 0; a < NUM_SCENARIO_AXES; a++) {
+		if (!given[a] && !constantAxis(emulator, a, &x[a])) {
+			std::cerr << "No value for " << SCENARIO_AXES[a] << " (it varies in the training data)" << std::endl;
+			return 1;
+		}
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	EmulatorPrediction predictions[NUM_EMULATED_OUTCOMES];
+	emulator.predictAll(x, predictions);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "Outcome,Rate,SD,Low_95,High_95\n";
+	for (int o = 0; o < NUM_EMULATED_OUTCOMES; o++) {
+		std::cout << EMULATED_OUTCOMES[o] << "," << predictions[o].rate << "," << predictions[o].sd << ","
+		          << predictions[o].low << "," << predictions[o].high << "\n";
+	}
+	if (predictions[0].extrapolated) {
+		std::cerr << "Warning: the point is outside the training range" << std::endl;
+	}
+	std::cerr << "Predicted in " << seconds * 1e6 << " us" << std::endl;
+	return 0;
+}
+
+static int predictStream(const OutcomeEmulator& emulator)
+{
+	std::string line;
+	if (!std::getline(std::cin, line)) {
+		std::cerr << "Expected a CSV header on stdin" << std::endl;
+		return 1;
+	}
+	if (!line.empty() && line[line.size()-1] == '\r') {
+		line.erase(line.size() - 1);
+	}
+
+	// Columns of the axes given; the others must be constant
+	std::vector<int> axisOf;
+	bool given[NUM_SCENARIO_AXES] = {};
+	std::stringstream header(line);
+	std::string name;
+	while (std::getline(header, name, ',')) {
+		int axis = findScenarioAxis(name);
+		axisOf.push_back(axis);
+		if (axis >= 0) {
+			given[axis] = true;
+		}
+	}
+	double x[NUM_SCENARIO_AXES];
+	for (int a = 0; a < NUM_SCENARIO_AXES; a++) {
+		if (!given[a] && !constantAxis(emulator, a, &x[a])) {
+			std::cerr << "No column for " << SCENARIO_AXES[a] << " (it varies in the training data)" << std::endl;
+			return 1;
+		}
+	}
+
+	std::cout << line;
+	for (int o = 0; o < NUM_EMULATED_OUTCOMES; o++) {
+		std::cout << "," << EMULATED_OUTCOMES[o] << "," << EMULATED_OUTCOMES[o] << "_SD,"
+		          << EMULATED_OUTCOMES[o] << "_Low_95," << EMULATED_OUTCOMES[o] << "_High_95";
+	}
+	std::cout << ",Extrapolated\n";
+
+	long queries = 0;
+	double seconds = 0;
+	while (std::getline(std::cin, line)) {
+		if (!line.empty() && line[line.size()-1] == '\r') {
+			line.erase(line.size() - 1);
+		}
+		std::stringstream ss(line);
+		std::string field;
+		for (unsigned int c = 0; c < axisOf.size() && std::getline(ss, field, ','); c++) {
+			if (axisOf[c] >= 0) {
+				x[axisOf[c]] = std::atof(field.c_str());
+			}
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		EmulatorPrediction predictions[NUM_EMULATED_OUTCOMES];
+		emulator.predictAll(x, predictions);
+		seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		queries++;
+
+		std::cout << line;
+		for (int o = 0; o < NUM_EMULATED_OUTCOMES; o++) {
+			std::cout << "," << predictions[o].rate << "," << predictions[o].sd << ","
+			          << predictions[o].low << "," << predictions[o].high;
+		}
+		std::cout << "," << (predictions[0].extrapolated ? "TRUE" : "FALSE") << "\n";
+	}
+	std::cerr << queries << " points predicted, " << seconds * 1e6 / std::max(1L, queries)
+	          << " us per point (all outcomes)" << std::endl;
+	return 0;
+}
+
+// Value of an option given as --name value, or fallback
+static std::string option(const std::vector<std::string>& args, const std::string& name, const std::string& fallback)
+{
+	for (unsigned int i = 0; i + 1 < args.size(); i++) {
+		if (args[i] == name) {
+			return args[i+1];
+		}
+	}
+	return fallback;
+}
+
+/*
+The --scenarios file's --scenario, and its iterations (the scenario's,
+else the run's, else 1000)
+@return nullptr (after saying why) if there is no such scenario
+*/
+static const Scenario* findScenario(const std::vector<std::string>& args, ScenarioFile* file, std::string* iterations)
+{
+	std::string error;
+	if (!readScenarioFile(option(args, "--scenarios", ""), file, &error)) {
+		std::cerr << "Could not read scenarios: " << error << std::endl;
+		return nullptr;
+	}
+	std::string name = option(args, "--scenario", "");
+	const Scenario* scenario = nullptr;
+	for (unsigned int s = 0; s < file->scenarios.size(); s++) {
+		if (file->scenarios[s].name == name) {
+			scenario = &file->scenarios[s];
+		}
+	}
+	if (scenario == nullptr) {
+		std::cerr << "No scenario named " << name << std::endl;
+		return nullptr;
+	}
+
+	*iterations = "1000";
+	for (unsigned int i = 0; i < file->options.size(); i++) {
+		if (file->options[i].first == "iterations") {
+			*iterations = file->options[i].second;
+		}
+	}
+	if (scenario->iterations > 0) {
+		*iterations = std::to_string(scenario->iterations);
+	}
+	return scenario;
+}
+
+// Simulate a batch of candidates (see simulateLearningPoint()), points spread over the threads
+static std::vector<EmulatorPoint> simulateBatch(const std::vector<ComboParams>& candidates, const std::vector<long>& batch,
+                                                const Scenario& scenario, int iterations, uint64_t seed, int round,
+                                                int threads, SpeciesId species)
+{
+	std::vector<EmulatorPoint> simulated(batch.size());
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; t++) {
+		workers.push_back(std::thread([&, t]() {
+			for (unsigned int i = t; i < batch.size(); i += threads) {
+				simulated[i] = simulateLearningPoint(candidates[batch[i]], scenario, iterations,
+				                                     seed, round, i, species);
+			}
+		}));
+	}
+	for (unsigned int t = 0; t < workers.size(); t++) {
+		workers[t].join();
+	}
+	return simulated;
+}
+
+static int learn(OutcomeEmulator& emulator, const std::vector<std::string>& args)
+{
+	ScenarioFile file;
+	std::string iterationsDefault;
+	const Scenario* scenario = findScenario(args, &file, &iterationsDefault);
+	if (scenario == nullptr) {
+		return 1;
+	}
+
+	int rounds = std::atoi(option(args, "--rounds", "10").c_str());
+	int batchSize = std::atoi(option(args, "--batch", "20").c_str());
+	int iterations = std::atoi(option(args, "--iterations", iterationsDefault).c_str());
+	long maxCandidates = std::atol(option(args, "--candidates", "20000").c_str());
+	uint64_t seed = std::strtoull(option(args, "--seed", "0").c_str(), nullptr, 10);
+	int threads = std::atoi(option(args, "--threads", std::to_string(std::thread::hardware_concurrency())).c_str());
+	double explore = std::atof(option(args, "--explore", "0.25").c_str());
+	int outcome = findEmulatedOutcome(option(args, "--outcome", "Rate_Success"));
+	std::string pointsFile = option(args, "--points", "learned_" + scenario->name + ".csv");
+	SpeciesId species = SpeciesId::leachs;
+	if (rounds < 1 || batchSize < 1 || iterations < 1 || maxCandidates < 1 || explore < 0 || explore > 1 || outcome < 0 ||
+	    !findSpecies(option(args, "--species", "leachs"), &species)) {
+		std::cerr << "Malformed learning option" << std::endl;
+		return 1;
+	}
+	threads = std::max(1, threads);
+
+	std::mt19937 randGen(seed);
+	std::vector<ComboParams> candidates = learningCandidates(*scenario, maxCandidates, &randGen);
+	if (candidates.empty()) {
+		std::cerr << "Scenario " << scenario->name << " has no candidate points" << std::endl;
+		return 1;
+	}
+	std::cerr << candidates.size() << " candidate points; learning " << EMULATED_OUTCOMES[outcome]
+	          << " of " << speciesName(species) << " in batches of " << batchSize << " x " << iterations << " iterations" << std::endl;
+
+	std::vector<EmulatorPoint> learned;
+	std::cout << "Round,Training_Points,Mean_SD,Max_SD,Batch_RMSE,Batch_Mean_Abs_Z\n";
+	for (int round = 0; round <= rounds; round++) {
+		// Without enough data to go on, start from a random batch
+		bool trained = (int)emulator.getPoints().size() >= batchSize && train(emulator, false);
+		std::vector<long> batch;
+		std::vector<double> sds;
+		if (trained) {
+			batch = chooseLearningBatch(emulator, candidates, outcome, batchSize, explore, &randGen, &sds);
+		} else {
+			std::vector<long> order(candidates.size());
+			for (unsigned int i = 0; i < candidates.size(); i++) {
+				order[i] = i;
+			}
+			std::shuffle(order.begin(), order.end(), randGen);
+			batch.assign(order.begin(), order.begin() + std::min((long)order.size(), (long)batchSize));
+		}
+
+		std::cout << round << "," << emulator.getPoints().size() << ",";
+		if (trained) {
+			double sumSd = 0;
+			for (unsigned int i = 0; i < sds.size(); i++) {
+				sumSd += sds[i];
+			}
+			std::cout << sumSd / sds.size() << "," << *std::max_element(sds.begin(), sds.end());
+		} else {
+			std::cout << ",";
+		}
+		if (round == rounds) {
+			std::cout << ",,\n";
+			break;
+		}
+
+		std::vector<EmulatorPoint> simulated = simulateBatch(candidates, batch, *scenario, iterations, seed, round, threads,
+		                                                     species);
+
+		// Error where the emulator was least sure, before it sees the results
+		if (trained) {
+			double squaredError = 0;
+			double absZ = 0;
+			for (unsigned int i = 0; i < simulated.size(); i++) {
+				EmulatorPrediction prediction = emulator.predict(simulated[i].x, outcome);
+				double observed = simulated[i].counts[outcome] / simulated[i].n;
+				double error = prediction.rate - observed;
+				double sd = std::sqrt(prediction.sd * prediction.sd + observed * (1 - observed) / simulated[i].n);
+				squaredError += error * error;
+				absZ += std::fabs(error) / std::max(sd, 1e-12);
+			}
+			std::cout << "," << std::sqrt(squaredError / simulated.size()) << "," << absZ / simulated.size() << "\n";
+		} else {
+			std::cout << ",,\n";
+		}
+		std::cout.flush();
+
+		for (unsigned int i = 0; i < simulated.size(); i++) {
+			emulator.addPoint(simulated[i]);
+			learned.push_back(simulated[i]);
+		}
+		if (!OutcomeEmulator::writePoints(pointsFile, learned, species)) {
+			std::cerr << "Could not write " << pointsFile << std::endl;
+			return 1;
+		}
+	}
+
+	if (train(emulator, true)) {
+		std::cerr << "Learned points in " << pointsFile << std::endl;
+	}
+	return 0;
+}
+
+static const double CHECK_MIN_COVERAGE = 0.9;
+
+// P(X <= h) for X ~ Binomial(n, p)
+static double binomialCdf(double h, double n, double p)
+{
+	if (h < 0) {
+		return 0;
+	}
+	if (p <= 0 || h >= n) {
+		return 1;
+	}
+	if (p >= 1) {
+		return 0;
+	}
+	double sum = 0;
+	for (double k = 0; k <= h; k++) {
+		sum += std::exp(std::lgamma(n + 1) - std::lgamma(k + 1) - std::lgamma(n - k + 1)
+		                + k * std::log(p) + (n - k) * std::log1p(-p));
+	}
+	return std::min(sum, 1.0);
+}
+
+/*
+Simulate held-out points at random candidates and count, per outcome,
+those whose counts are consistent with the predicted 95% interval (not
+in the outer 2.5% tail of the binomial at its low or high end), over all
+points and over those with a simulated rate below 0.05 or above 0.95
+@return 1 if any coverage is below CHECK_MIN_COVERAGE
+*/
+static int check(OutcomeEmulator& emulator, const std::vector<std::string>& args)
+{
+	ScenarioFile file;
+	std::string iterationsDefault;
+	const Scenario* scenario = findScenario(args, &file, &iterationsDefault);
+	if (scenario == nullptr) {
+		return 1;
+	}
+
+	int count = std::atoi(option(args, "--points", "200").c_str());
+	int iterations = std::atoi(option(args, "--iterations", iterationsDefault).c_str());
+	uint64_t seed = std::strtoull(option(args, "--seed", "1").c_str(), nullptr, 10);
+	int threads = std::atoi(option(args, "--threads", std::to_string(std::thread::hardware_concurrency())).c_str());
+	SpeciesId species = SpeciesId::leachs;
+	if (count < 1 || iterations < 1 || !findSpecies(option(args, "--species", "leachs"), &species)) {
+		std::cerr << "Malformed check option" << std::endl;
+		return 1;
+	}
+	threads = std::max(1, threads);
+	if (!train(emulator, true)) {
+		std::cerr << "Need at least 2 training points" << std::endl;
+		return 1;
+	}
+
+	std::mt19937 randGen(seed);
+	std::vector<ComboParams> candidates = learningCandidates(*scenario, count, &randGen);
+	std::vector<long> batch(candidates.size());
+	for (unsigned int i = 0; i < candidates.size(); i++) {
+		batch[i] = i;
+	}
+	std::vector<EmulatorPoint> heldOut = simulateBatch(candidates, batch, *scenario, iterations, seed, 0, threads, species);
+
+	int failed = 0;
+	std::cout << "Outcome,Points,Coverage,Extreme_Points,Extreme_Coverage\n";
+	for (int o = 0; o < NUM_EMULATED_OUTCOMES; o++) {
+		int covered[2] = {};
+		int points[2] = {};
+		for (unsigned int i = 0; i < heldOut.size(); i++) {
+			EmulatorPrediction prediction = emulator.predict(heldOut[i].x, o);
+			double h = heldOut[i].counts[o];
+			double n = heldOut[i].n;
+			bool consistent = binomialCdf(h, n, prediction.low) >= 0.025 && 1 - binomialCdf(h - 1, n, prediction.high) >= 0.025;
+			bool extreme = h < 0.05 * n || h > 0.95 * n;
+			for (int band = 0; band < 2; band++) {
+				if (band == 0 || extreme) {
+					points[band]++;
+					covered[band] += consistent;
+				}
+			}
+		}
+		std::cout << EMULATED_OUTCOMES[o];
+		for (int band = 0; band < 2; band++) {
+			std::cout << "," << points[band] << ",";
+			if (points[band] > 0) {
+				double coverage = (double)covered[band] / points[band];
+				std::cout << coverage;
+				failed += coverage < CHECK_MIN_COVERAGE;
+			}
+		}
+		std::cout << "\n";
+	}
+	if (failed > 0) {
+		std::cerr << failed << " coverages below " << CHECK_MIN_COVERAGE << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	OutcomeEmulator emulator;
+	std::string mode;
+	std::vector<std::string> args;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (mode.empty() && arg == "--train" && i + 1 < argc) {
+			std::string fname = argv[++i];
+			std::size_t dot = fname.find_last_of('.');
+			bool loaded = dot != std::string::npos && fname.substr(dot) == ".bin" ? emulator.loadStore(fname)
+			                                                                      : emulator.loadPoints(fname);
+			if (!loaded) {
+				std::cerr << "Could not load training data from " << fname << std::endl;
+				return 1;
+			}
+		} else if (mode.empty()) {
+			mode = arg;
+		} else {
+			args.push_back(arg);
+		}
+	}
+
+	if (mode == "predict" && !args.empty()) {
+		if (!train(emulator, true)) {
+			std::cerr << "Need at least 2 training points" << std::endl;
+			return 1;
+		}
+		return args[0] == "-" ? predictStream(emulator) : predictPoint(emulator, args);
+	}
+	if (mode == "learn") {
+		return learn(emulator, args);
+	}
+	if (mode == "check") {
+		return check(emulator, args);
+	}
+
+	std::cerr << "Usage: " << argv[0] << " --train FILE [--train FILE ...] predict Column=value ...\n"
+	          << "       " << argv[0] << " --train FILE [--train FILE ...] predict - < points.csv\n"
+	          << "       " << argv[0] << " [--train FILE ...] learn --scenarios FILE --scenario NAME [--rounds R] [--batch B]\n"
+	          << "                    [--iterations N] [--candidates C] [--explore 0.25] [--outcome Rate_Success] [--seed S]\n"
+	          << "                    [--threads T] [--points learned_<scenario>.csv] [--species leachs]\n"
+	          << "       " << argv[0] << " --train FILE [--train FILE ...] check --scenarios FILE --scenario NAME [--points 200]\n"
+	          << "                    [--iterations N] [--seed 1] [--threads T] [--species leachs]" << std::endl;
+	return 1;
+}
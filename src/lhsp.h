@@ -0,0 +1,101 @@
+#pragma once
+
+/*
+C interface to the LHSP season model (liblhsp).
+
+Every call is self-contained: it seeds its own random device, touches
+no global state and writes only into caller-provided arrays, so it is
+safe to call from several threads at once and from foreign-function
+interfaces (R .C/.Call, Python ctypes/cffi with numpy buffers).
+*/
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Hatch result codes (see checkSeasonSuccess()) */
+enum {
+    LHSP_HATCHED = 0,
+    LHSP_EGG_COLD_FAIL = 1,
+    LHSP_EGG_TIME_FAIL = 2,
+    LHSP_DEAD_PARENT = 3
+};
+
+/* Species parameter packs (see Species.hpp) */
+enum {
+    LHSP_SPECIES_LEACHS = 0,
+    LHSP_SPECIES_FORK_TAILED = 1,
+    LHSP_SPECIES_EUROPEAN = 2
+};
+
+/* Error codes */
+enum {
+    LHSP_OK = 0,
+    LHSP_ERR_ARGS = -1,            /* null params/results or non-positive replicates */
+    LHSP_ERR_HISTORY_STRIDE = -2,  /* season_history given with a stride below LHSP_HISTORY_MAX */
+    LHSP_ERR_SPECIES = -3          /* unknown species code */
+};
+
+/* Longest possible season history (any species), including the terminating NUL */
+#define LHSP_HISTORY_MAX 72
+
+/* One parameter combination plus mode flags */
+typedef struct lhsp_params {
+    double min_energy_thresh_f;
+    double max_energy_thresh_f;
+    double min_energy_thresh_m;
+    double max_energy_thresh_m;
+    double foraging_mean;
+    double foraging_sd;
+    int egg_tolerance;
+    double egg_cost;
+    int one_parent;                 /* nonzero for the single-parent model */
+    int swap_sex_order;             /* nonzero for females starting to forage */
+    int species;                    /* LHSP_SPECIES_* parameter pack */
+
+    /* Optional day-indexed foraging conditions (NULL/0 for constant conditions) */
+    const double* schedule_mean_offsets;
+    const double* schedule_sd_scales;
+    int schedule_days;
+} lhsp_params;
+
+/*
+Caller-owned result columns, each with room for `replicates` entries.
+Any column may be NULL to skip it. season_history, if given, holds
+`replicates` NUL-terminated strings of history_stride bytes each.
+*/
+typedef struct lhsp_results {
+    int* hatch_result;
+    double* hatch_days;
+    int* total_neglect;
+    int* max_neglect;
+    double* end_energy_f;
+    double* mean_energy_f;
+    double* var_energy_f;
+    int* dead_f;
+    double* end_energy_m;
+    double* mean_energy_m;
+    double* var_energy_m;
+    int* dead_m;
+    char* season_history;
+    int history_stride;
+} lhsp_results;
+
+/* Fill an lhsp_params with the empirical Leach's Storm-petrel values */
+void lhsp_default_params(lhsp_params* params);
+
+/*
+Simulate `replicates` breeding seasons of one parameter combination
+@param seed seed for this call's random device
+@return LHSP_OK or a negative error code
+*/
+int lhsp_simulate(const lhsp_params* params, int replicates, uint64_t seed, lhsp_results* results);
+
+/* Printable name of a hatch result code, as in the sims_*.csv output */
+const char* lhsp_hatch_result_name(int code);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,105 @@
+#include <cstring>
+
+#include "lhsp.h"
+#include "Season.hpp"
+
+static int hatchResultCode(const std::string& hatchResult)
+{
+	if (hatchResult == "hatched") {
+		return LHSP_HATCHED;
+	} else if (hatchResult == "egg cold fail") {
+		return LHSP_EGG_COLD_FAIL;
+	} else if (hatchResult == "egg time fail") {
+		return LHSP_EGG_TIME_FAIL;
+	}
+	return LHSP_DEAD_PARENT;
+}
+
+void lhsp_default_params(lhsp_params* params)
+{
+	std::memset(params, 0, sizeof(lhsp_params));
+	params->min_energy_thresh_f = 500;
+	params->max_energy_thresh_f = 800;
+	params->min_energy_thresh_m = 500;
+	params->max_energy_thresh_m = 800;
+	params->foraging_mean = 162.0;
+	params->foraging_sd = 47.0;
+	params->egg_tolerance = 7;
+	params->egg_cost = 69.7;
+}
+
+int lhsp_simulate(const lhsp_params* params, int replicates, uint64_t seed, lhsp_results* results)
+{
+	if (params == NULL || results == NULL || replicates <= 0) {
+		return LHSP_ERR_ARGS;
+	}
+	if (results->season_history != NULL && results->history_stride < LHSP_HISTORY_MAX) {
+		return LHSP_ERR_HISTORY_STRIDE;
+	}
+
+	SpeciesId species = SpeciesId::leachs;
+	if (params->species == LHSP_SPECIES_FORK_TAILED) {
+		species = SpeciesId::forkTailed;
+	} else if (params->species == LHSP_SPECIES_EUROPEAN) {
+		species = SpeciesId::european;
+	} else if (params->species != LHSP_SPECIES_LEACHS) {
+		return LHSP_ERR_SPECIES;
+	}
+
+	ComboParams combo = ComboParams();
+	combo.minEnergyThresh_F = params->min_energy_thresh_f;
+	combo.maxEnergyThresh_F = params->max_energy_thresh_f;
+	combo.minEnergyThresh_M = params->min_energy_thresh_m;
+	combo.maxEnergyThresh_M = params->max_energy_thresh_m;
+	combo.foragingMean = params->foraging_mean;
+	combo.foragingSD = params->foraging_sd;
+	combo.eggTolerance = params->egg_tolerance;
+	combo.eggCost = params->egg_cost;
+
+	// Call-local schedule and random device keep every call reentrant
+	ForagingSchedule schedule = ForagingSchedule(1);
+	const ForagingSchedule* foragingSchedule = nullptr;
+	if (params->schedule_days > 0 && params->schedule_mean_offsets != NULL && params->schedule_sd_scales != NULL) {
+		schedule = ForagingSchedule(params->schedule_mean_offsets, params->schedule_sd_scales, params->schedule_days);
+		foragingSchedule = &schedule;
+	}
+
+	std::mt19937 randGen = std::mt19937(static_cast<std::mt19937::result_type>(seed));
+
+	for (int i = 0; i < replicates; i++) {
+		SeasonResult result = simulateSeason(combo, params->one_parent != 0, params->swap_sex_order != 0,
+		                                     foragingSchedule, &randGen, species);
+
+		if (results->hatch_result != NULL) { results->hatch_result[i] = hatchResultCode(result.hatchResult); }
+		if (results->hatch_days != NULL) { results->hatch_days[i] = result.hatchDays; }
+		if (results->total_neglect != NULL) { results->total_neglect[i] = result.totNeglect; }
+		if (results->max_neglect != NULL) { results->max_neglect[i] = result.maxNeglect; }
+		if (results->end_energy_f != NULL) { results->end_energy_f[i] = result.endEnergy_F; }
+		if (results->mean_energy_f != NULL) { results->mean_energy_f[i] = result.meanEnergy_F; }
+		if (results->var_energy_f != NULL) { results->var_energy_f[i] = result.varEnergy_F; }
+		if (results->dead_f != NULL) { results->dead_f[i] = result.dead_F; }
+		if (results->end_energy_m != NULL) { results->end_energy_m[i] = result.endEnergy_M; }
+		if (results->mean_energy_m != NULL) { results->mean_energy_m[i] = result.meanEnergy_M; }
+		if (results->var_energy_m != NULL) { results->var_energy_m[i] = result.varEnergy_M; }
+		if (results->dead_m != NULL) { results->dead_m[i] = result.dead_M; }
+
+		if (results->season_history != NULL) {
+			char* dest = results->season_history + static_cast<long>(i) * results->history_stride;
+			std::strncpy(dest, result.seasonHistory.c_str(), results->history_stride - 1);
+			dest[results->history_stride - 1] = '\0';
+		}
+	}
+
+	return LHSP_OK;
+}
+
+const char* lhsp_hatch_result_name(int code)
+{
+	switch (code) {
+		case LHSP_HATCHED: return "hatched";
+		case LHSP_EGG_COLD_FAIL: return "egg cold fail";
+		case LHSP_EGG_TIME_FAIL: return "egg time fail";
+		case LHSP_DEAD_PARENT: return "dead parent";
+	}
+	return "ERROR";
+}
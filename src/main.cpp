@@ -1,5 +1,6 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <random>
@@ -7,13 +8,165 @@
 #include <unistd.h>
 #include <ctime>
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #include "Util.hpp"
 #include "Egg.hpp"
 #include "Parent.hpp"
-
+#include "Colony.hpp"
+#include "Season.hpp"
+#include "Output.hpp"
+#include "Telemetry.hpp"
+#include "Scenario.hpp"
+#include "Equivalence.hpp"
+#include "QuantileSketch.hpp"
+#include "SimsProcessor.hpp"
+#include "SummaryTensor.hpp"
+#include "ResultsStore.hpp"
+#include "CompressedOutput.hpp"
+#include "Trajectory.hpp"
+#include "ScenarioFile.hpp"
+#include "SweepPlan.hpp"
+
+static std::string OUTPUT_DIR = "../Output/";
 static std::string OUTPUT_SUFFIX = "ms-1000iter";
 static int ITERATIONS = 1000;
+static bool RECORD_HISTORY = true;      // write the Season_History column (empty if false; see REPLAY)
+static SpeciesId SPECIES = SpeciesId::leachs;   // species parameter pack (see Species.hpp)
+
+/*
+Workers shared by every scenario of a run (0 for one per core). Scenarios
+are planned as one job (see SweepPlan.hpp); the output is the same for
+any number of workers.
+*/
+static int THREADS = 0;
+
+/*
+Write sims_*.csv.gz instead of sims_*.csv: block-compressed (BGZF, see
+CompressedOutput.hpp) on its own thread, readable by any gzip reader
+*/
+static bool COMPRESS_OUTPUT = false;
+static int COMPRESSION_LEVEL = 1;       // zlib level, 1 (fastest) to 9 (smallest)
+
+/*
+Per-combination quantile sketches of season length, neglect, energies and
+bout lengths (see QuantileSketch.hpp), written as quantile columns to
+quantiles_*.csv and, for merging shards of a sweep, as serialized
+sketches to sketches_*.csv
+*/
+static bool QUANTILE_SKETCHES = false;
+static bool SERIALIZE_SKETCHES = false;
+
+/*
+Dense summary tensors (see SummaryTensor.hpp): every processed_*.csv metric
+as an N-dimensional array over the scenario's parameter grids, written to
+tensor_*.bin for heatmaps without a group-by. Attendance and bout metrics
+need RECORD_HISTORY (NaN without it).
+*/
+static bool SUMMARY_TENSORS = false;
+
+/*
+Indexed results store (see ResultsStore.hpp): the same metrics, one row per
+combination sorted by parameters, in blocks of STORE_BLOCK_ROWS rows with
+zone maps, written to store_*.bin for range queries with query/lhsp_query
+*/
+static bool RESULTS_STORE = false;
+static int STORE_BLOCK_ROWS = 64;
+
+/*
+Daily energy trajectories (see Trajectory.hpp): both parents' energy on
+every day of sampled seasons, packed as float32 in trajectories_*.bin with
+an index of combination and iteration in trajectories_*.csv. A
+TRAJECTORY_RATE share of seasons is sampled (by replicate seed, so the
+same ones on a rerun) and kept if its Hatch_Result is in
+TRAJECTORY_OUTCOMES (any if empty). Unsampled seasons run the usual kernel.
+*/
+static bool RECORD_TRAJECTORIES = false;
+static double TRAJECTORY_RATE = 0.01;
+static std::vector<std::string> TRAJECTORY_OUTCOMES = {};  // e.g. {"dead parent"}
+
+// Runtime telemetry: JSON status file with per-scenario throughput, ETA and phase times (empty for none)
+static std::string STATUS_FILE = OUTPUT_DIR + std::string("status_") + OUTPUT_SUFFIX + std::string(".json");
+static double STATUS_INTERVAL_SECONDS = 10.0;  // minimum time between status file rewrites
+
+/*
+Base seed for the run (0 seeds from the clock). Every replicate is seeded
+from the base seed, scenario, combination and iteration, so the base seed
+printed by a run is all that is needed to replay any of its seasons.
+*/
+static uint64_t SEED = 0;
+
+/*
+Replay: instead of the sweeps, re-run a single replicate of a scenario and
+print its day-by-day trace. The combination is given by its index in the
+sweep order, or by its parameters (REPLAY_COMBO = -1). Also set from the
+command line with --replay (see parseCommandLine()).
+*/
+static bool REPLAY = false;
+static std::string REPLAY_SCENARIO = "regular";
+static long REPLAY_COMBO = -1;
+static ComboParams REPLAY_PARAMS = {500, 800, 500, 800, 162.0, 47.0, 7, 69.7};
+static int REPLAY_ITERATION = 0;
+static uint64_t REPLAY_SEED = 0;        // base seed of the run being replayed
+
+// Colony mode: simulate one large population of nests instead of the sweeps
+static bool RUN_COLONY = false;
+static long COLONY_NESTS = 1000000;
+static double COLONY_MEMORY_GB = 8.0;           // pool memory budget
+static double COLONY_SHARED_FORAGING_SD = 20.0; // shared daily foraging-quality SD (kJ)
+static double COLONY_SHARED_FORAGING_AUTOCORR = 0.7;
+static EnergyPrecision COLONY_ENERGY = EnergyPrecision::float64;   // nest pool energy representation
+
+/*
+Colony accuracy report: for every combination of a scenario, run a colony
+with each energy representation from the same seed and compare outcome
+rates and energy statistics against the float64 engine
+*/
+static bool COLONY_ACCURACY_REPORT = false;
+static std::string COLONY_ACCURACY_SCENARIO = "eggCost";
+static long COLONY_ACCURACY_NESTS = 20000;
+static double COLONY_ACCURACY_MAX_Z = 3.0;      // outcome rate differences allowed, in standard errors
+
+/*
+Equivalence report: run a reference and a candidate engine (see
+Equivalence.hpp) on every combination of a scenario from independent
+seeds, and test whether their outcome distributions match
+*/
+static bool EQUIVALENCE_REPORT = false;
+static std::string EQUIVALENCE_SCENARIO = "eggCost";
+static std::string EQUIVALENCE_REFERENCE = "reference";
+static std::string EQUIVALENCE_CANDIDATE = "specialized";
+static int EQUIVALENCE_REPLICATES = 2000;
+static double EQUIVALENCE_ALPHA = 0.01;         // chance of a false failure per combination
+static int EQUIVALENCE_BOOTSTRAP = 200;         // bootstrap resamples per interval
+
+/*
+Day-indexed foraging conditions (see ForagingSchedule.hpp), built once and
+shared by every run. Constant conditions unless a schedule file is given
+(Day,Mean_Offset,SD_Scale) or GENERATE_FORAGING_SCHEDULE is on.
+*/
+static std::string FORAGING_SCHEDULE_FILE = "";
+static bool GENERATE_FORAGING_SCHEDULE = false;
+static SeasonProfile FORAGING_SEASON_PROFILE = {
+	61,         // days
+	0.0,        // trendPerDay
+	10.0,       // seasonalAmplitude
+	0.05,       // stormRate
+	3,          // stormLength
+	60.0,       // stormDepth
+	1.5,        // stormSDScale
+	10.0,       // anomalySD
+	0.7,        // anomalyAutocorr
+	10.0,       // yearEffectSD
+	0.5         // yearEffectAutocorr
+};
 
 constexpr static double P_MIN_ENERGY_THRESH[] = {200, 1100, 100};
 constexpr static double P_MAX_ENERGY_THRESH[] = {400, 1200, 100};
@@ -27,34 +180,245 @@ constexpr static double P_FORAGING_SD[] = {0, 100, 10};
 constexpr static int P_EGG_TOLERANCE_SHIFTED[] = {1, 7, 1};
 constexpr static double P_EGG_COST_SHIFTED[] = {0, 500, 100};
 
-// Need a single, static random generator device to let us only seed once
-static std::mt19937* randGen;
-
 // Function prototypes
-void runModel(int iterations,
-	          std::string outfileName,
-	          std::vector<double> v_minEnergyThresh_f,
-	          std::vector<double> v_maxEnergyThresh_f,
-	          std::vector<double> v_minEnergyThresh_m,
-	          std::vector<double> v_maxEnergyThresh_m,
-	          std::vector<double> v_foragingMean,
-	          std::vector<double> v_foragingSD,
-			  std::vector<int> v_eggTolerance,
-			  std::vector<double> v_eggCost,
-			  bool oneParent, bool swapSexOrder);
-
-std::string breedingSeason(Parent& pf, Parent& pm, Egg& egg, bool swapSexOrder);
-std::string breedingSeason_oneParent(Parent& pf, Egg& egg);
-
-int main()
+std::vector<Scenario> buildScenarios();
+
+bool parseCommandLine(int argc, char* argv[], std::vector<Scenario>* scenarios,
+                      std::vector<int>* selected, bool* planOnly);
+
+bool applySetting(const std::string& key, const std::string& value);
+
+std::vector<SweepJob> sweepJobs(const std::vector<Scenario>& scenarios, const std::vector<int>& selected);
+
+bool runSweeps(const std::vector<Scenario>& scenarios, const std::vector<SweepJob>& jobs,
+               const std::vector<SweepTask>& tasks, int workers, uint64_t baseSeed,
+               const ForagingSchedule* foragingSchedule, Telemetry* telemetry);
+
+int runReplay(const std::vector<Scenario>& scenarios, uint64_t baseSeed, const ForagingSchedule* foragingSchedule);
+
+template <class Energy>
+void runColony(std::string outfileName, ColonyParams params, double memoryGB, std::mt19937* randGen);
+
+void runColonyAccuracy(std::string outfileName, const std::vector<Scenario>& scenarios,
+                       ColonyParams params, uint64_t baseSeed);
+
+int runEquivalence(std::string outfileName, const std::vector<Scenario>& scenarios,
+                   uint64_t baseSeed, const ForagingSchedule* foragingSchedule);
+
+/*
+Replicate loop for one parameter combination, specialized on the
+scenario's SeasonMode so the season kernel carries no mode branches.
+Each replicate is reseeded (see replicateSeed()) so it can be replayed alone.
+Simulation, formatting and file output run as separate phases over the
+whole combination, so each phase is timed once per combination.
+Seasons are added to the combination's sketches and summary (if any)
+while formatting. Seasons sampled for trajectories run the same mode with
+energy recorded, and kept ones are added to the worker's batch.
+*/
+template <class Mode>
+void runReplicates(int iterations, std::ostream& outfile, const ComboParams& combo,
+                   const ForagingSchedule* foragingSchedule,
+                   uint64_t baseSeed, int scenarioIndex, long comboIndex,
+                   TelemetryCounters* counters, ComboSketches* sketches, SimsGroup* summary,
+                   TrajectoryBatch* trajectories)
+{
+	typedef SeasonMode<Mode::NUM_PARENTS, Mode::SWAP_SEX_ORDER, Mode::RECORD_HISTORY, true,
+	                   typename Mode::SpeciesPack> RecordingMode;
+
+	auto phaseStart = std::chrono::steady_clock::now();
+	std::mt19937 randGen;
+	std::vector<SeasonResult> results;
+	results.reserve(iterations);
+	for (int i = 0; i < iterations; i++) {
+		uint64_t seed = replicateSeed(baseSeed, scenarioIndex, comboIndex, i);
+		seedReplicate(&randGen, seed);
+		if (trajectories != nullptr && trajectories->sink->sampled(seed)) {
+			TrajectoryRecord record = { comboIndex, i, combo, SeasonResult(), SeasonTrajectory() };
+			results.push_back(simulateSeason<RecordingMode>(combo, foragingSchedule, &randGen,
+			                                                nullptr, nullptr, &record.trajectory));
+			if (trajectories->sink->keeps(results[i])) {
+				record.result = results[i];
+				trajectories->records.push_back(std::move(record));
+			}
+		} else {
+			results.push_back(simulateSeason<Mode>(combo, foragingSchedule, &randGen));
+		}
+		counters->addSeason(results[i]);
+	}
+	counters->simulationSeconds += secondsSince(phaseStart);
+
+	phaseStart = std::chrono::steady_clock::now();
+	std::ostringstream rows;
+	for (int i = 0; i < iterations; i++) {
+		writeSeasonRow(rows, i, combo, results[i]);
+	}
+	if (sketches != nullptr) {
+		for (int i = 0; i < iterations; i++) {
+			sketches->addSeason(results[i]);
+		}
+	}
+	if (summary != nullptr) {
+		for (int i = 0; i < iterations; i++) {
+			summary->addSeason(results[i]);
+		}
+	}
+	std::string buffer = rows.str();
+	counters->formattingSeconds += secondsSince(phaseStart);
+
+	// Send formatted output
+	phaseStart = std::chrono::steady_clock::now();
+	outfile.write(buffer.data(), buffer.size());
+	counters->bytesWritten += buffer.size();
+	counters->ioSeconds += secondsSince(phaseStart);
+}
+
+typedef void (*ReplicateLoop)(int, std::ostream&, const ComboParams&, const ForagingSchedule*,
+                              uint64_t, int, long, TelemetryCounters*, ComboSketches*, SimsGroup*,
+                              TrajectoryBatch*);
+
+// Energy is summarized from running sums; full records only for sampled trajectories (see runReplicates())
+template <bool RecordHistory, class Species>
+ReplicateLoop replicateLoopFor(bool oneParent, bool swapSexOrder)
+{
+	if (oneParent) {
+		return runReplicates< SeasonMode<1, false, RecordHistory, false, Species> >;
+	} else if (swapSexOrder) {
+		return runReplicates< SeasonMode<2, true, RecordHistory, false, Species> >;
+	}
+	return runReplicates< SeasonMode<2, false, RecordHistory, false, Species> >;
+}
+
+template <bool RecordHistory>
+ReplicateLoop replicateLoopFor(SpeciesId species, bool oneParent, bool swapSexOrder)
+{
+	if (species == SpeciesId::forkTailed) {
+		return replicateLoopFor<RecordHistory, ForkTailedStormPetrel>(oneParent, swapSexOrder);
+	} else if (species == SpeciesId::european) {
+		return replicateLoopFor<RecordHistory, EuropeanStormPetrel>(oneParent, swapSexOrder);
+	}
+	return replicateLoopFor<RecordHistory, LeachsStormPetrel>(oneParent, swapSexOrder);
+}
+
+int main(int argc, char* argv[])
 {
     auto startTime = std::chrono::system_clock::now();
 
-	// Seed static random generator device with ridiculous C++11 things
-	auto seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-	std::mt19937 r = std::mt19937(seed);
-	randGen = &r;
+	// Scenarios (built in, or from a scenario file), which of them to run, and setting overrides
+	std::vector<Scenario> scenarios = buildScenarios();
+	std::vector<int> selected;
+	bool planOnly = false;
+	if (!parseCommandLine(argc, argv, &scenarios, &selected, &planOnly)) {
+		return 1;
+	}
+
+	// Base seed for every run, from the clock with ridiculous C++11 things unless set
+	uint64_t baseSeed = REPLAY ? REPLAY_SEED : SEED;
+	if (baseSeed == 0) {
+		baseSeed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+	}
+	std::cout << "Base seed " << baseSeed << std::endl;
+
+	// Random generator for run-wide draws (foraging schedule, colony); replicates get their own
+	std::mt19937 r = std::mt19937(static_cast<uint32_t>(baseSeed));
+	std::mt19937* randGen = &r;
+
+	// Precompute foraging conditions once, shared read-only by every run
+	ForagingSchedule* foragingSchedule = nullptr;
+	ForagingSchedule scheduleTable = ForagingSchedule(FORAGING_SEASON_PROFILE.days);
+	if (!FORAGING_SCHEDULE_FILE.empty()) {
+		std::string error;
+		if (!scheduleTable.readFile(FORAGING_SCHEDULE_FILE, &error)) {
+			std::cout << "Could not read foraging schedule: " << error << std::endl;
+			return 1;
+		}
+		foragingSchedule = &scheduleTable;
+	} else if (GENERATE_FORAGING_SCHEDULE) {
+		scheduleTable = ForagingSchedule::generate(FORAGING_SEASON_PROFILE, 0.0, randGen);
+		foragingSchedule = &scheduleTable;
+	}
+
+	if (RUN_COLONY || COLONY_ACCURACY_REPORT) {
+		ColonyParams colonyParams = ColonyParams();
+		colonyParams.numNests = COLONY_NESTS;
+		colonyParams.minEnergyThresh_F = 500;
+		colonyParams.maxEnergyThresh_F = 800;
+		colonyParams.minEnergyThresh_M = 500;
+		colonyParams.maxEnergyThresh_M = 800;
+		colonyParams.foragingMean = 162.0;
+		colonyParams.foragingSD = 47.0;
+		colonyParams.eggTolerance = 7;
+		colonyParams.eggCost = 69.7;
+		colonyParams.swapSexOrder = false;
+		colonyParams.sharedForagingSD = COLONY_SHARED_FORAGING_SD;
+		colonyParams.sharedForagingAutocorr = COLONY_SHARED_FORAGING_AUTOCORR;
+		colonyParams.foragingSchedule = foragingSchedule;
+		colonyParams.species = speciesParams(SPECIES);
+
+		if (COLONY_ACCURACY_REPORT) {
+			std::string outfileName_accuracy = OUTPUT_DIR + std::string("colonyAccuracy_") + OUTPUT_SUFFIX + std::string(".csv");
+			runColonyAccuracy(outfileName_accuracy, scenarios, colonyParams, baseSeed);
+		} else {
+			std::string outfileName_colony = OUTPUT_DIR + std::string("colony_") + OUTPUT_SUFFIX + std::string(".csv");
+			if (COLONY_ENERGY == EnergyPrecision::float32) {
+				runColony<Float32Energy>(outfileName_colony, colonyParams, COLONY_MEMORY_GB, randGen);
+			} else if (COLONY_ENERGY == EnergyPrecision::fixed32) {
+				runColony<Fixed32Energy>(outfileName_colony, colonyParams, COLONY_MEMORY_GB, randGen);
+			} else {
+				runColony<Float64Energy>(outfileName_colony, colonyParams, COLONY_MEMORY_GB, randGen);
+			}
+		}
 
+		auto endTime = std::chrono::system_clock::now();
+		std::chrono::duration<double> runTime = endTime - startTime;
+		std::cout << "Runtime in " << runTime.count() << " s." << std::endl;
+		return 0;
+	}
+
+	if (REPLAY) {
+		return runReplay(scenarios, baseSeed, foragingSchedule);
+	}
+
+	if (EQUIVALENCE_REPORT) {
+		std::string outfileName_equivalence = OUTPUT_DIR + std::string("equivalence_") + OUTPUT_SUFFIX + std::string(".csv");
+		return runEquivalence(outfileName_equivalence, scenarios, baseSeed, foragingSchedule);
+	}
+
+	// Plan the selected scenarios as one job for a shared pool of workers
+	int workers = THREADS > 0 ? THREADS : std::max(1u, std::thread::hardware_concurrency());
+	std::vector<SweepJob> jobs = sweepJobs(scenarios, selected);
+	std::vector<SweepTask> tasks = planSweeps(jobs, workers);
+	printSweepPlan(jobs, tasks, workers, std::cout);
+	if (planOnly) {
+		return 0;
+	}
+
+	// Counters and phase timers for every scenario, reported to the status file
+	Telemetry telemetry(STATUS_FILE, STATUS_INTERVAL_SECONDS);
+	if (!runSweeps(scenarios, jobs, tasks, workers, baseSeed, foragingSchedule, &telemetry)) {
+		std::cout << "Model runs aborted" << std::endl;
+		return 1;
+	}
+
+	std::cout << "Ended model runs\n";
+
+    auto endTime = std::chrono::system_clock::now();
+    std::chrono::duration<double> runTime = endTime - startTime;
+
+	// Congrats you survived! I hope the storm-petrels did too.
+	std::cout << "All model output written"
+		  	  << std::endl
+		      << "Runtime in "
+		      << runTime.count() << " s."
+	  	      << std::endl;
+	return 0;
+}
+
+/*
+The sweeps, in run order. A scenario's position in this list is part of
+every replicate's seed, so new scenarios go at the end.
+*/
+std::vector<Scenario> buildScenarios()
+{
 	// Generate a vector of parameter values from {min, max, by} arrays
 	std::vector<double> v_minEnergyThresh_full         = paramVector(P_MIN_ENERGY_THRESH);
 	std::vector<double> v_maxEnergyThresh_full         = paramVector(P_MAX_ENERGY_THRESH);
@@ -72,135 +436,404 @@ int main()
 	std::vector<double> v_eggCost_empirical            = paramVector(69.7);
 	std::vector<double> v_eggCost_shifted              = paramVector(P_EGG_COST_SHIFTED);
 
-	std::cout << "\n\n\nBeginning regular model runs\n\n\n";
-	std::string outfileName_regular = std::string("../Output/sims_regular_") + OUTPUT_SUFFIX + std::string(".csv");
-    runModel(ITERATIONS, 
-             outfileName_regular, 
-             v_minEnergyThresh_full, 
-             v_maxEnergyThresh_full, 
-             v_minEnergyThresh_full, 
-             v_maxEnergyThresh_full, 
-             v_foragingMean_full,
-			 v_foragingSD_full,
-			 v_eggTolerance_empirical, 
-			 v_eggCost_empirical,
-			 false, false);
-
-	std::cout << "\n\n\nDone with regular models.\nBeginning egg tolerance runs.\n\n\n";
-	std::string outfileName_eggTolerance = std::string("../Output/sims_eggTolerance_") + OUTPUT_SUFFIX + std::string(".csv");
-	runModel(ITERATIONS, 
-             outfileName_eggTolerance, 
-             v_minEnergyThresh_empirical, 
-             v_maxEnergyThresh_empirical, 
-             v_minEnergyThresh_empirical, 
-             v_maxEnergyThresh_empirical,
-             v_foragingMean_concentrated,
-			 v_foragingSD_empirical,
-			 v_eggTolerance_shifted,
-			 v_eggCost_empirical,
-			 false, false);
-
-	std::cout << "\n\n\nDone with egg tolerance models.\nBeginning egg cost runs.\n\n\n";
-	std::string outfileName_eggCost = std::string("../Output/sims_eggCost_") + OUTPUT_SUFFIX + std::string(".csv");
-	runModel(ITERATIONS, 
-             outfileName_eggCost, 
-             v_minEnergyThresh_empirical, 
-             v_maxEnergyThresh_empirical,
-             v_minEnergyThresh_empirical, 
-             v_maxEnergyThresh_empirical, 
-             v_foragingMean_empirical,
-			 v_foragingSD_empirical,
-			 v_eggTolerance_empirical,
-			 v_eggCost_shifted,
-			 false, false);
-
-	std::cout << "\n\n\nDone with egg cost models.\nBeginning swapped sex order model.\n\n\n";
-	std::string outfileName_swapSexOrder = std::string("../Output/sims_swapSexOrder_") + OUTPUT_SUFFIX + std::string(".csv");
-	runModel(ITERATIONS, 
-             outfileName_swapSexOrder, 
-             v_minEnergyThresh_empirical,
-             v_maxEnergyThresh_empirical,
-             v_minEnergyThresh_empirical, 
-             v_maxEnergyThresh_empirical, 
-             v_foragingMean_empirical,
-			 v_foragingSD_empirical,
-			 v_eggTolerance_empirical,
-			 v_eggCost_empirical,
-			 false, true);
-						  
-	std::cout << "\n\n\nDone with swapped sex order models.\nBeginning one parent model.\n\n\n";
-	std::string outfileName_oneParent = std::string("../Output/sims_oneParent_") + OUTPUT_SUFFIX + std::string(".csv");
 	std::vector<double> v_dummyMale_min(1, 0.0);
 	std::vector<double> v_dummyMale_max(1, 1.0);
 	static double p_foraging_mean_wider[] = {130, 400, 10};
 	std::vector<double> v_foragingMean_wider = paramVector(p_foraging_mean_wider);
-	runModel(ITERATIONS, 
-             outfileName_oneParent, 
-             v_minEnergyThresh_empirical,
-             v_maxEnergyThresh_empirical,
-             v_dummyMale_min, 
-             v_dummyMale_max, 
-             v_foragingMean_wider,
-			 v_foragingSD_empirical,
-			 v_eggTolerance_empirical,
-			 v_eggCost_empirical,
-			 true, false);
 
-	std::cout << "Ended model runs\n";
+	std::vector<Scenario> ret;
+
+	Scenario regular = { "regular",
+	                     v_minEnergyThresh_full, v_maxEnergyThresh_full,
+	                     v_minEnergyThresh_full, v_maxEnergyThresh_full,
+	                     v_foragingMean_full, v_foragingSD_full,
+	                     v_eggTolerance_empirical, v_eggCost_empirical,
+	                     false, false,
+	                     0, std::vector<ScenarioConstraint>() };
+	ret.push_back(regular);
+
+	Scenario eggTolerance = { "eggTolerance",
+	                          v_minEnergyThresh_empirical, v_maxEnergyThresh_empirical,
+	                          v_minEnergyThresh_empirical, v_maxEnergyThresh_empirical,
+	                          v_foragingMean_concentrated, v_foragingSD_empirical,
+	                          v_eggTolerance_shifted, v_eggCost_empirical,
+	                          false, false,
+	                          0, std::vector<ScenarioConstraint>() };
+	ret.push_back(eggTolerance);
+
+	Scenario eggCost = { "eggCost",
+	                     v_minEnergyThresh_empirical, v_maxEnergyThresh_empirical,
+	                     v_minEnergyThresh_empirical, v_maxEnergyThresh_empirical,
+	                     v_foragingMean_empirical, v_foragingSD_empirical,
+	                     v_eggTolerance_empirical, v_eggCost_shifted,
+	                     false, false,
+	                     0, std::vector<ScenarioConstraint>() };
+	ret.push_back(eggCost);
+
+	Scenario swapSexOrder = { "swapSexOrder",
+	                          v_minEnergyThresh_empirical, v_maxEnergyThresh_empirical,
+	                          v_minEnergyThresh_empirical, v_maxEnergyThresh_empirical,
+	                          v_foragingMean_empirical, v_foragingSD_empirical,
+	                          v_eggTolerance_empirical, v_eggCost_empirical,
+	                          false, true,
+	                          0, std::vector<ScenarioConstraint>() };
+	ret.push_back(swapSexOrder);
+
+	// Males are never simulated, so their thresholds are a single dummy pair
+	Scenario oneParent = { "oneParent",
+	                       v_minEnergyThresh_empirical, v_maxEnergyThresh_empirical,
+	                       v_dummyMale_min, v_dummyMale_max,
+	                       v_foragingMean_wider, v_foragingSD_empirical,
+	                       v_eggTolerance_empirical, v_eggCost_empirical,
+	                       true, false,
+	                       0, std::vector<ScenarioConstraint>() };
+	ret.push_back(oneParent);
+
+	return ret;
+}
 
-    auto endTime = std::chrono::system_clock::now();
-    std::chrono::duration<double> runTime = endTime - startTime;
+// Parse a setting's value; false if malformed
+static bool parseValue(const std::string& text, std::string* x)
+{
+	*x = text;
+	return true;
+}
 
-	// Congrats you survived! I hope the storm-petrels did too.
-	std::cout << "All model output written"
-		  	  << std::endl
-		      << "Runtime in "
-		      << runTime.count() << " s."
-	  	      << std::endl;
-	return 0;
+static bool parseValue(const std::string& text, bool* x)
+{
+	if (text == "true" || text == "1") {
+		*x = true;
+	} else if (text == "false" || text == "0") {
+		*x = false;
+	} else {
+		return false;
+	}
+	return true;
 }
 
-void runModel(int iterations,
-	          std::string outfileName,
-	          std::vector<double> v_minEnergyThresh_f,
-              std::vector<double> v_maxEnergyThresh_f,
-			  std::vector<double> v_minEnergyThresh_m,
-              std::vector<double> v_maxEnergyThresh_m,
-	          std::vector<double> v_foragingMean,
-			  std::vector<double> v_foragingSD,
-			  std::vector<int> v_eggTolerance,
-			  std::vector<double> v_eggCost,
-			  bool oneParent, bool swapSexOrder)
+static bool parseValue(const std::string& text, int* x)
 {
-    
-	// Start formatted output
-	std::ofstream outfile;
-	outfile.open(outfileName, std::ofstream::trunc);
+	char* end = nullptr;
+	*x = std::strtol(text.c_str(), &end, 10);
+	return !text.empty() && *end == '\0';
+}
+
+static bool parseValue(const std::string& text, long* x)
+{
+	char* end = nullptr;
+	*x = std::strtol(text.c_str(), &end, 10);
+	return !text.empty() && *end == '\0';
+}
+
+static bool parseValue(const std::string& text, uint64_t* x)
+{
+	char* end = nullptr;
+	*x = std::strtoull(text.c_str(), &end, 10);
+	return !text.empty() && *end == '\0';
+}
+
+static bool parseValue(const std::string& text, double* x)
+{
+	char* end = nullptr;
+	*x = std::strtod(text.c_str(), &end);
+	return !text.empty() && *end == '\0';
+}
+
+static bool parseValue(const std::string& text, SpeciesId* x)
+{
+	return findSpecies(text, x);
+}
+
+static bool parseValue(const std::string& text, EnergyPrecision* x)
+{
+	if (text == Float64Energy::name()) {
+		*x = EnergyPrecision::float64;
+	} else if (text == Float32Energy::name()) {
+		*x = EnergyPrecision::float32;
+	} else if (text == Fixed32Energy::name()) {
+		*x = EnergyPrecision::fixed32;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+/*
+Set one of the settings at the top of this file by its name in lower case
+(run options in scenario files, setting=value on the command line).
+Moving the output directory or suffix moves the status file with it.
+Lists (trajectory_outcomes) are comma-separated; species are named as in
+Species.hpp (leachs, forkTailed, european) and colony energy as its
+representations (float64, float32, fixed32).
+@return false if there is no such setting or the value is malformed
+*/
+bool applySetting(const std::string& key, const std::string& value)
+{
+	if (key == "output_dir" || key == "output_suffix") {
+		parseValue(value, key == "output_dir" ? &OUTPUT_DIR : &OUTPUT_SUFFIX);
+		if (!OUTPUT_DIR.empty() && OUTPUT_DIR[OUTPUT_DIR.size()-1] != '/') {
+			OUTPUT_DIR += "/";
+		}
+		if (!STATUS_FILE.empty()) {
+			STATUS_FILE = OUTPUT_DIR + std::string("status_") + OUTPUT_SUFFIX + std::string(".json");
+		}
+		return true;
+	}
+	if (key == "trajectory_outcomes") {
+		TRAJECTORY_OUTCOMES.clear();
+		std::stringstream ss(value);
+		std::string outcome;
+		while (std::getline(ss, outcome, ',')) {
+			TRAJECTORY_OUTCOMES.push_back(outcome);
+		}
+		return true;
+	}
+
+	if (key == "iterations") { return parseValue(value, &ITERATIONS) && ITERATIONS > 0; }
+	if (key == "threads") { return parseValue(value, &THREADS) && THREADS >= 0; }
+	if (key == "record_history") { return parseValue(value, &RECORD_HISTORY); }
+	if (key == "species") { return parseValue(value, &SPECIES); }
+	if (key == "seed") { return parseValue(value, &SEED); }
+	if (key == "compress_output") { return parseValue(value, &COMPRESS_OUTPUT); }
+	if (key == "compression_level") { return parseValue(value, &COMPRESSION_LEVEL) && COMPRESSION_LEVEL >= 1 && COMPRESSION_LEVEL <= 9; }
+	if (key == "quantile_sketches") { return parseValue(value, &QUANTILE_SKETCHES); }
+	if (key == "serialize_sketches") { return parseValue(value, &SERIALIZE_SKETCHES); }
+	if (key == "summary_tensors") { return parseValue(value, &SUMMARY_TENSORS); }
+	if (key == "results_store") { return parseValue(value, &RESULTS_STORE); }
+	if (key == "store_block_rows") { return parseValue(value, &STORE_BLOCK_ROWS) && STORE_BLOCK_ROWS > 0; }
+	if (key == "record_trajectories") { return parseValue(value, &RECORD_TRAJECTORIES); }
+	if (key == "trajectory_rate") { return parseValue(value, &TRAJECTORY_RATE) && TRAJECTORY_RATE >= 0 && TRAJECTORY_RATE <= 1; }
+	if (key == "status_file") { return parseValue(value, &STATUS_FILE); }
+	if (key == "status_interval_seconds") { return parseValue(value, &STATUS_INTERVAL_SECONDS); }
+	if (key == "foraging_schedule_file") { return parseValue(value, &FORAGING_SCHEDULE_FILE); }
+	if (key == "generate_foraging_schedule") { return parseValue(value, &GENERATE_FORAGING_SCHEDULE); }
+	if (key == "replay") { return parseValue(value, &REPLAY); }
+	if (key == "replay_scenario") { return parseValue(value, &REPLAY_SCENARIO); }
+	if (key == "replay_combo") { return parseValue(value, &REPLAY_COMBO) && REPLAY_COMBO >= -1; }
+	if (key == "replay_iteration") { return parseValue(value, &REPLAY_ITERATION) && REPLAY_ITERATION >= 0; }
+	if (key == "replay_seed") { return parseValue(value, &REPLAY_SEED); }
+	if (key == "run_colony") { return parseValue(value, &RUN_COLONY); }
+	if (key == "colony_nests") { return parseValue(value, &COLONY_NESTS) && COLONY_NESTS > 0; }
+	if (key == "colony_memory_gb") { return parseValue(value, &COLONY_MEMORY_GB) && COLONY_MEMORY_GB > 0; }
+	if (key == "colony_shared_foraging_sd") { return parseValue(value, &COLONY_SHARED_FORAGING_SD) && COLONY_SHARED_FORAGING_SD >= 0; }
+	if (key == "colony_shared_foraging_autocorr") {
+		return parseValue(value, &COLONY_SHARED_FORAGING_AUTOCORR) && std::fabs(COLONY_SHARED_FORAGING_AUTOCORR) <= 1;
+	}
+	if (key == "colony_energy") { return parseValue(value, &COLONY_ENERGY); }
+	if (key == "colony_accuracy_report") { return parseValue(value, &COLONY_ACCURACY_REPORT); }
+	if (key == "colony_accuracy_scenario") { return parseValue(value, &COLONY_ACCURACY_SCENARIO); }
+	if (key == "colony_accuracy_nests") { return parseValue(value, &COLONY_ACCURACY_NESTS) && COLONY_ACCURACY_NESTS > 0; }
+	if (key == "colony_accuracy_max_z") { return parseValue(value, &COLONY_ACCURACY_MAX_Z) && COLONY_ACCURACY_MAX_Z > 0; }
+	if (key == "equivalence_report") { return parseValue(value, &EQUIVALENCE_REPORT); }
+	if (key == "equivalence_scenario") { return parseValue(value, &EQUIVALENCE_SCENARIO); }
+	if (key == "equivalence_reference") { return parseValue(value, &EQUIVALENCE_REFERENCE) && findEngine(value) != nullptr; }
+	if (key == "equivalence_candidate") { return parseValue(value, &EQUIVALENCE_CANDIDATE) && findEngine(value) != nullptr; }
+	if (key == "equivalence_replicates") { return parseValue(value, &EQUIVALENCE_REPLICATES) && EQUIVALENCE_REPLICATES > 0; }
+	if (key == "equivalence_alpha") { return parseValue(value, &EQUIVALENCE_ALPHA) && EQUIVALENCE_ALPHA > 0 && EQUIVALENCE_ALPHA < 1; }
+	if (key == "equivalence_bootstrap") { return parseValue(value, &EQUIVALENCE_BOOTSTRAP) && EQUIVALENCE_BOOTSTRAP > 0; }
+	return false;
+}
+
+// Is a command-line argument one of --replay's options?
+static bool isReplayOption(const std::string& arg)
+{
+	const char* options[] = { "scenario=", "combo=", "iteration=", "seed=" };
+	for (const char* option : options) {
+		if (arg.compare(0, std::strlen(option), option) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+Command line, all optional:
+    ./lhsp [--scenarios FILE] [--run NAME,NAME...] [--plan]
+           [--replay scenario=NAME combo=N iteration=I seed=S] [setting=value ...]
+--scenarios replaces the built-in scenarios with those of a scenario file
+(see ScenarioFile.hpp) and applies its run options, --run picks the
+scenarios to run (all by default), --plan prints the plan and exits,
+--replay re-runs one replicate of a run with the printed base seed instead
+of the sweeps (see runReplay(); its options are replay_* settings), and
+setting=value (see applySetting()) overrides a setting after the file's
+@return false (after printing why) if the run should not go ahead
+*/
+bool parseCommandLine(int argc, char* argv[], std::vector<Scenario>* scenarios,
+                      std::vector<int>* selected, bool* planOnly)
+{
+	std::string scenarioFile;
+	std::string runNames;
+	std::vector<std::string> settings;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--scenarios" && i + 1 < argc) {
+			scenarioFile = argv[++i];
+		} else if (arg == "--run" && i + 1 < argc) {
+			runNames = argv[++i];
+		} else if (arg == "--plan") {
+			*planOnly = true;
+		} else if (arg == "--replay") {
+			settings.push_back("replay=true");
+			while (i + 1 < argc && isReplayOption(argv[i + 1])) {
+				settings.push_back(std::string("replay_") + argv[++i]);
+			}
+		} else if (arg.find('=') != std::string::npos && arg[0] != '-') {
+			settings.push_back(arg);
+		} else {
+			std::cout << "Usage: " << argv[0] << " [--scenarios FILE] [--run NAME,NAME...] [--plan]"
+			          << " [--replay scenario=NAME combo=N iteration=I seed=S] [setting=value ...]" << std::endl;
+			return false;
+		}
+	}
+
+	if (!scenarioFile.empty()) {
+		ScenarioFile file;
+		std::string error;
+		if (!readScenarioFile(scenarioFile, &file, &error)) {
+			std::cout << "Could not read scenarios: " << error << std::endl;
+			return false;
+		}
+		*scenarios = file.scenarios;
+		for (unsigned int i = 0; i < file.options.size(); i++) {
+			if (!applySetting(file.options[i].first, file.options[i].second)) {
+				std::cout << "Unknown setting or bad value in " << scenarioFile << ": "
+				          << file.options[i].first << " " << file.options[i].second << std::endl;
+				return false;
+			}
+		}
+	}
+	for (unsigned int i = 0; i < settings.size(); i++) {
+		std::size_t eq = settings[i].find('=');
+		if (!applySetting(settings[i].substr(0, eq), settings[i].substr(eq + 1))) {
+			std::cout << "Unknown setting or bad value: " << settings[i] << std::endl;
+			return false;
+		}
+	}
+
+	std::vector<std::string> picked;
+	std::stringstream names(runNames);
+	std::string name;
+	while (std::getline(names, name, ',')) {
+		bool found = false;
+		for (unsigned int i = 0; i < scenarios->size(); i++) {
+			found = found || (*scenarios)[i].name == name;
+		}
+		if (!found) {
+			std::cout << "No scenario named " << name << std::endl;
+			return false;
+		}
+		picked.push_back(name);
+	}
+
+	// Picked scenarios still keep their place in the list, and with it their seeds
+	selected->clear();
+	for (unsigned int i = 0; i < scenarios->size(); i++) {
+		if (picked.empty() || std::find(picked.begin(), picked.end(), (*scenarios)[i].name) != picked.end()) {
+			selected->push_back(i);
+		}
+	}
+	return true;
+}
+
+std::vector<SweepJob> sweepJobs(const std::vector<Scenario>& scenarios, const std::vector<int>& selected)
+{
+	std::vector<SweepJob> jobs;
+	for (unsigned int k = 0; k < selected.size(); k++) {
+		const Scenario& scenario = scenarios[selected[k]];
+		SweepJob job = SweepJob();
+		job.name = scenario.name;
+		job.scenarioIndex = selected[k];
+		job.combos = scenarioCombos(scenario).size();
+		job.iterations = scenario.iterations > 0 ? scenario.iterations : ITERATIONS;
+		job.numParents = scenario.oneParent ? 1 : 2;
+		jobs.push_back(job);
+	}
+	return jobs;
+}
+
+// A task's output, held until the tasks before it in its scenario are written
+struct TaskOutput {
+    long firstCombo;
+    long endCombo;
+    std::ostringstream rows;
+    std::vector<std::size_t> rowEnds;      // end of each combination's rows
+    std::vector<ComboSketches> sketches;
+    std::vector<SimsGroup> summaries;
+    std::vector<TelemetryCounters> counters;
+    TrajectoryBatch trajectories;
+};
+
+/*
+A scenario's output in a sweep run. Its files are opened when a worker
+takes its first task and closed once its last combination is written.
+Tasks are written in combination order, by whichever worker finishes the
+one next in line, so the files match a run on a single worker.
+*/
+struct SweepOutput {
+    int telemetryScenario;
+    bool opened;
+    std::string outfileName;
+    std::vector<ComboParams> combos;
+    ReplicateLoop replicateLoop;
+    bool recordTrajectories;
+
+    std::ofstream plainFile;
+    CompressedOfstream compressedFile;
+    std::ostream* outfile;
+    std::ofstream quantileFile;
+    std::ofstream sketchFile;
+    SummaryTensor tensor;
+    ResultsStoreWriter store;
+    TrajectorySink trajectories;
+
+    long nextCombo;                 // first combination not yet written
+    std::map< long, std::unique_ptr<TaskOutput> > pending;     // finished tasks, by first combination
+};
+
+// @return false if the sims_*.csv file (or the quantile and sketch files) can't be created
+static bool openSweepOutput(SweepOutput& out, const Scenario& scenario, Telemetry* telemetry)
+{
+	std::cout << "\n\n\nBeginning " << scenario.name << " model runs\n\n\n";
+	out.outfileName = OUTPUT_DIR + std::string("sims_") + scenario.name + std::string("_") + OUTPUT_SUFFIX + std::string(".csv");
+	if (COMPRESS_OUTPUT) {
+		out.outfileName += ".gz";
+	}
+
+	// Start formatted output, compressed on its own thread if asked
+	if (COMPRESS_OUTPUT) {
+		out.compressedFile.open(out.outfileName, COMPRESSION_LEVEL);
+		out.outfile = &out.compressedFile;
+	} else {
+		out.plainFile.open(out.outfileName, std::ofstream::trunc);
+		out.outfile = &out.plainFile;
+	}
+	if (!(COMPRESS_OUTPUT ? out.compressedFile.is_open() : out.plainFile.is_open())) {
+		std::cout << "Could not create output file " << out.outfileName << std::endl;
+		return false;
+	}
 
 	// Header column for CSV format
-	outfile << "Iteration" << ","
-            << "Min_Energy_Thresh_F" << ","
-			<< "Max_Energy_Thresh_F" << ","
-            << "Min_Energy_Thresh_M" << ","
-			<< "Max_Energy_Thresh_M" << ","
-			<< "Foraging_Condition_Mean" << ","
-            << "Foraging_Condition_SD" << ","
-			<< "Egg_Tolerance" << ","
-			<< "Egg_Cost" << ","
-			<< "Num_Parents" << ","
-	    	<< "Hatch_Result" << ","
-			<< "Hatch_Days" << ","
-			<< "Total_Neglect" << ","
-			<< "Max_Neglect" << ","
-			<< "End_Energy_F" << ","
-			<< "Mean_Energy_F" << ","
-			<< "Var_Energy_F" << ","
-			<< "Dead_F" << ","
-			<< "End_Energy_M" << ","
-			<< "Mean_Energy_M" << ","
-			<< "Var_Energy_M" << ","
-			<< "Dead_M" <<  ","
-            << "Season_History" << std::endl;
+	writeSeasonHeader(*out.outfile);
+
+	// Per-combination quantiles and serialized sketches
+	if (QUANTILE_SKETCHES) {
+		std::string quantileName = OUTPUT_DIR + std::string("quantiles_") + scenario.name + std::string("_") + OUTPUT_SUFFIX + std::string(".csv");
+		out.quantileFile.open(quantileName, std::ofstream::trunc);
+		if (!out.quantileFile.is_open()) {
+			std::cout << "Could not create output file " << quantileName << std::endl;
+			return false;
+		}
+		writeQuantileHeader(out.quantileFile);
+		if (SERIALIZE_SKETCHES) {
+			std::string sketchName = OUTPUT_DIR + std::string("sketches_") + scenario.name + std::string("_") + OUTPUT_SUFFIX + std::string(".csv");
+			out.sketchFile.open(sketchName, std::ofstream::trunc);
+			if (!out.sketchFile.is_open()) {
+				std::cout << "Could not create output file " << sketchName << std::endl;
+				return false;
+			}
+			writeSketchHeader(out.sketchFile);
+		}
+	}
 
 	/*
 	Total parameter space being searched
@@ -208,291 +841,638 @@ void runModel(int iterations,
 	     minEnergy [hunger] > maxEnergy [satiation],
 	     So this space is reduced to that array
 	*/
+	out.combos = scenarioCombos(scenario);
+
+	// Heatmap-ready summary tensor and results store, filled in as combinations finish
+	if (SUMMARY_TENSORS) {
+		std::string tensorName = OUTPUT_DIR + std::string("tensor_") + scenario.name + std::string("_") + OUTPUT_SUFFIX + std::string(".bin");
+		if (!out.tensor.create(tensorName, scenario, scenario.oneParent ? 1 : 2)) {
+			std::cout << "Could not create summary tensor " << tensorName << std::endl;
+		}
+	}
+	if (RESULTS_STORE) {
+		std::string storeName = OUTPUT_DIR + std::string("store_") + scenario.name + std::string("_") + OUTPUT_SUFFIX + std::string(".bin");
+		if (!out.store.create(storeName, scenario.name, out.combos, scenario.oneParent ? 1 : 2, STORE_BLOCK_ROWS)) {
+			std::cout << "Could not create results store " << storeName << std::endl;
+		}
+	}
+
+	// Sampled daily energy trajectories
+	if (RECORD_TRAJECTORIES) {
+		std::string trajectoryName = OUTPUT_DIR + std::string("trajectories_") + scenario.name + std::string("_") + OUTPUT_SUFFIX;
+		if (!out.trajectories.open(trajectoryName + std::string(".bin"), trajectoryName + std::string(".csv"),
+		                           scenario.name, TRAJECTORY_RATE, TRAJECTORY_OUTCOMES)) {
+			std::cout << "Could not create trajectory files " << trajectoryName << ".bin/.csv" << std::endl;
+		}
+	}
+	out.recordTrajectories = out.trajectories.is_open();
+
+    std::cout << "Estimated parameter combinations: " << out.combos.size() << std::endl;
+
+	telemetry->beginScenario(out.telemetryScenario);
+
+	// Pick the specialized replicate loop once for the whole scenario
+	out.replicateLoop = RECORD_HISTORY ? replicateLoopFor<true>(SPECIES, scenario.oneParent, scenario.swapSexOrder)
+	                                   : replicateLoopFor<false>(SPECIES, scenario.oneParent, scenario.swapSexOrder);
+	out.nextCombo = 0;
+	out.opened = true;
+	return true;
+}
+
+// Simulate a task's combinations into a buffer (no shared state but the scenario's read-only setup)
+static TaskOutput* runTask(const SweepOutput& out, const SweepJob& job, const SweepTask& task,
+                           uint64_t baseSeed, const ForagingSchedule* foragingSchedule)
+{
+	bool summarize = SUMMARY_TENSORS || RESULTS_STORE;
+	TaskOutput* result = new TaskOutput();
+	result->firstCombo = task.firstCombo;
+	result->endCombo = task.endCombo;
+	result->trajectories.sink = &out.trajectories;
+
+	for (long comboIndex = task.firstCombo; comboIndex < task.endCombo; comboIndex++) {
+        // Replicate every parameter combination by i iterations
+        TelemetryCounters counters = TelemetryCounters();
+        ComboSketches sketches;
+        SimsGroup summary = SimsGroup();
+        out.replicateLoop(job.iterations, result->rows, out.combos[comboIndex], foragingSchedule,
+                          baseSeed, job.scenarioIndex, comboIndex, &counters,
+                          QUANTILE_SKETCHES ? &sketches : nullptr,
+                          summarize ? &summary : nullptr,
+                          out.recordTrajectories ? &result->trajectories : nullptr);
+        result->rowEnds.push_back(result->rows.tellp());
+        result->counters.push_back(counters);
+        if (QUANTILE_SKETCHES) {
+            result->sketches.push_back(sketches);
+        }
+        if (summarize) {
+            result->summaries.push_back(summary);
+        }
+	}
+	return result;
+}
 
-    int energyCombinations = 0;
-    for (unsigned int i = 0; i < v_minEnergyThresh_f.size(); i++) {
-        for (unsigned int j = 0; j < v_maxEnergyThresh_f.size(); j++) {
-			for (unsigned int x = 0; x < v_minEnergyThresh_m.size(); x++) {
-				for (unsigned int y = 0; y < v_maxEnergyThresh_m.size(); y++) {
-            		double minThresh_f = v_minEnergyThresh_f[i];
-            		double maxThresh_f = v_maxEnergyThresh_f[j];
-            		double minThresh_m = v_minEnergyThresh_m[x];
-            		double maxThresh_m = v_maxEnergyThresh_m[y];
-            		if (maxThresh_f > minThresh_f && maxThresh_m > minThresh_m) {
-            		    energyCombinations++;
-	} } } } }
-
-	int totParamIterations = energyCombinations *
-							 v_foragingMean.size() * 
-							 v_foragingSD.size() *
-							 v_eggTolerance.size() *
-							 v_eggCost.size();
-
-    std::cout << "Estimated parameter combinations: " << totParamIterations << std::endl;
-	int currParamIteration = 0;
-
-	// For every minEnergy value (FEMALE)
-	for (unsigned int a = 0; a < v_minEnergyThresh_f.size(); a++) {
-	    double minEnergyThresh_F = v_minEnergyThresh_f[a];
-
-	// (then) for every maxEnergy value (FEMALE)
-	for (unsigned int b = 0; b < v_maxEnergyThresh_f.size(); b++) {
-		double maxEnergyThresh_F = v_maxEnergyThresh_f[b];
-
-	// (then) for every minEnergy value (MALE)
-	for (unsigned int c = 0; c < v_minEnergyThresh_m.size(); c++) {
-        double minEnergyThresh_M = v_minEnergyThresh_m[c];
-
-	// (then) for every maxEnergy value (MALE)
-	for (unsigned int d = 0; d < v_maxEnergyThresh_m.size(); d++) {
-		double maxEnergyThresh_M = v_maxEnergyThresh_m[d];
-
-	// Skip if hunger threshold >= satiation threshold(doesn't make sense!)
-	if (minEnergyThresh_F >= maxEnergyThresh_F || minEnergyThresh_M >= maxEnergyThresh_M) {
-        continue; 
-    }
-
-	// (then, then) for every foraging mean value
-	for (unsigned int e = 0; e < v_foragingMean.size(); e++) {
-		double foragingMean = v_foragingMean[e];
-    
-	for (unsigned int f = 0; f < v_foragingSD.size(); f++) {
-		double foragingSD = v_foragingSD[f];
-
-	// egg variables
-	for (unsigned int g = 0; g < v_eggTolerance.size(); g++) {
-		int eggTolerance = v_eggTolerance[g];
-
-	for (unsigned int h = 0; h < v_eggCost.size(); h++) {
-		double eggCost = v_eggCost[h];
+/*
+Write a finished task to its scenario's files (the tasks before it are
+written), flushing at the same combinations as a single worker would
+*/
+static void writeTask(SweepOutput& out, TaskOutput& task, int numParents, Telemetry* telemetry)
+{
+	auto writeStart = std::chrono::steady_clock::now();
+	std::string buffer = task.rows.str();
+
+	long totParamIterations = out.combos.size();
+	for (long comboIndex = task.firstCombo; comboIndex < task.endCombo; comboIndex++) {
+		long k = comboIndex - task.firstCombo;
+		int currParamIteration = comboIndex + 1;
 
 		// Mildly helpful progress update
-		currParamIteration++;
-		int progressStep = std::max(1, totParamIterations / 100);
+		long progressStep = std::max(1L, totParamIterations / 100);
 		if (currParamIteration % progressStep == 0) {
 			std::cout << "[ofstream flushed] Approximate progress of "
-					  << outfileName
+					  << out.outfileName
 					  << ": "
 					  << round((double)currParamIteration / totParamIterations*100) << "%" << std::endl;
-            outfile.flush();
+            out.outfile->flush();
 		}
 
-        // Replicate every parameter combination by i iterations
-        for (int i = 0; i < iterations; i++) {
-
-            // A fresh egg
-            Egg egg = Egg();
-			egg.setNeglectMax(eggTolerance);
-			egg.setEggCost(eggCost);
-
-            // Two shiny new parents
-            Parent pf = Parent(Sex::female, randGen);
-            Parent pm = Parent(Sex::male, randGen);
-
-            // Set both parent's parameters according to the new combo  
-            pf.setMinEnergyThresh(minEnergyThresh_F);
-            pf.setMaxEnergyThresh(maxEnergyThresh_F);
-            pf.setForagingDistribution(foragingMean, foragingSD);   
-            
-            pm.setMinEnergyThresh(minEnergyThresh_M);
-            pm.setMaxEnergyThresh(maxEnergyThresh_M);
-            pm.setForagingDistribution(foragingMean, foragingSD);
-
-            // Run the given breeding season model function
-			std::string seasonHistory = "";
-			if (oneParent) {
-				seasonHistory = breedingSeason_oneParent(pf, egg);
-			} else {
-            	seasonHistory = breedingSeason(pf, pm, egg, swapSexOrder);
-			}
+		std::size_t rowStart = k > 0 ? task.rowEnds[k-1] : 0;
+		out.outfile->write(buffer.data() + rowStart, task.rowEnds[k] - rowStart);
+        if (QUANTILE_SKETCHES) {
+            std::string key = comboKey(out.combos[comboIndex], numParents);
+            writeQuantileRow(out.quantileFile, key, task.sketches[k]);
+            if (SERIALIZE_SKETCHES) {
+                writeSketchRows(out.sketchFile, key, task.sketches[k]);
+            }
+        }
+        if (SUMMARY_TENSORS) {
+            out.tensor.setCell(out.combos[comboIndex], task.summaries[k]);
+        }
+        if (RESULTS_STORE) {
+            out.store.setRow(comboIndex, task.summaries[k]);
+        }
+        telemetry->comboDone(out.telemetryScenario, task.counters[k]);
+	}
+	for (unsigned int r = 0; r < task.trajectories.records.size(); r++) {
+		out.trajectories.addSeason(task.trajectories.records[r]);
+	}
 
-            // Extract output
-			std::string hatchResult = "";
-			if (oneParent) {
-				hatchResult = checkSeasonSuccess(pf, egg);
-			} else {
-				hatchResult = checkSeasonSuccess(pf, pm, egg);
-			}
+	TelemetryCounters writeCounters = TelemetryCounters();
+	writeCounters.ioSeconds = secondsSince(writeStart);
+	telemetry->comboDone(out.telemetryScenario, writeCounters, 0);
+}
 
-            double hatchDays = egg.getIncubationDays();                 // Total number of days (maybe limit)
-            int totNeglect = egg.getTotNeg();				            // Total neglect across season
-            int maxNeglect = egg.getMaxNeg();				            // Maximum neglect streak
-
-            std::vector<double> energy_F = pf.getEnergyRecord();
-			double endEnergy_F = -1;
-			double meanEnergy_F = -1;
-			double varEnergy_F = -1;
-			if (energy_F.size() > 0) {
-				endEnergy_F = energy_F[energy_F.size()-1];           // Final energy value (female)
-            	meanEnergy_F = vectorMean(energy_F);                 // Arithmetic mean energy across season (female)
-            	varEnergy_F = vectorVar(energy_F);                   // Variance in energy across season (female)
+static void closeSweepOutput(SweepOutput& out, const std::string& name, Telemetry* telemetry)
+{
+	// Close file and exit
+	auto closeStart = std::chrono::steady_clock::now();
+	out.plainFile.close();
+	if (COMPRESS_OUTPUT) {
+		if (!out.compressedFile.close()) {
+			std::cout << "Could not write all of " << out.outfileName << std::endl;
+		}
+		std::cout << "Compressed output to " << out.compressedFile.getBytesOut() << " bytes"
+		          << (compressionAvailable() ? "" : " (stored blocks: built without zlib)") << std::endl;
+	}
+	out.quantileFile.close();
+	out.sketchFile.close();
+	out.tensor.close();
+	out.store.close();
+	if (RECORD_TRAJECTORIES) {
+		long recordedSeasons = out.trajectories.getSeasons();
+		if (!out.trajectories.close()) {
+			std::cout << "Could not write all trajectories" << std::endl;
+		}
+		std::cout << "Recorded " << recordedSeasons << " energy trajectories" << std::endl;
+	}
+	TelemetryCounters closeCounters = TelemetryCounters();
+	closeCounters.ioSeconds = secondsSince(closeStart);
+	telemetry->comboDone(out.telemetryScenario, closeCounters, 0);
+	telemetry->endScenario(out.telemetryScenario);
+
+	TelemetryCounters totals = telemetry->getCounters(out.telemetryScenario);
+	std::cout << "Simulated " << totals.seasons << " seasons (" << totals.days << " days) in "
+	          << totals.simulationSeconds << " s; formatting "
+	          << totals.formattingSeconds << " s; I/O "
+	          << totals.ioSeconds << " s for " << totals.bytesWritten << " bytes" << std::endl;
+	std::cout << "Final output written to " << out.outfileName << "\n";
+	std::cout << "\n\n\nDone with " << name << " models.\n";
+}
+
+/*
+Run the planned tasks on a pool of workers. Workers take tasks in plan
+order, opening a scenario's files with its first task; whoever finishes
+the task next in line for a scenario writes it and any finished tasks
+queued behind it. Simulation runs unlocked; opening, writing and closing
+files share one lock, so console output stays in one piece.
+Phase times in the telemetry add up over workers.
+If a scenario's output file can't be created, no further tasks start.
+@return false if the sweep was aborted
+*/
+bool runSweeps(const std::vector<Scenario>& scenarios, const std::vector<SweepJob>& jobs,
+               const std::vector<SweepTask>& tasks, int workers, uint64_t baseSeed,
+               const ForagingSchedule* foragingSchedule, Telemetry* telemetry)
+{
+	std::vector<SweepOutput> outputs(jobs.size());
+	for (unsigned int j = 0; j < jobs.size(); j++) {
+		outputs[j].telemetryScenario = telemetry->addScenario(jobs[j].name, jobs[j].combos);
+		outputs[j].opened = false;
+		if (jobs[j].combos == 0) {
+			std::cout << "Scenario " << jobs[j].name << " has no combinations to run" << std::endl;
+		}
+	}
+
+	std::mutex queueLock;
+	std::mutex outputLock;
+	std::size_t nextTask = 0;
+	bool aborted = false;
+	auto worker = [&]() {
+		while (true) {
+			std::size_t t;
+			{
+				std::lock_guard<std::mutex> guard(queueLock);
+				if (nextTask >= tasks.size()) {
+					return;
+				}
+				t = nextTask++;
 			}
-            bool dead_F = !pf.isAlive();                             // Is the female alive?
-
-            std::vector<double> energy_M = pm.getEnergyRecord(); 
-			double endEnergy_M = -1;
-			double meanEnergy_M = -1;
-			double varEnergy_M = -1;
-			if (energy_M.size() > 0) {
-				endEnergy_M = energy_M[energy_M.size()-1];           // Final energy value (male)
-            	meanEnergy_M = vectorMean(energy_M);                 // Arithmetic mean energy across season (male)
-            	varEnergy_M = vectorVar(energy_M);                   // Variance in energy across season (male)
+			const SweepTask& task = tasks[t];
+			const SweepJob& job = jobs[task.job];
+			SweepOutput& out = outputs[task.job];
+			{
+				std::lock_guard<std::mutex> guard(outputLock);
+				if (!out.opened && !openSweepOutput(out, scenarios[job.scenarioIndex], telemetry)) {
+					std::lock_guard<std::mutex> queueGuard(queueLock);
+					nextTask = tasks.size();
+					aborted = true;
+					return;
+				}
 			}
-            bool dead_M = !pm.isAlive();                             // Is the male alive?
 
-			int numParents = 2;
-			if (oneParent) {
-				numParents = 1;
+			std::unique_ptr<TaskOutput> result(runTask(out, job, task, baseSeed, foragingSchedule));
+
+			std::lock_guard<std::mutex> guard(outputLock);
+			out.pending[task.firstCombo] = std::move(result);
+			while (!out.pending.empty() && out.pending.begin()->first == out.nextCombo) {
+				writeTask(out, *out.pending.begin()->second, job.numParents, telemetry);
+				out.nextCombo = out.pending.begin()->second->endCombo;
+				out.pending.erase(out.pending.begin());
+				if (out.nextCombo == (long)out.combos.size()) {
+					closeSweepOutput(out, job.name, telemetry);
+				}
 			}
-            // Send formatted output
-            outfile << i << ","
-                    << minEnergyThresh_F << ","
-                    << maxEnergyThresh_F << ","
-                    << minEnergyThresh_M << ","
-                    << maxEnergyThresh_M << ","
-                    << foragingMean << ","
-                    << foragingSD << ","
-					<< eggTolerance << ","
-					<< eggCost << ","
-					<< numParents << ","
-                    << hatchResult << ","
-                    << hatchDays << ","
-                    << totNeglect << ","
-                    << maxNeglect << ","
-                    << endEnergy_F << ","
-                    << meanEnergy_F << ","
-                    << varEnergy_F << ","
-                    << dead_F << ","
-                    << endEnergy_M << ","
-                    << meanEnergy_M << ","
-                    << varEnergy_M << ","
-                    << dead_M << ","
-                    << seasonHistory << std::endl;
-        }
-    } } } } } } } } // End parameter loops
+		}
+	};
 
-	// Close file and exit
-	outfile.close();
-	std::cout << "Final output written to " << outfileName << "\n";
+	std::vector<std::thread> pool;
+	for (int i = 0; i < workers; i++) {
+		pool.push_back(std::thread(worker));
+	}
+	for (unsigned int i = 0; i < pool.size(); i++) {
+		pool[i].join();
+	}
+	return !aborted;
 }
 
-std::string breedingSeason(Parent& pf, Parent& pm, Egg& egg, bool swapSexOrder)
+/*
+Re-run a single replicate from its scenario, combination, iteration and the
+run's base seed, printing the day-by-day trace (start of each day, then the
+final state) and the replicate's output row, which matches the sweep's row
+*/
+int runReplay(const std::vector<Scenario>& scenarios, uint64_t baseSeed, const ForagingSchedule* foragingSchedule)
 {
-    // Season history that records state at the start of each day
-    std::string seasonHistory = ""; 
-
-	// The female pays the initial cost of the egg
-	pf.setEnergy(pf.getEnergy() - egg.getEggCost());
+	int scenarioIndex = -1;
+	for (unsigned int i = 0; i < scenarios.size(); i++) {
+		if (scenarios[i].name == REPLAY_SCENARIO) {
+			scenarioIndex = i;
+		}
+	}
+	if (scenarioIndex < 0) {
+		std::cout << "No scenario named " << REPLAY_SCENARIO << std::endl;
+		return 1;
+	}
+	const Scenario& scenario = scenarios[scenarioIndex];
 
-	if (swapSexOrder) {
-		// If requested, swap females to begin foraging, and males to begin incubating
-		pf.setState(State::foraging);
-		pf.setPrevDayState(State::foraging);
-		
-		pm.setState(State::incubating);
-		pm.setPrevDayState(State::incubating);
+	std::vector<ComboParams> combos = scenarioCombos(scenario);
+	long comboIndex = REPLAY_COMBO;
+	if (comboIndex < 0) {
+		comboIndex = findCombo(combos, REPLAY_PARAMS);
+	}
+	if (comboIndex < 0 || comboIndex >= (long)combos.size()) {
+		std::cout << "No such combination in scenario " << scenario.name << std::endl;
+		return 1;
 	}
 
-	/*
-	main breeding season loop, which ticks forward in DAYS
-	Breeding season lasts until the egg hatches succesfully, or
- 	if the egg hits the hard cut-off of incubation days due to
- 	accumulated neglect
-	*/
-    while (egg.isAlive() && !egg.isHatched() && (egg.getIncubationDays() <= egg.getMaxHatchDays())) {
+	std::cout << "Replaying " << scenario.name
+	          << " combination " << comboIndex
+	          << " iteration " << REPLAY_ITERATION << "\n\n";
+
+	// The sweep's season mode, with the history recorded
+	std::mt19937 randGen;
+	seedReplicate(&randGen, replicateSeed(baseSeed, scenarioIndex, comboIndex, REPLAY_ITERATION));
+	printDailyTraceHeader(std::cout);
+	SeasonResult result = simulateSeason(combos[comboIndex],
+	                                     scenario.oneParent, scenario.swapSexOrder,
+	                                     foragingSchedule, &randGen, SPECIES, &std::cout);
+
+	std::cout << "\n";
+	writeSeasonHeader(std::cout);
+	writeSeasonRow(std::cout, REPLAY_ITERATION, combos[comboIndex], result);
+	return 0;
+}
 
-		// Check if either is incubating
-		bool incubated = false;
+template <class Energy>
+void runColony(std::string outfileName, ColonyParams params, double memoryGB, std::mt19937* randGen)
+{
+	// Refuse colonies whose nest pool would not fit in the memory budget
+	std::size_t memoryBudget = static_cast<std::size_t>(memoryGB * 1024 * 1024 * 1024);
+	long maxNests = BasicColony<Energy>::maxNests(memoryBudget);
+	std::cout << "Colony pool (" << Energy::name() << " energy) uses "
+	          << BasicColony<Energy>::bytesPerNest() << " bytes per nest; "
+	          << maxNests << " nests fit in " << memoryGB << " GB" << std::endl;
+	if (params.numNests > maxNests) {
+		std::cout << "Colony of " << params.numNests << " nests exceeds the memory budget, aborting" << std::endl;
+		return;
+	}
 
-		State femaleStartState = pf.getState();
-        State maleStartState = pm.getState();
-		        
-        // Add the daily start state to the season history
-        if (femaleStartState == State::incubating) { seasonHistory += 'F'; }
-        else if (maleStartState == State::incubating) { seasonHistory += 'M'; }
-        else { seasonHistory += 'N'; }
+	BasicColony<Energy> colony(params, randGen);
+	std::cout << "Colony of " << params.numNests << " nests allocated "
+	          << colony.memoryUsage() << " bytes ("
+	          << (double)colony.memoryUsage() / params.numNests << " per nest)" << std::endl;
 
-		// Egg behavior based on incubation
-		if (femaleStartState == State::incubating || maleStartState == State::incubating) {
-			incubated = true;
-		}
-		egg.eggDay(incubated);
+	std::ofstream outfile;
+	outfile.open(outfileName, std::ofstream::trunc);
 
-		// Parent behavior, including state change
-		pf.parentDay();
-		pm.parentDay();
+	// Header column for CSV format, one row per day
+	outfile << "Day" << ","
+	        << "Active_Nests" << ","
+	        << "Incubated_Nests" << ","
+	        << "Female_Incubating" << ","
+	        << "Male_Incubating" << ","
+	        << "Hatched" << ","
+	        << "Egg_Cold_Fail" << ","
+	        << "Egg_Time_Fail" << ","
+	        << "Dead_Parent" << ","
+	        << "Mean_Energy_F" << ","
+	        << "Mean_Energy_M" << ","
+	        << "Foraging_Quality" << std::endl;
+
+	while (colony.isActive()) {
+		ColonyDay today = colony.colonyDay();
+		outfile << today.day << ","
+		        << today.activeNests << ","
+		        << today.incubatedNests << ","
+		        << today.femaleIncubating << ","
+		        << today.maleIncubating << ","
+		        << today.hatched << ","
+		        << today.eggColdFails << ","
+		        << today.eggTimeFails << ","
+		        << today.deaths << ","
+		        << today.meanEnergy_F << ","
+		        << today.meanEnergy_M << ","
+		        << today.foragingQuality << "\n";
+	}
+	outfile.close();
 
-        State femaleState = pf.getState();
-        State maleState = pm.getState();
+	ColonySummary summary = colony.getSummary();
+	std::cout << "Colony season finished after " << colony.getDay() << " days: "
+	          << summary.hatched << " hatched, "
+	          << summary.eggColdFails << " egg cold fail, "
+	          << summary.eggTimeFails << " egg time fail, "
+	          << summary.deadParents << " dead parent. "
+	          << "Mean hatch days " << summary.meanHatchDays << ", "
+	          << "mean total neglect " << summary.meanTotalNeglect << std::endl;
+	std::cout << "Final output written to " << outfileName << "\n";
+}
 
-        if (femaleState == State::dead || maleState == State::dead) {
-            break;
-        }
+// One engine's colony season for an accuracy report row
+template <class Energy>
+ColonySummary accuracyRun(const ColonyParams& params, uint64_t seed)
+{
+	std::mt19937 randGen;
+	seedReplicate(&randGen, seed);
+	return simulateColony<Energy>(params, &randGen);
+}
 
-		if (femaleState == State::incubating && maleState == State::incubating) {
+void runColonyAccuracy(std::string outfileName, const std::vector<Scenario>& scenarios,
+                       ColonyParams params, uint64_t baseSeed)
+{
+	int scenarioIndex = -1;
+	for (unsigned int i = 0; i < scenarios.size(); i++) {
+		if (scenarios[i].name == COLONY_ACCURACY_SCENARIO) {
+			scenarioIndex = i;
+		}
+	}
+	if (scenarioIndex < 0) {
+		std::cout << "No scenario named " << COLONY_ACCURACY_SCENARIO << std::endl;
+		return;
+	}
+	// The colony engine only runs two-parent nests
+	if (scenarios[scenarioIndex].oneParent) {
+		std::cout << "Scenario " << COLONY_ACCURACY_SCENARIO
+		          << " is one-parent; the colony engine has no one-parent nests to compare" << std::endl;
+		return;
+	}
+	std::vector<ComboParams> combos = scenarioCombos(scenarios[scenarioIndex]);
+	std::cout << "Colony accuracy report over " << combos.size() << " combinations of "
+	          << scenarios[scenarioIndex].name << ", " << COLONY_ACCURACY_NESTS << " nests each" << std::endl;
 
-			State previousFemaleState = pf.getPreviousDayState();
-			State previousMaleState = pm.getPreviousDayState();
+	std::ofstream outfile;
+	outfile.open(outfileName, std::ofstream::trunc);
+	outfile << "Combo" << ","
+	        << "Min_Energy_Thresh_F" << ","
+	        << "Max_Energy_Thresh_F" << ","
+	        << "Min_Energy_Thresh_M" << ","
+	        << "Max_Energy_Thresh_M" << ","
+	        << "Foraging_Condition_Mean" << ","
+	        << "Foraging_Condition_SD" << ","
+	        << "Egg_Tolerance" << ","
+	        << "Egg_Cost" << ","
+	        << "Engine" << ","
+	        << "Hatched" << ","
+	        << "Egg_Cold_Fail" << ","
+	        << "Egg_Time_Fail" << ","
+	        << "Dead_Parent" << ","
+	        << "Mean_Hatch_Days" << ","
+	        << "Mean_Total_Neglect" << ","
+	        << "Mean_End_Energy_F" << ","
+	        << "Mean_End_Energy_M" << ","
+	        << "Max_Rate_Z" << ","
+	        << "Safe" << std::endl;
+
+	long unsafe[3] = {0, 0, 0};
+	for (unsigned int c = 0; c < combos.size(); c++) {
+		const ComboParams& combo = combos[c];
+		params.numNests = COLONY_ACCURACY_NESTS;
+		params.minEnergyThresh_F = combo.minEnergyThresh_F;
+		params.maxEnergyThresh_F = combo.maxEnergyThresh_F;
+		params.minEnergyThresh_M = combo.minEnergyThresh_M;
+		params.maxEnergyThresh_M = combo.maxEnergyThresh_M;
+		params.foragingMean = combo.foragingMean;
+		params.foragingSD = combo.foragingSD;
+		params.eggTolerance = combo.eggTolerance;
+		params.eggCost = combo.eggCost;
+		params.swapSexOrder = scenarios[scenarioIndex].swapSexOrder;
+
+		/*
+		No shared environment: its daily offsets come from the same random
+		stream as the nests, so once the engines diverge by a single draw they
+		see different environments, and each colony becomes one sample of the
+		environment rather than of its nests
+		*/
+		params.sharedForagingSD = 0;
+
+		// Every engine starts from the same seed
+		uint64_t seed = replicateSeed(baseSeed, scenarioIndex, c, 0);
+		ColonySummary engines[3] = { accuracyRun<Float64Energy>(params, seed),
+		                             accuracyRun<Float32Energy>(params, seed),
+		                             accuracyRun<Fixed32Energy>(params, seed) };
+		const char* names[3] = { Float64Energy::name(), Float32Energy::name(), Fixed32Energy::name() };
+
+		double n = COLONY_ACCURACY_NESTS;
+		for (int e = 0; e < 3; e++) {
+			ColonySummary& s = engines[e];
+			ColonySummary& ref = engines[0];
 
 			/*
-			 If the male has just returned, the female leaves
-			 If the female has just returned, the male leaves
-			 On the rare occasion where both individuals switch from
-			 foraging to incubating simultaenously in a timestep,
-			 a random parent is sent to switch
+			Largest outcome rate difference from float64, in standard errors of
+			the difference between two independent colonies of this size
 			*/
-			if (previousFemaleState == State::incubating && previousMaleState == State::foraging) {
-                pf.changeState();
-			} else if (previousMaleState == State::incubating && previousFemaleState == State::foraging) {
-				pm.changeState();
-			} else {
-				std::uniform_real_distribution<double> tieBreaker(0.0, 1.0);
-  				if (tieBreaker(*randGen) <= 0.5) {
-					pf.changeState();
-				} else {
-					pm.changeState();
+			long counts[4] = { s.hatched, s.eggColdFails, s.eggTimeFails, s.deadParents };
+			long refCounts[4] = { ref.hatched, ref.eggColdFails, ref.eggTimeFails, ref.deadParents };
+			double maxZ = 0;
+			for (int k = 0; k < 4; k++) {
+				double p = (counts[k] + refCounts[k]) / (2 * n);
+				double se = std::sqrt(2 * p * (1 - p) / n);
+				double diff = std::abs(counts[k] - refCounts[k]) / n;
+				if (se > 0) {
+					maxZ = std::max(maxZ, diff / se);
+				} else if (diff > 0) {
+					maxZ = std::max(maxZ, COLONY_ACCURACY_MAX_Z + 1);
 				}
 			}
+			bool safe = maxZ <= COLONY_ACCURACY_MAX_Z;
+			if (!safe) {
+				unsafe[e]++;
+			}
+
+			outfile << c << ","
+			        << combo.minEnergyThresh_F << ","
+			        << combo.maxEnergyThresh_F << ","
+			        << combo.minEnergyThresh_M << ","
+			        << combo.maxEnergyThresh_M << ","
+			        << combo.foragingMean << ","
+			        << combo.foragingSD << ","
+			        << combo.eggTolerance << ","
+			        << combo.eggCost << ","
+			        << names[e] << ","
+			        << s.hatched / n << ","
+			        << s.eggColdFails / n << ","
+			        << s.eggTimeFails / n << ","
+			        << s.deadParents / n << ","
+			        << s.meanHatchDays << ","
+			        << s.meanTotalNeglect << ","
+			        << s.meanEndEnergy_F << ","
+			        << s.meanEndEnergy_M << ","
+			        << maxZ << ","
+			        << safe << "\n";
 		}
 	}
+	outfile.close();
 
-    return seasonHistory;
+	std::cout << "Combinations outside " << COLONY_ACCURACY_MAX_Z << " SE of float64: "
+	          << unsafe[1] << " float32, " << unsafe[2] << " fixed32" << std::endl;
+	std::cout << "Final output written to " << outfileName << "\n";
 }
 
-std::string breedingSeason_oneParent(Parent& pf, Egg& egg)
+/*
+Run the reference and candidate engines over every combination of a
+scenario and test each combination's outcome distributions (see
+compareSeasons()). Each engine is timed, so the report also gives the
+candidate's speedup. A combination fails by chance with probability
+EQUIVALENCE_ALPHA, so the run as a whole passes unless clearly more
+combinations fail than that predicts.
+*/
+int runEquivalence(std::string outfileName, const std::vector<Scenario>& scenarios,
+                   uint64_t baseSeed, const ForagingSchedule* foragingSchedule)
 {
-    // Season history that records state at the start of each day
-    std::string seasonHistory = ""; 
-
-	// The female pays the initial cost of the egg
-	pf.setEnergy(pf.getEnergy() - egg.getEggCost());
-
-	while (egg.isAlive() && !egg.isHatched() && (egg.getIncubationDays() <= egg.getMaxHatchDays())) {
-
-        State femaleStartState = pf.getState();
-
-		// Add the daily start state to the season history
-        if (femaleStartState == State::incubating) { seasonHistory += 'F'; }
-        else { seasonHistory += 'N'; }
-
-		// Check if female is incubating
-		bool incubated = false;
-		if (femaleStartState == State::incubating) {
-			incubated = true;
+	int scenarioIndex = -1;
+	for (unsigned int i = 0; i < scenarios.size(); i++) {
+		if (scenarios[i].name == EQUIVALENCE_SCENARIO) {
+			scenarioIndex = i;
 		}
+	}
+	if (scenarioIndex < 0) {
+		std::cout << "No scenario named " << EQUIVALENCE_SCENARIO << std::endl;
+		return 1;
+	}
+	SeasonEngine reference = findEngine(EQUIVALENCE_REFERENCE);
+	SeasonEngine candidate = findEngine(EQUIVALENCE_CANDIDATE);
+	if (reference == nullptr || candidate == nullptr) {
+		std::cout << "Unknown engine " << (reference == nullptr ? EQUIVALENCE_REFERENCE : EQUIVALENCE_CANDIDATE) << std::endl;
+		return 1;
+	}
 
-		// Egg behavior based on incubation
-		egg.eggDay(incubated);
+	const Scenario& scenario = scenarios[scenarioIndex];
+	std::vector<ComboParams> combos = scenarioCombos(scenario);
+	std::cout << "Equivalence of " << EQUIVALENCE_CANDIDATE << " against " << EQUIVALENCE_REFERENCE
+	          << " over " << combos.size() << " combinations of " << scenario.name << ", "
+	          << EQUIVALENCE_REPLICATES << " replicates each" << std::endl;
 
-		// Parent behavior, including state change
-		pf.parentDay();
+	std::ofstream outfile;
+	outfile.open(outfileName, std::ofstream::trunc);
+	outfile << "Combo" << ","
+	        << "Min_Energy_Thresh_F" << ","
+	        << "Max_Energy_Thresh_F" << ","
+	        << "Min_Energy_Thresh_M" << ","
+	        << "Max_Energy_Thresh_M" << ","
+	        << "Foraging_Condition_Mean" << ","
+	        << "Foraging_Condition_SD" << ","
+	        << "Egg_Tolerance" << ","
+	        << "Egg_Cost" << ","
+	        << "Metric" << ","
+	        << "Test" << ","
+	        << "Statistic" << ","
+	        << "P_Value" << ","
+	        << "CI_Low" << ","
+	        << "CI_High" << ","
+	        << "Pass" << std::endl;
+
+	// Bootstrap resampling gets its own stream, independent of both engines
+	std::mt19937 bootGen;
+	seedReplicate(&bootGen, replicateSeed(baseSeed, scenarioIndex, -1, 0));
+
+	long failedCombos = 0;
+	double referenceSeconds = 0;
+	double candidateSeconds = 0;
+	for (unsigned int c = 0; c < combos.size(); c++) {
+		const ComboParams& combo = combos[c];
+
+		EngineJob job = EngineJob();
+		job.scenario = &scenario;
+		job.scenarioIndex = scenarioIndex;
+		job.comboIndex = c;
+		job.combo = combo;
+		job.replicates = EQUIVALENCE_REPLICATES;
+		job.foragingSchedule = foragingSchedule;
+		job.species = SPECIES;
+
+		// Independent seeds, so the tests compare two samples rather than one
+		std::vector<SeasonResult> referenceResults;
+		referenceResults.reserve(EQUIVALENCE_REPLICATES);
+		job.baseSeed = baseSeed;
+		auto phaseStart = std::chrono::steady_clock::now();
+		reference(job, referenceResults);
+		double comboReferenceSeconds = secondsSince(phaseStart);
+
+		std::vector<SeasonResult> candidateResults;
+		candidateResults.reserve(EQUIVALENCE_REPLICATES);
+		job.baseSeed = baseSeed + 1;
+		phaseStart = std::chrono::steady_clock::now();
+		candidate(job, candidateResults);
+		double comboCandidateSeconds = secondsSince(phaseStart);
+
+		if ((long)referenceResults.size() != EQUIVALENCE_REPLICATES || (long)candidateResults.size() != EQUIVALENCE_REPLICATES) {
+			std::cout << "Engine " << ((long)referenceResults.size() != EQUIVALENCE_REPLICATES ? EQUIVALENCE_REFERENCE : EQUIVALENCE_CANDIDATE)
+			          << " can't run scenario " << scenario.name << std::endl;
+			return 1;
+		}
 
-		// Check for death
-        State femaleState = pf.getState();
-        if (femaleState == State::dead) {
-            break;
-        }
+		referenceSeconds += comboReferenceSeconds;
+		candidateSeconds += comboCandidateSeconds;
+
+		std::vector<EquivalenceTest> tests = compareSeasons(referenceResults, candidateResults,
+		                                                    EQUIVALENCE_ALPHA, EQUIVALENCE_BOOTSTRAP, &bootGen);
+
+		// Speedup reported as one more row, passing trivially
+		EquivalenceTest speedup = EquivalenceTest();
+		speedup.metric = "Runtime";
+		speedup.test = "speedup";
+		speedup.statistic = comboCandidateSeconds > 0 ? comboReferenceSeconds / comboCandidateSeconds : 0;
+		speedup.pValue = -1;
+		speedup.pass = true;
+		tests.push_back(speedup);
+
+		bool comboPass = true;
+		for (unsigned int t = 0; t < tests.size(); t++) {
+			const EquivalenceTest& test = tests[t];
+			comboPass = comboPass && test.pass;
+
+			outfile << c << ","
+			        << combo.minEnergyThresh_F << ","
+			        << combo.maxEnergyThresh_F << ","
+			        << combo.minEnergyThresh_M << ","
+			        << combo.maxEnergyThresh_M << ","
+			        << combo.foragingMean << ","
+			        << combo.foragingSD << ","
+			        << combo.eggTolerance << ","
+			        << combo.eggCost << ","
+			        << test.metric << ","
+			        << test.test << ","
+			        << test.statistic << ",";
+			if (test.pValue >= 0) {
+				outfile << test.pValue << ",NA,NA,";
+			} else if (test.test == "bootstrap_mean") {
+				outfile << "NA," << test.ciLow << "," << test.ciHigh << ",";
+			} else {
+				outfile << "NA,NA,NA,";
+			}
+			outfile << test.pass << "\n";
+		}
+		if (!comboPass) {
+			failedCombos++;
+		}
 	}
+	outfile.close();
 
-    return seasonHistory;
-}
\ No newline at end of file
+	// Failures expected by chance, plus three binomial standard deviations
+	double n = combos.size();
+	double allowedFailures = EQUIVALENCE_ALPHA * n + 3 * std::sqrt(n * EQUIVALENCE_ALPHA * (1 - EQUIVALENCE_ALPHA));
+	bool pass = failedCombos <= allowedFailures;
+
+	std::cout << failedCombos << " of " << combos.size() << " combinations failed (at most "
+	          << allowedFailures << " expected by chance): " << (pass ? "PASS" : "FAIL") << std::endl;
+	std::cout << "Reference " << referenceSeconds << " s, candidate " << candidateSeconds << " s, speedup "
+	          << (candidateSeconds > 0 ? referenceSeconds / candidateSeconds : 0) << "x" << std::endl;
+	std::cout << "Final output written to " << outfileName << "\n";
+	return pass ? 0 : 1;
+}
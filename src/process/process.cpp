@@ -0,0 +1,93 @@
+/*
+Native post-processor for sims_*.csv output (make process).
+
+Writes the same processed_*.csv table as R/process_simulation_results.r
+(see SimsProcessor.hpp) in a single multi-threaded streaming pass over the
+memory-mapped file, without loading it into memory. Compressed
+sims_*.csv.gz output (COMPRESS_OUTPUT) is decompressed in parallel.
+With --merge-sketches, merges sketches_*.csv files from shards of a sweep
+instead (see QuantileSketch.hpp).
+
+Usage: lhsp_process sims_<type>_<suffix>.csv[.gz] processed_<type>.csv [threads]
+       lhsp_process --merge-sketches merged_sketches.csv merged_quantiles.csv sketches_1.csv [sketches_2.csv ...]
+*/
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+#include "../SimsProcessor.hpp"
+#include "../QuantileSketch.hpp"
+
+static const std::size_t CHUNK_BYTES = 64 * 1024 * 1024;
+
+static int mergeSketches(int argc, char** argv)
+{
+	std::vector<std::string> inFiles(argv + 4, argv + argc);
+	std::ofstream sketchOut;
+	std::ofstream quantileOut;
+	sketchOut.open(argv[2], std::ofstream::trunc);
+	quantileOut.open(argv[3], std::ofstream::trunc);
+	if (!sketchOut.is_open() || !quantileOut.is_open()) {
+		std::cout << "Could not open " << argv[2] << " or " << argv[3] << std::endl;
+		return 1;
+	}
+	if (!mergeSketchFiles(inFiles, sketchOut, quantileOut)) {
+		std::cout << "Could not merge sketches (missing file or malformed row)" << std::endl;
+		return 1;
+	}
+	std::cout << "Merged " << inFiles.size() << " sketch files into " << argv[2] << " and " << argv[3] << "\n";
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc > 4 && std::string(argv[1]) == "--merge-sketches") {
+		return mergeSketches(argc, argv);
+	}
+	if (argc < 3) {
+		std::cout << "Usage: " << argv[0] << " sims_<type>_<suffix>.csv[.gz] processed_<type>.csv [threads]\n"
+		          << "       " << argv[0] << " --merge-sketches merged_sketches.csv merged_quantiles.csv sketches_1.csv [sketches_2.csv ...]" << std::endl;
+		return 1;
+	}
+	std::string inFile = argv[1];
+	std::string outFile = argv[2];
+	int threads = std::thread::hardware_concurrency();
+	if (argc > 3) {
+		threads = std::atoi(argv[3]);
+	}
+	if (threads < 1) {
+		threads = 1;
+	}
+
+	std::ofstream out;
+	out.open(outFile, std::ofstream::trunc);
+	if (!out.is_open()) {
+		std::cout << "Could not open " << outFile << std::endl;
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	ProcessStats stats;
+	bool ok = processSimsFile(inFile, out, threads, CHUNK_BYTES, &stats);
+	out.close();
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	if (!ok) {
+		std::cout << "Could not process " << inFile
+		          << " (missing file, missing column or malformed row)" << std::endl;
+		return 1;
+	}
+	if (stats.repeatedKeys > 0) {
+		std::cout << "Warning: " << stats.repeatedKeys << " combinations reappear after other rows"
+		          << " and are summarized in more than one row" << std::endl;
+	}
+	std::cout << "Processed " << stats.rows << " rows into " << stats.groups << " combinations ("
+	          << stats.bytes << " bytes, " << threads << " threads) in " << elapsed.count() << " s" << std::endl;
+	std::cout << "Final output written to " << outFile << "\n";
+	return 0;
+}
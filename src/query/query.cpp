@@ -0,0 +1,71 @@
+/*
+Range queries over a results store written with RESULTS_STORE (make query).
+
+Prints the matching rows as CSV, reading only the blocks whose zone maps
+(see ResultsStore.hpp) don't rule them out, and reports how many blocks
+were read.
+
+Usage: lhsp_query store_<type>_<suffix>.bin [--columns Col1,Col2,...] [predicate ...]
+Predicates: Column=value, Column=low:high, Column>=value, Column>value,
+            Column<=value, Column<value (all must hold)
+e.g. lhsp_query store_regular_ms-1000iter.bin --columns Foraging_Condition_Mean,Egg_Tolerance,Rate_Success \
+         Foraging_Condition_Mean=150:170 Egg_Tolerance>=5
+*/
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../ResultsStore.hpp"
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " store_<type>_<suffix>.bin [--columns Col1,Col2,...] [predicate ...]" << std::endl;
+		return 1;
+	}
+
+	ResultsStore store;
+	if (!store.open(argv[1])) {
+		std::cerr << "Could not open results store " << argv[1] << std::endl;
+		return 1;
+	}
+
+	// Every column unless projected
+	std::vector<int> projection;
+	for (unsigned int c = 0; c < store.getColumns().size(); c++) {
+		projection.push_back(c);
+	}
+
+	std::vector<StorePredicate> predicates;
+	for (int i = 2; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--columns" && i + 1 < argc) {
+			projection.clear();
+			std::stringstream ss(argv[++i]);
+			std::string name;
+			while (std::getline(ss, name, ',')) {
+				int column = store.findColumn(name);
+				if (column < 0) {
+					std::cerr << "No column named " << name << std::endl;
+					return 1;
+				}
+				projection.push_back(column);
+			}
+			continue;
+		}
+		StorePredicate predicate;
+		if (!store.parsePredicate(arg, &predicate)) {
+			std::cerr << "Could not parse predicate " << arg << std::endl;
+			return 1;
+		}
+		predicates.push_back(predicate);
+	}
+
+	StoreQueryStats stats;
+	store.query(predicates, projection, std::cout, &stats);
+	std::cerr << stats.rowsMatched << " rows matched; read " << stats.blocksRead << " of "
+	          << stats.blocks << " blocks (" << stats.rowsRead << " rows)" << std::endl;
+	return 0;
+}